@@ -12,10 +12,12 @@ BreakpointDialog::BreakpointDialog(const MemoryLayout& ml, DebugSession* session
 	debugSession = session;
 	if (session) {
 		// create address completer
-		jumpCompleter = std::make_unique<QCompleter>(session->symbolTable().labelList(), this);
-		allCompleter = std::make_unique<QCompleter>(session->symbolTable().labelList(true), this);
-		jumpCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-		allCompleter->setCaseSensitivity(Qt::CaseInsensitive);
+		jumpCompleter = std::make_unique<SymbolCompleter>(session->symbolTable(), false, nullptr, this);
+		allCompleter = std::make_unique<SymbolCompleter>(session->symbolTable(), true, nullptr, this);
+		for (auto* edit : {edtAddress, edtAddressRange}) {
+			jumpCompleter->watch(edit);
+			allCompleter->watch(edit);
+		}
 		connect(jumpCompleter.get(), qOverload<const QString&>(&QCompleter::activated), this, &BreakpointDialog::addressChanged);
 		connect(allCompleter.get(),  qOverload<const QString&>(&QCompleter::activated), this, &BreakpointDialog::addressChanged);
 	}
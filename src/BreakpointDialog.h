@@ -3,7 +3,7 @@
 
 #include "ui_BreakpointDialog.h"
 #include "DebuggerData.h"
-#include <QCompleter>
+#include "SymbolCompleter.h"
 #include <QDialog>
 #include <memory>
 
@@ -44,8 +44,8 @@ private:
 	Symbol* currentSymbol;
 	int idxSlot, idxSubSlot;
 	int conditionHeight;
-	std::unique_ptr<QCompleter> jumpCompleter;
-	std::unique_ptr<QCompleter> allCompleter;
+	std::unique_ptr<SymbolCompleter> jumpCompleter;
+	std::unique_ptr<SymbolCompleter> allCompleter;
 };
 
 #endif // BREAKPOINTDIALOG_OPENMSX_H
@@ -11,6 +11,7 @@
 #include <QMessageBox>
 #include <QToolTip>
 #include <QComboBox>
+#include <QSet>
 #include <cassert>
 
 static constexpr int UNDEFINED_ROW = -1;
@@ -24,6 +25,9 @@ enum TableColumns {
 	SEGMENT = 5,
 	BREAKPOINT_ID = 6,
 	ADDRESS = 7,
+	TRACE = 8,
+	HITS = 9,
+	RECORD = 10,
 };
 
 static QString locationString(const AddressRange& range, int adrLen)
@@ -53,6 +57,7 @@ BreakpointViewer::BreakpointViewer(DebugSession& session, QWidget* parent)
 	bpTableWidget->setColumnHidden(WP_TYPE, true);
 	bpTableWidget->setColumnHidden(BREAKPOINT_ID, true);
 	bpTableWidget->setColumnHidden(ADDRESS, true);
+	bpTableWidget->setColumnHidden(RECORD, true);
 	bpTableWidget->resizeColumnsToContents();
 	bpTableWidget->setSortingEnabled(true);
 	connect(bpTableWidget, &QTableWidget::itemPressed, this, &BreakpointViewer::on_itemPressed);
@@ -76,6 +81,7 @@ BreakpointViewer::BreakpointViewer(DebugSession& session, QWidget* parent)
 	cnTableWidget->setColumnHidden(SLOT, true);
 	cnTableWidget->setColumnHidden(SEGMENT, true);
 	cnTableWidget->setColumnHidden(ADDRESS, true);
+	cnTableWidget->setColumnHidden(RECORD, true);
 	cnTableWidget->sortByColumn(T_CONDITION, Qt::AscendingOrder);
 	cnTableWidget->resizeColumnsToContents();
 	cnTableWidget->setSortingEnabled(true);
@@ -142,7 +148,9 @@ void BreakpointViewer::_createBreakpoint(BreakpointType type, int row)
 	QString condition = table->item(row, T_CONDITION)->text();
 	auto slot = parseSlotField({}, table->item(row, SLOT)->text());
 	auto segment = parseSegmentField({}, table->item(row, SEGMENT)->text());
-	const QString cmdStr = Breakpoints::createSetCommand(wtype, range, slot, segment, condition);
+	QString trace = table->item(row, TRACE)->text();
+	bool record = table->item(row, RECORD)->checkState() == Qt::Checked;
+	const QString cmdStr = Breakpoints::createSetCommand(wtype, range, slot, segment, condition, trace, record);
 
 	auto* command = new Command(cmdStr,
 		[=] (const QString& id) {
@@ -198,10 +206,11 @@ void BreakpointViewer::removeBreakpoint(BreakpointType type, int row, bool remov
 
 	auto* command = new Command(cmdStr,
 		[=] (const QString& /*result*/) {
-			if (removeLocal) {
+			// the update from openMSX can already have removed the row
+			if (auto current = findBreakpointRow(type, id); removeLocal && current) {
 				auto* table = tables[type];
 				auto     sa = ScopedAssign(userMode, false);
-				table->removeRow(row);
+				table->removeRow(*current);
 			}
 			emit contentsUpdated();
 		},
@@ -222,7 +231,8 @@ void BreakpointViewer::_createCondition(int row)
 	} else {
 		setBreakpointChecked(BreakpointType::CONDITION, row, Qt::Checked);
 	}
-	const QString cmdStr = Breakpoints::createSetCommand(Breakpoint::CONDITION, {}, {}, {}, condition);
+	QString trace = cnTableWidget->item(row, TRACE)->text();
+	const QString cmdStr = Breakpoints::createSetCommand(Breakpoint::CONDITION, {}, {}, {}, condition, trace);
 
 	auto* command = new Command(cmdStr,
 		[=] (const QString& id) {
@@ -442,7 +452,16 @@ void BreakpointViewer::changeTableItem(BreakpointType type, QTableWidgetItem* it
 			if (!enabled) return;
 			break;
 		}
+		case TRACE: {
+			setTextField(type, row, TRACE, item->text().simplified());
+			if (!enabled) return;
+			break;
+		}
+		case RECORD:
+			if (!enabled) return;
+			break;
 		case BREAKPOINT_ID:
+		case HITS:
 			return;
 		default:
 			qWarning() << "Unknown table column" << table->column(item);
@@ -553,6 +572,41 @@ std::optional<int> BreakpointViewer::findBreakpointRow(BreakpointType type, cons
 	return {};
 }
 
+QHash<QString, int> BreakpointViewer::rowsById(BreakpointType type) const
+{
+	auto* table = tables[type];
+
+	QHash<QString, int> rows;
+	rows.reserve(table->rowCount());
+	for (int row = 0; row < table->rowCount(); ++row) {
+		const QString& id = table->item(row, BREAKPOINT_ID)->text();
+		if (!id.isEmpty()) rows.insert(id, row);
+	}
+	return rows;
+}
+
+static BreakpointType viewerType(Breakpoint::Type type)
+{
+	return type == Breakpoint::BREAKPOINT ? BreakpointType::BREAKPOINT
+	     : (type == Breakpoint::CONDITION ? BreakpointType::CONDITION
+	     : BreakpointType::WATCHPOINT);
+}
+
+void BreakpointViewer::updateBreakpointRow(int bpIndex, const QHash<QString, int>* rows)
+{
+	const Breakpoint& bp = breakpoints->getBreakpoint(bpIndex);
+	BreakpointType type = viewerType(bp.type);
+
+	if (auto row = rows[type].find(bp.id); row != rows[type].end()) {
+		auto sa = ScopedAssign(userMode, false);
+		refreshTableRow(bpIndex, type, *row);
+	} else {
+		// new breakpoints created on OpenMSX will go through here
+		auto row = createTableRow(type);
+		fillTableRow(type, row, bpIndex);
+	}
+}
+
 void BreakpointViewer::refreshTableRow(int bpIndex, BreakpointType type, int row)
 {
 	bool preserveSymbol = Settings::get().preserveBreakpointSymbol();
@@ -590,22 +644,16 @@ void BreakpointViewer::refresh()
 	// store unused items position by disabling ordering
 	disableSorting();
 
+	// new rows are appended, so the existing ones keep their position
+	QHash<QString, int> rows[BreakpointType::ALL];
+	for (const auto& type : {BreakpointType::BREAKPOINT, BreakpointType::WATCHPOINT, BreakpointType::CONDITION}) {
+		rows[type] = rowsById(type);
+	}
+	QSet<QString> ids;
+	ids.reserve(breakpoints->breakpointCount());
 	for (int bpIndex = 0; bpIndex < breakpoints->breakpointCount(); ++bpIndex) {
-		const Breakpoint& bp = breakpoints->getBreakpoint(bpIndex);
-
-		BreakpointType type = bp.type == Breakpoint::BREAKPOINT ? BreakpointType::BREAKPOINT
-		                    : (bp.type == Breakpoint::CONDITION  ? BreakpointType::CONDITION 
-		                    : BreakpointType::WATCHPOINT);
-		auto row = findBreakpointRow(type, bp.id);
-
-		if (row) {
-			auto sa = ScopedAssign(userMode, false);
-			refreshTableRow(bpIndex, type, *row);
-		} else {
-			// new breakpoints created on OpenMSX will go through here
-			auto row = createTableRow(type);
-			fillTableRow(type, row, bpIndex);
-		}
+		ids.insert(breakpoints->getBreakpoint(bpIndex).id);
+		updateBreakpointRow(bpIndex, rows);
 	}
 
 	// remove remaining unpaired BreakpointRef whose breakpoints were replaced or deleted
@@ -613,8 +661,8 @@ void BreakpointViewer::refresh()
 		const auto& table = tables[type];
 		for (int row = 0; row < table->rowCount();) {
 			auto* item = table->item(row, ENABLED);
-			auto  bpIndex = findBreakpointIndex(type, row);
-			if (item->checkState() == Qt::Checked && !bpIndex) {
+			if (item->checkState() == Qt::Checked &&
+			    !ids.contains(table->item(row, BREAKPOINT_ID)->text())) {
 				table->removeRow(row);
 				continue;
 			}
@@ -625,6 +673,59 @@ void BreakpointViewer::refresh()
 	stretchTable(BreakpointType::ALL);
 }
 
+void BreakpointViewer::onBreakpointsAdded(const QStringList& ids)
+{
+	// don't update if self-inflicted update
+	if (disableRefresh) return;
+
+	disableSorting();
+
+	QHash<QString, int> rows[BreakpointType::ALL];
+	for (const auto& type : {BreakpointType::BREAKPOINT, BreakpointType::WATCHPOINT, BreakpointType::CONDITION}) {
+		rows[type] = rowsById(type);
+	}
+	QSet<QString> added(ids.begin(), ids.end());
+	for (int bpIndex = 0; bpIndex < breakpoints->breakpointCount(); ++bpIndex) {
+		if (added.contains(breakpoints->getBreakpoint(bpIndex).id)) {
+			updateBreakpointRow(bpIndex, rows);
+		}
+	}
+
+	stretchTable(BreakpointType::ALL);
+}
+
+void BreakpointViewer::onBreakpointRemoved(const QString& id)
+{
+	// a replaced breakpoint keeps its row
+	if (disableRefresh) return;
+
+	BreakpointType type = id.startsWith("bp#") ? BreakpointType::BREAKPOINT
+	                    : (id.startsWith("cond#") ? BreakpointType::CONDITION
+	                    : BreakpointType::WATCHPOINT);
+	auto row = findBreakpointRow(type, id);
+	if (!row) return;
+
+	// disabled breakpoints keep their row
+	auto* table = tables[type];
+	if (table->item(*row, ENABLED)->checkState() != Qt::Checked) return;
+
+	auto sa = ScopedAssign(userMode, false);
+	table->removeRow(*row);
+}
+
+void BreakpointViewer::refreshHits()
+{
+	auto sa = ScopedAssign(userMode, false);
+	for (int bpIndex = 0; bpIndex < breakpoints->breakpointCount(); ++bpIndex) {
+		const auto& bp = breakpoints->getBreakpoint(bpIndex);
+		if (bp.trace.isEmpty()) continue;
+		BreakpointType type = viewerType(bp.type);
+		if (auto row = findBreakpointRow(type, bp.id)) {
+			setTextField(type, *row, HITS, QString::number(breakpoints->traceHits(bp)));
+		}
+	}
+}
+
 void BreakpointViewer::changeCurrentWpType(int row, int /*selected*/)
 {
 	if (!userMode) return;
@@ -727,6 +828,25 @@ int BreakpointViewer::createTableRow(BreakpointType type, int row)
 	item7->setText("");
 	table->setItem(row, ADDRESS, item7);
 
+	// trace expression
+	auto* item8 = new QTableWidgetItem();
+	item8->setTextAlignment(Qt::AlignCenter);
+	item8->setText("");
+	table->setItem(row, TRACE, item8);
+
+	// trace hits
+	auto* item9 = new QTableWidgetItem();
+	item9->setFlags(Qt::ItemIsEnabled);
+	item9->setTextAlignment(Qt::AlignCenter);
+	item9->setText("");
+	table->setItem(row, HITS, item9);
+
+	// record writes
+	auto* item10 = new QTableWidgetItem();
+	item10->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+	item10->setCheckState(Qt::Unchecked);
+	table->setItem(row, RECORD, item10);
+
 	return row;
 }
 
@@ -791,6 +911,17 @@ void BreakpointViewer::fillTableRow(BreakpointType type, int row, int bpIndex)
 	// address
 	auto* item7 = table->item(row, ADDRESS);
 	item7->setText(bp.range ? QString("%1").arg(bp.range->start) : "");
+
+	// trace expression and hits
+	auto* item8 = table->item(row, TRACE);
+	item8->setText(bp.trace);
+
+	auto* item9 = table->item(row, HITS);
+	item9->setText(bp.trace.isEmpty() ? "" : QString::number(breakpoints->traceHits(bp)));
+
+	// record writes
+	auto* item10 = table->item(row, RECORD);
+	item10->setCheckState(bp.record ? Qt::Checked : Qt::Unchecked);
 }
 
 std::optional<Breakpoint> BreakpointViewer::parseTableRow(BreakpointType type, int row)
@@ -812,28 +943,54 @@ std::optional<Breakpoint> BreakpointViewer::parseTableRow(BreakpointType type, i
 	auto segment = parseSegmentField({}, table->item(row, SEGMENT)->text());
 	if (segment) bp.segment = *segment;
 
+	bp.trace = table->item(row, TRACE)->text();
+	bp.record = table->item(row, RECORD)->checkState() == Qt::Checked;
+
 	return bp;
 }
 
 
+void BreakpointViewer::refreshSymbolLocation(int row, int bpIndex)
+{
+	auto* item = bpTableWidget->item(row, LOCATION);
+	if (item->text().isEmpty()) return;
+
+	if (Symbol* symbol = debugSession.symbolTable().getAddressSymbol(item->text())) {
+		setTextField(BreakpointType::BREAKPOINT, row, LOCATION, symbol->text());
+	} else {
+		const Breakpoint& bp = breakpoints->getBreakpoint(bpIndex);
+		setTextField(BreakpointType::BREAKPOINT, row, LOCATION, findSymbolOrValue(bp.range->start));
+	}
+}
+
 void BreakpointViewer::onSymbolTableChanged()
 {
 	for (int row = 0; row < bpTableWidget->rowCount(); ++row) {
-		auto bpIndex = findBreakpointIndex(BreakpointType::BREAKPOINT, row);
-		auto*   item = bpTableWidget->item(row, LOCATION);
-
-		if (bpIndex && !item->text().isEmpty()) {
-			if (Symbol* symbol = debugSession.symbolTable().getAddressSymbol(item->text())) {
-				setTextField(BreakpointType::BREAKPOINT, row, LOCATION, symbol->text());
-			} else {
-				const Breakpoint& bp = breakpoints->getBreakpoint(*bpIndex);
-				setTextField(BreakpointType::BREAKPOINT, row, LOCATION, findSymbolOrValue(bp.range->start));
-			}
+		if (auto bpIndex = findBreakpointIndex(BreakpointType::BREAKPOINT, row)) {
+			refreshSymbolLocation(row, *bpIndex);
 		}
 	}
 	stretchTable(BreakpointType::ALL);
 }
 
+void BreakpointViewer::onSymbolsReloaded(const SymbolChanges& changes)
+{
+	// only the rows with a location that is, or was, one of the symbols
+	bool updated = false;
+	for (int row = 0; row < bpTableWidget->rowCount(); ++row) {
+		auto bpIndex = findBreakpointIndex(BreakpointType::BREAKPOINT, row);
+		if (!bpIndex) continue;
+		const Breakpoint& bp = breakpoints->getBreakpoint(*bpIndex);
+		if (!changes.contains(bpTableWidget->item(row, LOCATION)->text()) &&
+		    !(bp.range && changes.affects(bp.range->start, bp.range->start))) {
+			continue;
+		}
+		refreshSymbolLocation(row, *bpIndex);
+		updated = true;
+	}
+	if (updated) stretchTable(BreakpointType::BREAKPOINT);
+}
+
 
 void BreakpointViewer::onAddBtnClicked(BreakpointType type)
 {
@@ -3,6 +3,7 @@
 
 #include "ui_BreakpointViewer.h"
 #include "DebuggerData.h"
+#include <QHash>
 #include <QList>
 #include <QTabWidget>
 #include <optional>
@@ -11,6 +12,7 @@
 class QPaintEvent;
 class Breakpoints;
 class DebugSession;
+struct SymbolChanges;
 
 enum BreakpointType { BREAKPOINT, WATCHPOINT, CONDITION, ALL };
 
@@ -22,6 +24,7 @@ public:
 	void setBreakpoints(Breakpoints* bps);
 
 	void onSymbolTableChanged();
+	void onSymbolsReloaded(const SymbolChanges& changes);
 	void on_btnAddBp_clicked();
 	void on_btnRemoveBp_clicked();
 	void on_btnAddWp_clicked();
@@ -32,6 +35,10 @@ public:
 	void setRunState();
 	void setBreakState();
 	void refresh();
+	void onBreakpointsAdded(const QStringList& ids);
+	void onBreakpointRemoved(const QString& id);
+	// the hit counts of the tracepoints changed
+	void refreshHits();
 
 signals:
 	void contentsUpdated();
@@ -42,6 +49,7 @@ private:
 	std::optional<AddressRange> parseSymbolOrValue(const QString& field) const;
 
 	QString findSymbolOrValue(uint16_t address) const;
+	void refreshSymbolLocation(int row, int bpIndex);
 
 	std::optional<AddressRange> parseLocationField(std::optional<int> bpIndex,
 	                                               BreakpointType type,
@@ -74,6 +82,8 @@ private:
 
 	std::optional<int> findBreakpointIndex(BreakpointType type, int row) const;
 	std::optional<int> findBreakpointRow(BreakpointType type, const QString& id) const;
+	QHash<QString, int> rowsById(BreakpointType type) const;
+	void updateBreakpointRow(int bpIndex, const QHash<QString, int>* rows);
 
 	void changeCurrentWpType(int row, int index);
 	void disableSorting(BreakpointType type = BreakpointType::ALL);
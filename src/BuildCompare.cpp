@@ -0,0 +1,154 @@
+#include "BuildCompare.h"
+#include "CallGraph.h"
+#include "OfflineImage.h"
+#include "SymbolTable.h"
+#include <QHash>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+QString BuildProfile::load(const QString& romFile, const QString& symbolFile)
+{
+	auto image = OfflineImage::open(romFile);
+	if (!image) {
+		return QString("Can't read %1").arg(romFile);
+	}
+	memory.assign(0x10000 + 3, 0);
+	image->readMemory(0, 0x10000, memory.data());
+
+	SymbolTable symbols;
+	if (!symbols.readFile(symbolFile)) {
+		return QString("Can't read %1").arg(symbolFile);
+	}
+	results.clear();
+	QSet<QString> names;
+	const auto& index = symbols.addressIndex();
+	for (int i = 0; i < index.size(); ++i) {
+		const Symbol* s = index.symbol(i);
+		if (s->type() != Symbol::JUMPLABEL) continue;
+		if (image->block(index.address(i) / OfflineImage::BLOCK_SIZE) == OfflineImage::UNMAPPED) {
+			continue;
+		}
+		// the first of equal names
+		if (names.contains(s->text())) continue;
+		names.insert(s->text());
+		results.push_back({s->text(), index.address(i), 0, 0, 0});
+	}
+	return {};
+}
+
+void BuildProfile::analyze()
+{
+	std::vector<uint16_t> roots;
+	for (const auto& r : results) roots.push_back(r.addr);
+	CallGraph graph;
+	graph.analyze(memory.data(), roots, true);
+
+	for (auto& r : results) {
+		const auto* routine = graph.routine(r.addr);
+		if (!routine) continue;
+		r.instructions = int(routine->code.size());
+		r.bytes = 0;
+		for (uint16_t addr : routine->code) r.bytes += graph.step(addr).length;
+		r.cycles = graph.longestPath(*routine);
+	}
+}
+
+// old, new and the difference, 20 characters
+static QString delta(int before, int after)
+{
+	return QString("%1 %2 %3").arg(before, 6).arg(after, 6)
+	                          .arg(QString::asprintf("%+d", after - before), 6);
+}
+
+int compareBuilds(const QStringList& args)
+{
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+	if (args.size() != 4) {
+		err << "usage: openmsx-debugger --compare OLD.rom OLD.sym NEW.rom NEW.sym\n";
+		return 1;
+	}
+
+	BuildProfile builds[2];
+	for (int i = 0; i < 2; ++i) {
+		QString error = builds[i].load(args[2 * i], args[2 * i + 1]);
+		if (!error.isEmpty()) {
+			err << error << '\n';
+			return 1;
+		}
+	}
+	// both builds at the same time
+	QThread* thread = QThread::create([&builds] { builds[1].analyze(); });
+	thread->start();
+	builds[0].analyze();
+	thread->wait();
+	delete thread;
+
+	// pair the routines by name
+	using Routine = BuildProfile::Routine;
+	QHash<QString, const Routine*> oldRoutines;
+	for (const auto& r : builds[0].routines()) oldRoutines.insert(r.name, &r);
+	struct Change {
+		const Routine* before; // nullptr when added
+		const Routine* after;  // nullptr when removed
+	};
+	std::vector<Change> changes;
+	int compared = 0;
+	for (const auto& r : builds[1].routines()) {
+		const Routine* before = oldRoutines.take(r.name);
+		if (!before) {
+			changes.push_back({nullptr, &r});
+			continue;
+		}
+		++compared;
+		if (before->bytes != r.bytes || before->instructions != r.instructions ||
+		    before->cycles != r.cycles) {
+			changes.push_back({before, &r});
+		}
+	}
+	for (const auto& r : builds[0].routines()) {
+		if (oldRoutines.contains(r.name)) changes.push_back({&r, nullptr});
+	}
+	// the ones that grew most first
+	auto growth = [](const Change& c) {
+		int before = c.before ? c.before->bytes : 0;
+		int after = c.after ? c.after->bytes : 0;
+		return after - before;
+	};
+	std::stable_sort(changes.begin(), changes.end(), [&](const Change& a, const Change& b) {
+		return growth(a) > growth(b);
+	});
+
+	int nameWidth = 7;
+	for (const auto& c : changes) {
+		nameWidth = std::max(nameWidth, int((c.after ? c.after : c.before)->name.size()));
+	}
+	QString columns = QString("%1 %2 %3").arg("old", 6).arg("new", 6).arg("delta", 6);
+	out << QString("routine").leftJustified(nameWidth)
+	    << "    " << QString("bytes").leftJustified(20)
+	    << "    " << QString("instructions").leftJustified(20)
+	    << "    " << "T-states\n"
+	    << QString().leftJustified(nameWidth)
+	    << "    " << columns << "    " << columns << "    " << columns << '\n';
+	Routine none = {};
+	int totalBefore = 0, totalAfter = 0;
+	for (const auto& c : changes) {
+		const Routine& before = c.before ? *c.before : none;
+		const Routine& after = c.after ? *c.after : none;
+		totalBefore += before.bytes;
+		totalAfter += after.bytes;
+		out << (c.after ? after.name : before.name).leftJustified(nameWidth)
+		    << "    " << delta(before.bytes, after.bytes)
+		    << "    " << delta(before.instructions, after.instructions)
+		    << "    " << delta(before.cycles, after.cycles);
+		if (!c.before) out << "  (added)";
+		if (!c.after) out << "  (removed)";
+		out << '\n';
+	}
+	out << QString("\n%1 routines compared, %2 changed; the listed routines went from "
+	               "%3 to %4 bytes\n")
+	       .arg(compared).arg(changes.size()).arg(totalBefore).arg(totalAfter);
+	return 0;
+}
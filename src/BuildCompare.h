@@ -0,0 +1,44 @@
+#ifndef BUILDCOMPARE_H
+#define BUILDCOMPARE_H
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * The size and the speed of the routines of one build of a ROM. Every
+ * jump label of the symbol file starts a routine, that ends at the next
+ * label it reaches. The ROM is mapped like an offline image, so for a
+ * mapper ROM only the labels in the first blocks are seen.
+ */
+class BuildProfile
+{
+public:
+	struct Routine {
+		QString name;
+		uint16_t addr;
+		int bytes;
+		int instructions;
+		int cycles;    // T-states along the slowest path, see CallGraph
+	};
+
+	// returns an error message, or an empty string
+	QString load(const QString& romFile, const QString& symbolFile);
+	// doesn't use the symbol table, so it can run in a thread
+	void analyze();
+
+	// in the order of the symbol file
+	[[nodiscard]] const std::vector<Routine>& routines() const { return results; }
+
+private:
+	std::vector<uint8_t> memory;
+	std::vector<Routine> results;
+};
+
+// Batch mode, compares the routines of two builds and writes a report of
+// the ones that changed to stdout. 'args' are the old ROM and symbol file,
+// then the new ones. Returns the exit code.
+int compareBuilds(const QStringList& args);
+
+#endif // BUILDCOMPARE_H
@@ -0,0 +1,372 @@
+#include "CallGraph.h"
+#include "Dasm.h"
+#include <algorithm>
+
+CallGraph::Step CallGraph::classify(const uint8_t* memory, uint16_t pc)
+{
+	DisasmRow row = dasmInstruction(memory, pc);
+	Step s = {Kind::NEXT, 0, row.numBytes, row.cycles, row.cyclesNotTaken, row.operand};
+	uint8_t op = row.opcode;
+	switch (row.table) {
+	case DisasmRow::MAIN:
+		if (op == 0x18 || op == 0xC3) { // jr, jp
+			s.kind = Kind::JUMP;
+		} else if (op == 0x10 || (op & 0xE7) == 0x20 || (op & 0xC7) == 0xC2) { // djnz, jr cc, jp cc
+			s.kind = Kind::BRANCH;
+		} else if (op == 0xCD || (op & 0xC7) == 0xC4) { // call, call cc
+			s.kind = Kind::CALL;
+		} else if (op == 0xC9) {
+			s.kind = Kind::RET;
+		} else if ((op & 0xC7) == 0xC0) {
+			s.kind = Kind::RET_CC;
+		} else if ((op & 0xC7) == 0xC7) {
+			s.kind = Kind::CALL;
+			s.target = op & 0x38;
+			// SYNCHR is followed by the character to check, CALLF by a
+			// slot and an address, both return behind these bytes
+			if (s.target == 0x08) s.length += 1;
+			if (s.target == 0x30) s.length += 3;
+		} else if (op == 0xE9) { // jp (hl)
+			s.kind = Kind::INDIRECT;
+		} else if ((op & 0xCF) == 0xC5) { // push
+			s.stack = 2;
+		} else if ((op & 0xCF) == 0xC1) { // pop
+			s.stack = -2;
+		} else if (op == 0x33) { // inc sp
+			s.stack = -1;
+		} else if (op == 0x3B) { // dec sp
+			s.stack = 1;
+		} else if (op == 0x31 || op == 0xF9) { // ld sp,nn  ld sp,hl
+			s.kind = Kind::LOAD_SP;
+		}
+		break;
+	case DisasmRow::XX:
+		if (op == 0xE5) {
+			s.stack = 2;
+		} else if (op == 0xE1) {
+			s.stack = -2;
+		} else if (op == 0xE9) {
+			s.kind = Kind::INDIRECT;
+		} else if (op == 0xF9) {
+			s.kind = Kind::LOAD_SP;
+		}
+		break;
+	case DisasmRow::ED:
+		if ((op & 0xC7) == 0x45) { // retn, reti
+			s.kind = Kind::RET;
+		} else if (op == 0x7B) { // ld sp,(nn)
+			s.kind = Kind::LOAD_SP;
+		}
+		break;
+	default:
+		break;
+	}
+	return s;
+}
+
+void CallGraph::analyze(const uint8_t* memory, const std::vector<uint16_t>& roots,
+                        bool rootsAreRoutines)
+{
+	routineList.clear();
+	routineAt.assign(0x10000, -1);
+	code.assign(0x10000, false);
+	steps.resize(0x10000);
+
+	// find the code and the routine entries, temporarily marked with 0
+	std::vector<uint16_t> pending;
+	for (uint16_t root : roots) {
+		if (routineAt[root] >= 0) continue;
+		if (code[root] && !rootsAreRoutines) continue;
+		routineAt[root] = 0;
+		pending.push_back(root);
+		discover(memory, pending);
+	}
+	for (int addr = 0; addr < 0x10000; ++addr) {
+		if (routineAt[addr] < 0) continue;
+		routineAt[addr] = int(routineList.size());
+		routineList.push_back({uint16_t(addr), 0, 0, 0, {}, {}});
+	}
+
+	// follow the stack depth through every routine
+	std::vector<int> visit(0x10000, -1);
+	std::vector<int> depthAt(0x10000);
+	for (auto& r : routineList) {
+		walk(r, visit, depthAt);
+	}
+	computeDepths();
+}
+
+const CallGraph::Routine* CallGraph::routine(uint16_t entry) const
+{
+	if (routineAt.empty() || routineAt[entry] < 0) return nullptr;
+	return &routineList[routineAt[entry]];
+}
+
+int CallGraph::longestPath(const Routine& r) const
+{
+	// the instructions in depth first postorder, without the edges back
+	// to an instruction on the current path (the loops)
+	int n = int(r.code.size());
+	auto indexOf = [&](uint16_t addr) {
+		auto it = std::lower_bound(r.code.begin(), r.code.end(), addr);
+		return (it == r.code.end() || *it != addr) ? -1 : int(it - r.code.begin());
+	};
+	struct Edge {
+		int to;       // -1 for leaving the routine
+		int cycles;
+	};
+	auto edges = [&](int i, Edge out[2]) {
+		const Step& s = steps[r.code[i]];
+		uint16_t next = r.code[i] + s.length;
+		auto to = [&](uint16_t addr) {
+			return addr == r.entry ? -1 : indexOf(addr);
+		};
+		switch (s.kind) {
+		case Kind::JUMP:
+			out[0] = {to(s.target), s.cycles};
+			return 1;
+		case Kind::BRANCH:
+			out[0] = {to(s.target), s.cycles};
+			out[1] = {to(next), s.cyclesNotTaken};
+			return 2;
+		case Kind::RET_CC:
+			out[0] = {-1, s.cycles};
+			out[1] = {to(next), s.cyclesNotTaken};
+			return 2;
+		case Kind::RET:
+		case Kind::INDIRECT:
+			out[0] = {-1, s.cycles};
+			return 1;
+		case Kind::CALL:
+			// a call cc continues at the next instruction either way,
+			// the slowest way is when the call is made
+			out[0] = {to(next), std::max(s.cycles, s.cyclesNotTaken)};
+			return 1;
+		default:
+			out[0] = {to(next), s.cyclesNotTaken};
+			return 1;
+		}
+	};
+
+	enum State : uint8_t { NEW, ON_PATH, DONE };
+	std::vector<State> state(n, NEW);
+	std::vector<int> order;
+	std::vector<std::pair<int, int>> stack; // instruction, next edge
+	if (n) {
+		stack.push_back({indexOf(r.entry), 0});
+		state[stack.back().first] = ON_PATH;
+	}
+	while (!stack.empty()) {
+		auto& [i, e] = stack.back();
+		Edge out[2];
+		int numEdges = edges(i, out);
+		if (e < numEdges) {
+			int to = out[e++].to;
+			if (to >= 0 && state[to] == NEW) {
+				state[to] = ON_PATH;
+				stack.push_back({to, 0});
+			}
+		} else {
+			state[i] = DONE;
+			order.push_back(i);
+			stack.pop_back();
+		}
+	}
+
+	// longest path to the end, in postorder the instructions that follow
+	// come first
+	std::vector<int> longest(n, 0);
+	std::vector<bool> done(n, false);
+	for (int i : order) {
+		Edge out[2];
+		int numEdges = edges(i, out);
+		int best = 0;
+		for (int e = 0; e < numEdges; ++e) {
+			int to = out[e].to;
+			if (to >= 0 && !done[to]) continue; // back to a loop header
+			best = std::max(best, out[e].cycles + (to >= 0 ? longest[to] : 0));
+		}
+		longest[i] = best;
+		done[i] = true;
+	}
+	return n ? longest[indexOf(r.entry)] : 0;
+}
+
+void CallGraph::discover(const uint8_t* memory, std::vector<uint16_t>& pending)
+{
+	std::vector<uint16_t> paths;
+	while (!pending.empty()) {
+		paths.push_back(pending.back());
+		pending.pop_back();
+		while (!paths.empty()) {
+			uint16_t pc = paths.back();
+			paths.pop_back();
+			while (!code[pc]) {
+				code[pc] = true;
+				const Step& s = steps[pc] = classify(memory, pc);
+				uint16_t next = pc + s.length;
+				if (s.kind == Kind::CALL && routineAt[s.target] < 0) {
+					routineAt[s.target] = 0;
+					pending.push_back(s.target);
+				}
+				if (s.kind == Kind::JUMP) {
+					pc = s.target;
+				} else if (s.kind == Kind::BRANCH) {
+					paths.push_back(s.target);
+					pc = next;
+				} else if (s.kind == Kind::RET || s.kind == Kind::INDIRECT) {
+					break;
+				} else {
+					pc = next;
+				}
+			}
+		}
+	}
+}
+
+void CallGraph::walk(Routine& r, std::vector<int>& visit, std::vector<int>& depthAt)
+{
+	struct Path {
+		uint16_t pc;
+		uint16_t from; // the jump or the instruction before
+		int depth;
+	};
+	int stamp = int(&r - routineList.data());
+	std::vector<Path> paths = {{r.entry, r.entry, 0}};
+	while (!paths.empty()) {
+		auto [pc, from, depth] = paths.back();
+		paths.pop_back();
+		while (true) {
+			if (pc != r.entry && routineAt[pc] >= 0) {
+				r.calls.push_back({from, pc, depth, true});
+				break;
+			}
+			if (visit[pc] == stamp) {
+				if (depthAt[pc] != depth) r.flags |= UNBALANCED;
+				break;
+			}
+			visit[pc] = stamp;
+			depthAt[pc] = depth;
+			r.code.push_back(pc);
+			if (depth < 0) r.flags |= UNBALANCED;
+			r.ownDepth = std::max(r.ownDepth, depth);
+
+			const Step& s = steps[pc];
+			uint16_t next = pc + s.length;
+			from = pc;
+			switch (s.kind) {
+			case Kind::NEXT:
+				depth += s.stack;
+				pc = next;
+				continue;
+			case Kind::LOAD_SP:
+				r.flags |= SP_LOADED;
+				depth = 0;
+				pc = next;
+				continue;
+			case Kind::JUMP:
+				pc = s.target;
+				continue;
+			case Kind::BRANCH:
+				paths.push_back({s.target, pc, depth});
+				pc = next;
+				continue;
+			case Kind::CALL:
+				r.calls.push_back({pc, s.target, depth, false});
+				pc = next;
+				continue;
+			case Kind::RET_CC:
+				if (depth != 0) r.flags |= UNBALANCED;
+				pc = next;
+				continue;
+			case Kind::RET:
+				if (depth != 0) r.flags |= UNBALANCED;
+				break;
+			case Kind::INDIRECT:
+				r.flags |= INDIRECT;
+				break;
+			}
+			break;
+		}
+	}
+	std::sort(r.code.begin(), r.code.end());
+}
+
+void CallGraph::computeDepths()
+{
+	// Tarjan's algorithm, it produces the strongly connected components
+	// of the call graph with the called routines before their callers
+	int n = int(routineList.size());
+	std::vector<int> index(n, -1), low(n);
+	std::vector<bool> onStack(n, false);
+	std::vector<int> stack;
+	int counter = 0;
+
+	auto callee = [&](const CallSite& c) { return routineAt[c.target]; };
+	auto finish = [&](int v) {
+		std::vector<int> members;
+		int w;
+		do {
+			w = stack.back();
+			stack.pop_back();
+			onStack[w] = false;
+			members.push_back(w);
+		} while (w != v);
+
+		auto& r = routineList[v];
+		bool recursive = members.size() > 1 ||
+			std::any_of(r.calls.begin(), r.calls.end(),
+			            [&](const CallSite& c) { return callee(c) == v; });
+		if (recursive) {
+			for (int m : members) {
+				routineList[m].flags |= RECURSIVE;
+				routineList[m].maxDepth = UNBOUNDED;
+			}
+			return;
+		}
+		r.maxDepth = r.ownDepth;
+		for (const auto& c : r.calls) {
+			int d = routineList[callee(c)].maxDepth;
+			if (d == UNBOUNDED) {
+				r.maxDepth = UNBOUNDED;
+				return;
+			}
+			r.maxDepth = std::max(r.maxDepth, c.depth + (c.tail ? 0 : 2) + d);
+		}
+	};
+
+	struct Frame {
+		int v;
+		size_t next;
+	};
+	std::vector<Frame> frames;
+	for (int root = 0; root < n; ++root) {
+		if (index[root] >= 0) continue;
+		index[root] = low[root] = counter++;
+		stack.push_back(root);
+		onStack[root] = true;
+		frames.push_back({root, 0});
+		while (!frames.empty()) {
+			int v = frames.back().v;
+			const auto& calls = routineList[v].calls;
+			if (frames.back().next < calls.size()) {
+				int w = callee(calls[frames.back().next++]);
+				if (index[w] < 0) {
+					index[w] = low[w] = counter++;
+					stack.push_back(w);
+					onStack[w] = true;
+					frames.push_back({w, 0});
+				} else if (onStack[w]) {
+					low[v] = std::min(low[v], index[w]);
+				}
+			} else {
+				frames.pop_back();
+				if (!frames.empty()) {
+					int u = frames.back().v;
+					low[u] = std::min(low[u], low[v]);
+				}
+				if (low[v] == index[v]) finish(v);
+			}
+		}
+	}
+}
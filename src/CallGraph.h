@@ -0,0 +1,88 @@
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Static call graph of the code in a 64kB memory image, with the worst
+ * case stack use of every routine.
+ *
+ * The code is found by following the flow of the instructions from the
+ * given roots, so data in between is never decoded. Every call or rst
+ * target is a routine. Roots that are not reached from an earlier root
+ * start a routine as well, so the roots are best given in order of
+ * importance (e.g. the entry points of a ROM first, then the labels).
+ *
+ * Within a routine the stack depth is followed along all paths: push,
+ * pop, inc sp and dec sp change it, a call adds 2 bytes plus the depth of
+ * the called routine. Jumps and fall-through into another routine are
+ * tail calls. The MSX BIOS conventions for rst #08 (followed by one byte)
+ * and rst #30 (followed by a slot and an address) are known.
+ */
+class CallGraph
+{
+public:
+	enum Flags : uint8_t {
+		RECURSIVE  = 0x01, // part of a call cycle
+		UNBALANCED = 0x02, // a path returns or joins with another stack depth
+		SP_LOADED  = 0x04, // loads SP, the depth is counted from there
+		INDIRECT   = 0x08, // has a jp (hl), jp (ix) or jp (iy)
+	};
+	// depth of a routine that is, or calls, a recursive routine
+	static constexpr int UNBOUNDED = -1;
+
+	// what an instruction does to the flow and the stack
+	enum class Kind : uint8_t { NEXT, JUMP, BRANCH, CALL, RET, RET_CC, INDIRECT, LOAD_SP };
+	struct Step {
+		Kind kind;
+		int8_t stack;   // change of the stack depth in bytes
+		uint8_t length;
+		uint8_t cycles; // T-states, see DisasmRow
+		uint8_t cyclesNotTaken;
+		uint16_t target;
+	};
+	static Step classify(const uint8_t* memory, uint16_t pc);
+
+	struct CallSite {
+		uint16_t addr;   // address of the call, or of the jump for a tail call
+		uint16_t target;
+		int depth;       // stack depth at the call
+		bool tail;
+	};
+	struct Routine {
+		uint16_t entry;
+		uint8_t flags;
+		int ownDepth;    // deepest stack use by the routine itself, in bytes
+		int maxDepth;    // including the called routines, or UNBOUNDED
+		std::vector<uint16_t> code; // the instructions, in address order
+		std::vector<CallSite> calls;
+	};
+
+	// 'memory' is the 64kB address space plus 3 bytes. With 'rootsAreRoutines'
+	// every root starts a routine, also when it's reached from another one.
+	void analyze(const uint8_t* memory, const std::vector<uint16_t>& roots,
+	             bool rootsAreRoutines = false);
+
+	[[nodiscard]] const std::vector<Routine>& routines() const { return routineList; }
+	// the routine that starts at 'entry', or nullptr
+	[[nodiscard]] const Routine* routine(uint16_t entry) const;
+	[[nodiscard]] bool isCode(uint16_t addr) const { return !code.empty() && code[addr]; }
+	// the decoded instruction at a code address
+	[[nodiscard]] const Step& step(uint16_t addr) const { return steps[addr]; }
+	// T-states along the slowest path through the routine, loops are
+	// counted once and calls without the called routine
+	[[nodiscard]] int longestPath(const Routine& r) const;
+
+private:
+	void discover(const uint8_t* memory, std::vector<uint16_t>& pending);
+	void walk(Routine& r, std::vector<int>& visit, std::vector<int>& depthAt);
+	void computeDepths();
+
+	std::vector<Routine> routineList; // sorted on entry
+	std::vector<int> routineAt;       // per address: index in routineList or -1
+	std::vector<bool> code;           // per address: an instruction starts here
+	std::vector<Step> steps;          // per address of code: the decoded instruction
+};
+
+#endif // CALLGRAPH_H
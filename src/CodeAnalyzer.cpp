@@ -0,0 +1,134 @@
+#include "CodeAnalyzer.h"
+#include "SymbolTable.h"
+#include <QStringList>
+#include <QThread>
+
+CodeAnalyzer::CodeAnalyzer(SymbolTable& symTable_, MemoryLayout& memLayout_, QObject* parent)
+	: QObject(parent), symTable(symTable_), memLayout(memLayout_)
+{
+}
+
+CodeAnalyzer::~CodeAnalyzer()
+{
+	if (thread) {
+		thread->wait();
+		delete thread;
+	}
+}
+
+void CodeAnalyzer::start()
+{
+	if (waitingForData || thread) {
+		restart = true;
+		return;
+	}
+	memory.assign(0x10000 + 3, 0);
+	waitingForData = true;
+	requested = generation;
+	new SimpleHexRequest("memory", 0, 0x10000, memory.data(), *this);
+}
+
+void CodeAnalyzer::clear()
+{
+	++generation;
+	restart = false;
+	graph.reset();
+	loops.reset();
+	advice.reset();
+	timing.reset();
+	emit analysisReady();
+}
+
+void CodeAnalyzer::DataHexRequestReceived()
+{
+	waitingForData = false;
+	if (requested != generation) {
+		// cleared while the memory was read
+		if (restart) {
+			restart = false;
+			start();
+		}
+		return;
+	}
+
+	auto result = std::make_shared<CallGraph>();
+	auto loopResult = std::make_shared<LoopAnalysis>();
+	auto adviceResult = std::make_shared<PeepholeAdvisor>();
+	auto timingResult = std::make_shared<VramTiming>();
+	auto entries = roots();
+	thread = QThread::create([result, loopResult, adviceResult, timingResult, previous = loops,
+	                          mem = std::move(memory), entries = std::move(entries)] {
+		result->analyze(mem.data(), entries);
+		loopResult->analyze(mem.data(), *result, previous.get());
+		adviceResult->analyze(mem.data(), *result, loopResult.get());
+		timingResult->analyze(mem.data(), *result);
+	});
+	connect(thread, &QThread::finished, this,
+	        [this, result, loopResult, adviceResult, timingResult, analyzed = generation] {
+		thread->deleteLater();
+		thread = nullptr;
+		// the result of an analysis that was cleared while it ran is dropped
+		if (analyzed == generation) {
+			graph = result;
+			loops = loopResult;
+			advice = adviceResult;
+			timing = timingResult;
+			emit analysisReady();
+		}
+		if (restart) {
+			restart = false;
+			start();
+		}
+	});
+	thread->start(QThread::LowPriority);
+}
+
+void CodeAnalyzer::DataHexRequestCanceled()
+{
+	waitingForData = false;
+	restart = false;
+}
+
+QString CodeAnalyzer::stackUse(const CallGraph::Routine& r)
+{
+	QString text = r.maxDepth == CallGraph::UNBOUNDED
+	             ? tr("unbounded") : QString::number(r.maxDepth);
+	QStringList notes;
+	if (r.flags & CallGraph::RECURSIVE)  notes << tr("recursive");
+	if (r.flags & CallGraph::UNBALANCED) notes << tr("unbalanced");
+	if (r.flags & CallGraph::SP_LOADED)  notes << tr("loads SP");
+	if (r.flags & CallGraph::INDIRECT)   notes << tr("indirect jump");
+	if (!notes.isEmpty()) {
+		text += QString(" (%1)").arg(notes.join(", "));
+	}
+	return text;
+}
+
+bool CodeAnalyzer::isSuspect(const CallGraph::Routine& r)
+{
+	return r.maxDepth == CallGraph::UNBOUNDED || (r.flags & CallGraph::UNBALANCED);
+}
+
+std::vector<uint16_t> CodeAnalyzer::roots() const
+{
+	// reset and the interrupt handler
+	std::vector<uint16_t> result = {0x0000, 0x0038};
+
+	// INIT, STATEMENT and DEVICE of a ROM header
+	for (int page = 0x4000; page <= 0x8000; page += 0x4000) {
+		if (memory[page] != 'A' || memory[page + 1] != 'B') continue;
+		for (int i = 2; i <= 6; i += 2) {
+			if (int addr = memory[page + i] + 256 * memory[page + i + 1]) {
+				result.push_back(addr);
+			}
+		}
+	}
+
+	const auto& symbols = symTable.addressIndex(&memLayout);
+	for (int i = 0; i < symbols.size(); ++i) {
+		if (symbols.symbol(i)->type() == Symbol::JUMPLABEL) {
+			result.push_back(symbols.address(i));
+		}
+	}
+	return result;
+}
@@ -0,0 +1,70 @@
+#ifndef CODEANALYZER_H
+#define CODEANALYZER_H
+
+#include "CallGraph.h"
+#include "LoopAnalysis.h"
+#include "PeepholeAdvisor.h"
+#include "VramTiming.h"
+#include "SimpleHexRequest.h"
+#include <QObject>
+#include <memory>
+#include <vector>
+
+class QThread;
+class SymbolTable;
+struct MemoryLayout;
+
+/**
+ * Runs the code analysis on the memory at a break. The memory is read in
+ * one request and analyzed in a background thread, the result replaces
+ * the previous one when it's complete. The loops of routines that didn't
+ * change since the previous analysis are reused, the code is checked
+ * for cheaper instruction sequences and for quick VRAM accesses. The
+ * roots of the analysis are the BIOS entry points, the entries in a ROM
+ * header and the jump labels.
+ */
+class CodeAnalyzer : public QObject, public SimpleHexRequestUser
+{
+	Q_OBJECT
+public:
+	CodeAnalyzer(SymbolTable& symTable, MemoryLayout& memLayout, QObject* parent = nullptr);
+	~CodeAnalyzer() override;
+
+	// analyze the current memory, a running analysis is followed by a new one
+	void start();
+	void clear();
+
+	[[nodiscard]] std::shared_ptr<const CallGraph> callGraph() const { return graph; }
+	[[nodiscard]] std::shared_ptr<const LoopAnalysis> loopAnalysis() const { return loops; }
+	[[nodiscard]] std::shared_ptr<const PeepholeAdvisor> peepholeAdvice() const { return advice; }
+	[[nodiscard]] std::shared_ptr<const VramTiming> vramTiming() const { return timing; }
+
+	// e.g. "12", "unbounded (recursive)" or "6 (unbalanced)"
+	[[nodiscard]] static QString stackUse(const CallGraph::Routine& r);
+	// the stack use can't be trusted
+	[[nodiscard]] static bool isSuspect(const CallGraph::Routine& r);
+
+signals:
+	void analysisReady();
+
+private:
+	void DataHexRequestReceived() override;
+	void DataHexRequestCanceled() override;
+	std::vector<uint16_t> roots() const;
+
+	SymbolTable& symTable;
+	MemoryLayout& memLayout;
+	std::vector<uint8_t> memory;
+	std::shared_ptr<const CallGraph> graph;
+	std::shared_ptr<const LoopAnalysis> loops;
+	std::shared_ptr<const PeepholeAdvisor> advice;
+	std::shared_ptr<const VramTiming> timing;
+	QThread* thread = nullptr;
+	bool waitingForData = false;
+	bool restart = false;
+	// clear() drops the analysis that is underway, by counting up
+	unsigned generation = 0;
+	unsigned requested = 0; // the generation of the memory request
+};
+
+#endif // CODEANALYZER_H
@@ -1,5 +1,6 @@
 #include "CommClient.h"
 #include "OpenMSXConnection.h"
+#include <QTimer>
 
 CommClient::~CommClient()
 {
@@ -22,10 +23,17 @@ void CommClient::connectToOpenMSX(std::unique_ptr<OpenMSXConnection> conn)
 	emit connectionReady();
 }
 
+void CommClient::openImage(std::unique_ptr<OfflineImage> image_)
+{
+	closeConnection();
+	image = std::move(image_);
+}
+
 void CommClient::closeConnection()
 {
-	if (connection) {
+	if (connection || image) {
 		connection.reset();
+		image.reset();
 		emit connectionTerminated();
 	}
 }
@@ -34,6 +42,13 @@ void CommClient::sendCommand(CommandBase* command)
 {
 	if (connection) {
 		connection->sendCommand(command);
+	} else if (image) {
+		// reply later, like a connection does
+		QTimer::singleShot(0, this, [this, command] {
+			if (!image || !image->execute(*command)) {
+				command->cancel();
+			}
+		});
 	} else {
 		command->cancel();
 	}
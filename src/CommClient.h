@@ -2,6 +2,7 @@
 #define COMMCLIENT_H
 
 #include "OpenMSXConnection.h"
+#include "OfflineImage.h"
 #include <QObject>
 #include <memory>
 
@@ -16,6 +17,9 @@ public:
 
 	void sendCommand(CommandBase* command);
 	void connectToOpenMSX(std::unique_ptr<OpenMSXConnection> conn);
+	// answer commands from a file instead of openMSX
+	void openImage(std::unique_ptr<OfflineImage> image);
+	[[nodiscard]] const OfflineImage* offlineImage() const { return image.get(); }
 
 	void closeConnection();
 
@@ -31,6 +35,7 @@ private:
 
 private:
 	std::unique_ptr<OpenMSXConnection> connection;
+	std::unique_ptr<OfflineImage> image;
 };
 
 #endif // COMMCLIENT_H
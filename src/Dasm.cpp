@@ -1,8 +1,8 @@
 #include "Dasm.h"
 #include "DasmTables.h"
 #include "SymbolTable.h"
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <cstring>
 
 static char sign(unsigned char a)
 {
@@ -14,178 +14,329 @@ static int abs(unsigned char a)
 	return (a & 128) ? (256 - a) : a;
 }
 
-static std::string toHex(unsigned value, unsigned width)
+std::string toHex(unsigned value, unsigned width)
 {
-	std::ostringstream s;
-	s << std::hex << std::setw(width) << std::setfill('0') << value;
-	return s.str();
+	static const char digits[] = "0123456789abcdef";
+	std::string s(width, '0');
+	for (unsigned i = width; i-- > 0; value >>= 4) {
+		s[i] = digits[value & 15];
+	}
+	return s;
+}
+
+static int get16(const unsigned char* memBuf, int address)
+{
+	return memBuf[address] + 256 * memBuf[address + 1];
 }
 
-static std::string translateAddress(
-	int address, MemoryLayout* memLayout, SymbolTable* symTable)
+static bool isBlockEnd(const unsigned char* membuf, int pc)
 {
-	if (Symbol* label = symTable->getAddressSymbol(address, memLayout)) {
-		return label->text().toStdString();
-	} else {
-		return '#' + toHex(address, 4);
+	uint8_t op = membuf[pc];
+	switch (op) {
+	case 0xED:
+		// retn, reti
+		return membuf[pc + 1] == 0x45 || membuf[pc + 1] == 0x4D;
+	case 0xDD:
+	case 0xFD:
+		// jp (ix), jp (iy)
+		return membuf[pc + 1] == 0xE9;
+	case 0x10: // djnz
+	case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // jr
+	case 0x76: // halt
+	case 0xC3: case 0xC9: case 0xCD: case 0xE9: // jp, ret, call, jp (hl)
+		return true;
+	default:
+		if (op < 0xC0) return false;
+		switch (op & 7) {
+		case 0: // ret cc
+		case 2: // jp cc
+		case 4: // call cc
+		case 7: // rst
+			return true;
+		default:
+			return false;
+		}
 	}
 }
 
-static int get16(const unsigned char* memBuf, int address)
+static const char* mnemonic(const DisasmRow& row)
 {
-	return memBuf[address] + 256 * memBuf[address + 1];
+	switch (row.table) {
+	case DisasmRow::MAIN:  return mnemonic_main [row.opcode];
+	case DisasmRow::CB:    return mnemonic_cb   [row.opcode];
+	case DisasmRow::ED:    return mnemonic_ed   [row.opcode];
+	case DisasmRow::XX:    return mnemonic_xx   [row.opcode];
+	case DisasmRow::XX_CB: return mnemonic_xx_cb[row.opcode];
+	default:               return nullptr;
+	}
+}
+
+bool DisasmRow::hasAddressOperand() const
+{
+	const char* s = mnemonic(*this);
+	return s && (strchr(s, 'A') || strchr(s, 'R'));
+}
+
+static void makeData(DisasmRow& row, int numBytes)
+{
+	row.table = DisasmRow::DATA;
+	row.numBytes = numBytes;
+	row.operand = 0;
+	row.symbol = -1;
+	row.cycles = row.cyclesNotTaken = 0;
+	row.blockEnd = false;
 }
 
 void dasm(const unsigned char* membuf, uint16_t startAddr, uint16_t endAddr,
           DisasmLines& disasm, MemoryLayout* memLayout, SymbolTable* symTable, int currentPC)
+{
+	dasm(membuf, startAddr, endAddr, disasm, symTable->addressIndex(memLayout), currentPC);
+}
+
+// Decodes the instruction at 'pc' into 'dest', except for the symbol.
+// Returns whether it has an address operand.
+static bool decode(const unsigned char* membuf, int pc, DisasmRow& dest)
+{
+	dest.rowType = DisasmRow::INSTRUCTION;
+	dest.addr = pc;
+	dest.operand = 0;
+	dest.infoLine = 0;
+	dest.symbol = -1;
+
+	const InstructionTiming* t;
+	switch (membuf[pc]) {
+	case 0xCB:
+		dest.table = DisasmRow::CB;
+		dest.opcode = membuf[pc + 1];
+		t = &timing_cb[dest.opcode];
+		dest.numBytes = 2;
+		break;
+	case 0xED:
+		dest.table = DisasmRow::ED;
+		dest.opcode = membuf[pc + 1];
+		t = &timing_ed[dest.opcode];
+		dest.numBytes = 2;
+		break;
+	case 0xDD:
+	case 0xFD:
+		if (membuf[pc + 1] != 0xcb) {
+			dest.table = DisasmRow::XX;
+			dest.opcode = membuf[pc + 1];
+			t = &timing_xx[dest.opcode];
+			dest.numBytes = 2;
+		} else {
+			dest.table = DisasmRow::XX_CB;
+			dest.opcode = membuf[pc + 3];
+			t = &timing_xx_cb[dest.opcode];
+			dest.numBytes = 4;
+		}
+		break;
+	default:
+		dest.table = DisasmRow::MAIN;
+		dest.opcode = membuf[pc];
+		t = &timing_main[dest.opcode];
+		dest.numBytes = 1;
+	}
+	dest.cycles = t->taken;
+	dest.cyclesNotTaken = t->notTaken;
+	dest.blockEnd = isBlockEnd(membuf, pc);
+
+	// only the operand sizes and targets are needed here
+	bool addressOperand = false;
+	for (const char* s = mnemonic(dest); *s; ++s) {
+		switch (*s) {
+		case 'A':
+			dest.operand = get16(membuf, pc + dest.numBytes);
+			dest.numBytes += 2;
+			addressOperand = true;
+			break;
+		case 'R':
+			dest.operand = (pc + 2 + (signed char)membuf[pc + dest.numBytes]) & 0xFFFF;
+			dest.numBytes += 1;
+			addressOperand = true;
+			break;
+		case 'B':
+		case 'X':
+			dest.numBytes += 1;
+			break;
+		case 'W':
+			dest.numBytes += 2;
+			break;
+		case '!':
+		case '#':
+			makeData(dest, 2);
+			return false;
+		case '@':
+			makeData(dest, 1);
+			return false;
+		default:
+			break;
+		}
+	}
+	return addressOperand;
+}
+
+DisasmRow dasmInstruction(const unsigned char* membuf, uint16_t pc)
+{
+	DisasmRow row;
+	decode(membuf, pc, row);
+	for (int i = 0; i < 4; ++i) {
+		row.bytes[i] = i < row.numBytes ? membuf[pc + i] : 0;
+	}
+	return row;
+}
+
+void dasm(const unsigned char* membuf, uint16_t startAddr, int endAddr,
+          DisasmLines& disasm, const AddressSymbolIndex& symbols, int currentPC)
 {
 	int pc = startAddr;
 	int labelCount = 0;
-	Symbol* symbol = symTable->findFirstAddressSymbol(pc, memLayout);
+	int symbol = symbols.lowerBound(pc);
 
 	disasm.clear();
-	while (pc <= int(endAddr)) {
+	while (pc <= std::min(endAddr, 0xFFFF)) {
 		// check for a label
-		while (symbol && symbol->value() == pc) {
+		while (symbol < symbols.size() && symbols.address(symbol) == pc) {
 			++labelCount;
-			DisasmRow destsym;
+			DisasmRow destsym = {};
 			destsym.rowType = DisasmRow::LABEL;
 			destsym.numBytes = 0;
 			destsym.infoLine = labelCount;
 			destsym.addr = pc;
-			destsym.instr = symbol->text().toStdString();
+			destsym.symbol = symbol;
 			disasm.push_back(destsym);
-			symbol = symTable->findNextAddressSymbol(memLayout);
+			++symbol;
 		}
 
 		labelCount = 0;
 		DisasmRow dest;
-		dest.rowType = DisasmRow::INSTRUCTION;
-		dest.addr = pc;
-		dest.numBytes = 0;
-		dest.infoLine = 0;
-		dest.instr.clear();
-
-		const char* s;
-		const char* r = nullptr;
-		switch (membuf[pc]) {
-		case 0xCB:
-			s = mnemonic_cb[membuf[pc + 1]];
-			dest.numBytes = 2;
-			break;
-		case 0xED:
-			s = mnemonic_ed[membuf[pc + 1]];
-			dest.numBytes = 2;
-			break;
-		case 0xDD:
-		case 0xFD:
-			r = (membuf[pc] == 0xDD) ? "ix" : "iy";
-			if (membuf[pc + 1] != 0xcb) {
-				s = mnemonic_xx[membuf[pc + 1]];
-				dest.numBytes = 2;
-			} else {
-				s = mnemonic_xx_cb[membuf[pc + 3]];
-				dest.numBytes = 4;
-			}
-			break;
-		default:
-			s = mnemonic_main[membuf[pc]];
-			dest.numBytes = 1;
-		}
-
-		for (int j = 0; s[j]; ++j) {
-			switch (s[j]) {
-			case 'A': {
-				int address = get16(membuf, pc + dest.numBytes);
-				dest.instr += translateAddress(address, memLayout, symTable);
-				dest.numBytes += 2;
-				break;
-			}
-			case 'B':
-				dest.instr += '#' + toHex(membuf[pc + dest.numBytes], 2);
-				dest.numBytes += 1;
-				break;
-			case 'R': {
-				int address = (pc + 2 + (signed char)membuf[pc + dest.numBytes]) & 0xFFFF;
-				dest.instr += translateAddress(address, memLayout, symTable);
-				dest.numBytes += 1;
-				break;
-			}
-			case 'W':
-				dest.instr += '#' + toHex(get16(membuf, pc + dest.numBytes), 4);
-				dest.numBytes += 2;
-				break;
-			case 'X': {
-				unsigned char offset = membuf[pc + dest.numBytes];
-				dest.instr += '(' + std::string(r) + sign(offset)
-				           +  '#' + toHex(abs(offset), 2) + ')';
-				dest.numBytes += 1;
-				break;
-			}
-			case 'Y': {
-				unsigned char offset = membuf[pc + 2];
-				dest.instr += '(' + std::string(r) + sign(offset)
-				           +  '#' + toHex(abs(offset), 2) + ')';
-				break;
-			}
-			case 'I':
-				dest.instr += r;
-				break;
-			case '!':
-				dest.instr = "db     #ED,#" + toHex(membuf[pc + 1], 2);
-				dest.numBytes = 2;
-				break;
-			case '@':
-				dest.instr = "db     #" + toHex(membuf[pc], 2);
-				dest.numBytes = 1;
-				break;
-			case '#':
-				dest.instr = "db     #" + toHex(membuf[pc + 0], 2) +
-				                "#CB,#" + toHex(membuf[pc + 2], 2);
-				dest.numBytes = 2;
-				break;
-			case ' ': {
-				dest.instr.resize(7, ' ');
-				break;
-			}
-			default:
-				dest.instr += s[j];
-				break;
-			}
+		if (decode(membuf, pc, dest)) {
+			dest.symbol = symbols.find(dest.operand);
 		}
 
 		// handle overflow at end or label
 		int dataBytes = 0;
-		if (symbol && pc + dest.numBytes > symbol->value()) {
-			dataBytes = symbol->value() - pc;
+		if (symbol < symbols.size() && pc + dest.numBytes > symbols.address(symbol)) {
+			dataBytes = symbols.address(symbol) - pc;
 		} else if (pc + dest.numBytes > endAddr) {
 			dataBytes = endAddr - pc;
 		} else if (pc + dest.numBytes > currentPC) {
 			dataBytes = currentPC - pc;
 		}
+		if (dataBytes > 0 && dataBytes <= 3) {
+			makeData(dest, dataBytes);
+		}
+
+		for (int i = 0; i < 4; ++i) {
+			dest.bytes[i] = i < dest.numBytes ? membuf[pc + i] : 0;
+		}
+		disasm.push_back(dest);
+		pc += dest.numBytes;
+	}
+}
+
+// Positions in the index shift when symbols are added or removed, so
+// verify the stored position and otherwise look the address up again.
+static int findSymbol(const AddressSymbolIndex& symbols, int pos, int address, int nth = 0)
+{
+	if (pos >= 0 && pos < symbols.size() && symbols.address(pos) == address) {
+		return pos;
+	}
+	pos = symbols.find(address);
+	if (pos == AddressSymbolIndex::NOT_FOUND) return pos;
+	pos += nth;
+	return (pos < symbols.size() && symbols.address(pos) == address)
+	     ? pos : AddressSymbolIndex::NOT_FOUND;
+}
+
+std::string disasmText(const DisasmRow& row, const AddressSymbolIndex& symbols)
+{
+	if (row.rowType == DisasmRow::LABEL) {
+		int pos = findSymbol(symbols, row.symbol, row.addr, row.infoLine - 1);
+		return pos != AddressSymbolIndex::NOT_FOUND ? std::string(symbols.name(pos)) : std::string();
+	}
+
+	std::string instr;
+	if (row.table == DisasmRow::DATA) {
+		instr = "db     ";
+		for (int i = 0; i < row.numBytes; ++i) {
+			if (i) instr += ',';
+			instr += '#' + toHex(row.bytes[i], 2);
+		}
+		return instr;
+	}
 
-		switch (dataBytes) {
-		case 1:
-			dest.instr = "db     #" + toHex(membuf[pc + 0], 2);
-			dest.numBytes = 1;
+	const char* r = (row.bytes[0] == 0xDD) ? "ix" : "iy";
+	int pos = row.table == DisasmRow::MAIN  ? 1
+	        : row.table == DisasmRow::XX_CB ? 4 : 2;
+	for (const char* s = mnemonic(row); *s; ++s) {
+		switch (*s) {
+		case 'A':
+		case 'R': {
+			int sym = row.symbol >= 0 ? findSymbol(symbols, row.symbol, row.operand)
+			                          : AddressSymbolIndex::NOT_FOUND;
+			instr += sym != AddressSymbolIndex::NOT_FOUND
+			       ? std::string(symbols.name(sym)) : '#' + toHex(row.operand, 4);
+			pos += *s == 'A' ? 2 : 1;
 			break;
-		case 2:
-			dest.instr = "db     #" + toHex(membuf[pc + 0], 2) +
-			                   ",#" + toHex(membuf[pc + 1], 2);
-			dest.numBytes = 2;
+		}
+		case 'B':
+			instr += '#' + toHex(row.bytes[pos], 2);
+			pos += 1;
+			break;
+		case 'W':
+			instr += '#' + toHex(row.bytes[pos] + 256 * row.bytes[pos + 1], 4);
+			pos += 2;
 			break;
-		case 3:
-			dest.instr = "db     #" + toHex(membuf[pc + 0], 2) +
-			                   ",#" + toHex(membuf[pc + 1], 2) +
-			                   ",#" + toHex(membuf[pc + 2], 2);
-			dest.numBytes = 3;
+		case 'X': {
+			unsigned char offset = row.bytes[pos];
+			instr += '(' + std::string(r) + sign(offset)
+			      +  '#' + toHex(abs(offset), 2) + ')';
+			pos += 1;
+			break;
+		}
+		case 'Y': {
+			unsigned char offset = row.bytes[2];
+			instr += '(' + std::string(r) + sign(offset)
+			      +  '#' + toHex(abs(offset), 2) + ')';
+			break;
+		}
+		case 'I':
+			instr += r;
+			break;
+		case ' ':
+			instr.resize(7, ' ');
 			break;
 		default:
+			instr += *s;
 			break;
 		}
+	}
+	if (instr.size() < 8) instr.resize(8, ' ');
+	return instr;
+}
 
-		if (dest.instr.size() < 8) dest.instr.resize(8, ' ');
-		disasm.push_back(dest);
-		pc += dest.numBytes;
+
+// class DisasmTextCache
+
+const std::string& DisasmTextCache::text(const DisasmRow& row, const AddressSymbolIndex& symbols)
+{
+	uint64_t key = (uint64_t(row.addr) << 32) | uint32_t(row.infoLine);
+	if (auto it = lookup.find(key); it != lookup.end()) {
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->second;
+	}
+	if (entries.size() >= capacity) {
+		lookup.erase(entries.back().first);
+		entries.pop_back();
 	}
+	entries.emplace_front(key, disasmText(row, symbols));
+	lookup[key] = entries.begin();
+	return entries.front().second;
+}
+
+void DisasmTextCache::clear()
+{
+	entries.clear();
+	lookup.clear();
 }
@@ -1,24 +1,44 @@
 #ifndef DASM_H
 #define DASM_H
 
+#include <list>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <stdint.h>
 
 class SymbolTable;
+class AddressSymbolIndex;
 struct MemoryLayout;
 
+// A single line of disassembly. Rows are plain records, the text is only
+// produced when a row is actually shown, see disasmText().
 struct DisasmRow {
-	enum RowType { INSTRUCTION, LABEL };
+	enum RowType : uint8_t { INSTRUCTION, LABEL };
+	// mnemonic table of the opcode, DATA rows show their bytes as 'db'
+	enum Table : uint8_t { MAIN, CB, ED, XX, XX_CB, DATA };
 
 	RowType rowType;
-	unsigned short addr;
-	char numBytes;
+	Table table;
+	uint8_t opcode;   // index in the mnemonic table
+	uint8_t numBytes;
+	uint16_t addr;
+	uint16_t operand; // address of an absolute or relative address operand
 	int infoLine;
-	std::string instr;
+	int symbol;       // AddressSymbolIndex position of the label or operand, -1 if none
+	uint8_t bytes[4];
+	// T-states (see InstructionTiming), zero for labels and data
+	uint8_t cycles;
+	uint8_t cyclesNotTaken;
+	// instruction transfers control (jump, call, return, ...)
+	bool blockEnd;
+
+	[[nodiscard]] bool hasAddressOperand() const;
 };
 
-static const DisasmRow DISABLED_ROW = {DisasmRow::INSTRUCTION, 0, 1, 0, "-       "};
+static const DisasmRow DISABLED_ROW = {DisasmRow::INSTRUCTION, DisasmRow::DATA, 0, 1, 0, 0, 0, -1,
+                                       {0, 0, 0, 0}, 0, 0, false};
 static const int FIRST_INFO_LINE = 1;
 static const int LAST_INFO_LINE = -65536;
 
@@ -26,5 +46,40 @@ using DisasmLines = std::vector<DisasmRow>;
 
 void dasm(const unsigned char* membuf, uint16_t startAddr, uint16_t endAddr, DisasmLines& disasm,
           MemoryLayout *memLayout, SymbolTable *symTable, int currentPC);
+// Same, but with the labels taken from the given index. This doesn't touch
+// the symbol table so it can run on a copy of the index in any thread.
+// 'endAddr' may be #10000, to keep the last instruction of the address
+// space whole.
+void dasm(const unsigned char* membuf, uint16_t startAddr, int endAddr, DisasmLines& disasm,
+          const AddressSymbolIndex& symbols, int currentPC);
+
+// Decodes the single instruction at 'pc', without looking up symbols.
+// 'membuf' must extend at least 3 bytes beyond 'pc'.
+DisasmRow dasmInstruction(const unsigned char* membuf, uint16_t pc);
+
+// 'value' as 'width' lower case hex digits
+std::string toHex(unsigned value, unsigned width);
+
+// Text of a row: the label name or the instruction, where the mnemonic
+// is padded to 7 characters. The symbol index must be the one the row
+// was disassembled with, or a later version of it.
+std::string disasmText(const DisasmRow& row, const AddressSymbolIndex& symbols);
+
+// Keeps the text of the most recently shown rows.
+class DisasmTextCache
+{
+public:
+	explicit DisasmTextCache(size_t capacity_ = 256) : capacity(capacity_) {}
+
+	const std::string& text(const DisasmRow& row, const AddressSymbolIndex& symbols);
+	void clear();
+
+private:
+	using Entry = std::pair<uint64_t, std::string>;
+
+	size_t capacity;
+	std::list<Entry> entries; // most recently used first
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> lookup;
+};
 
 #endif // DASM_H
@@ -0,0 +1,127 @@
+#include "DasmBenchmark.h"
+#include "Dasm.h"
+#include "DebuggerData.h"
+#include "SymbolTable.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// every run is repeated, the fastest one counts
+const int RUNS = 5;
+// more layouts than the table keeps indexes for, so each one is rebuilt
+const int NUM_LAYOUTS = 5;
+const int NUM_CHANGES = 1000;
+
+template<typename F> double fastest(F f)
+{
+	double best = 0;
+	for (int run = 0; run < RUNS; ++run) {
+		QElapsedTimer timer;
+		timer.start();
+		f();
+		double ms = timer.nsecsElapsed() * 1e-6;
+		if (run == 0 || ms < best) best = ms;
+	}
+	return best;
+}
+
+// pages in other slots each time, slot 3 is expanded
+std::vector<MemoryLayout> layouts()
+{
+	std::vector<MemoryLayout> result(NUM_LAYOUTS);
+	for (int i = 0; i < NUM_LAYOUTS; ++i) {
+		auto& ml = result[i];
+		ml.isSubslotted[3] = true;
+		ml.primarySlot[0] = (i / 4) & 3;
+		ml.primarySlot[1] = (i + 1) & 3;
+		ml.primarySlot[2] = (i + 2) & 3;
+		ml.primarySlot[3] = 3;
+		for (int page = 0; page < 4; ++page) {
+			ml.secondarySlot[page] = ml.primarySlot[page] == 3 ? i & 3 : -1;
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+int benchmarkDasm(const QStringList& args)
+{
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+	int numSymbols = 50000;
+	if (!args.isEmpty()) {
+		bool ok;
+		numSymbols = args[0].toInt(&ok);
+		if (!ok || numSymbols < 0 || args.size() > 1) {
+			err << "usage: openmsx-debugger --benchmark-dasm [SYMBOLS]\n";
+			return 1;
+		}
+	}
+
+	// random code, and symbols at random addresses of which a quarter is
+	// only valid in one slot
+	std::mt19937 random(12345);
+	std::vector<unsigned char> memory(0x10000 + 4);
+	for (auto& byte : memory) byte = uint8_t(random());
+	SymbolTable table;
+	std::vector<Symbol*> symbols;
+	for (int i = 0; i < numSymbols; ++i) {
+		auto* symbol = table.add(QString("label_%1").arg(i), int(random() & 0xFFFF));
+		if (i % 4 == 0) symbol->setValidSlots(uint16_t(1 << (random() & 15)));
+		symbols.push_back(symbol);
+	}
+	auto mls = layouts();
+
+	out << QString("%1 symbols, fastest of %2 runs\n").arg(numSymbols).arg(RUNS);
+
+	// building the index of a layout
+	int layout = 0;
+	double msBuild = fastest([&] {
+		for (int i = 0; i < NUM_LAYOUTS; ++i) {
+			(void)table.addressIndex(&mls[layout++ % NUM_LAYOUTS]);
+		}
+	}) / NUM_LAYOUTS;
+	const auto& index = table.addressIndex(&mls[0]);
+	out << QString("index build     %1 ms, %2 symbols in the layout\n")
+	       .arg(msBuild, 0, 'f', 3).arg(index.size());
+
+	// the complete address space, with and without symbols
+	DisasmLines rows;
+	AddressSymbolIndex noSymbols;
+	double msPlain = fastest([&] {
+		dasm(memory.data(), 0, 0xFFFF, rows, noSymbols, 0x20000);
+	});
+	double msSymbols = fastest([&] {
+		dasm(memory.data(), 0, 0xFFFF, rows, index, 0x20000);
+	});
+	int labels = 0, resolved = 0;
+	for (const auto& row : rows) {
+		if (row.rowType == DisasmRow::LABEL) {
+			++labels;
+		} else if (row.hasAddressOperand() && row.symbol != AddressSymbolIndex::NOT_FOUND) {
+			++resolved;
+		}
+	}
+	out << QString("dasm 64kB       %1 ms without symbols, %2 ms with symbols, %3 ns per row\n")
+	       .arg(msPlain, 0, 'f', 3).arg(msSymbols, 0, 'f', 3)
+	       .arg(msSymbols * 1e6 / rows.size(), 0, 'f', 1);
+	out << QString("                %1 rows, %2 labels, %3 operands resolved\n")
+	       .arg(rows.size()).arg(labels).arg(resolved);
+
+	// single changes patch the indexes that are kept
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < NUM_CHANGES && !symbols.empty(); ++i) {
+		symbols[random() % symbols.size()]->setValue(int(random() & 0xFFFF));
+	}
+	double usChange = timer.nsecsElapsed() * 1e-3 / NUM_CHANGES;
+	(void)table.addressIndex(&mls[0]);
+	out << QString("value change    %1 us, the kept indexes are patched\n")
+	       .arg(usChange, 0, 'f', 2);
+	return 0;
+}
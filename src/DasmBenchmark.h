@@ -0,0 +1,13 @@
+#ifndef DASMBENCHMARK_H
+#define DASMBENCHMARK_H
+
+#include <QStringList>
+
+// Batch mode, times dasm() over 64kB of code with many symbols loaded, and
+// the address index it resolves them with: building it for a layout and
+// keeping it up to date when symbols change. 'args' is the number of
+// symbols, 50000 when empty. Writes the timings to stdout and returns the
+// exit code.
+int benchmarkDasm(const QStringList& args);
+
+#endif // DASMBENCHMARK_H
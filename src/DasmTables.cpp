@@ -194,3 +194,190 @@ const char* const mnemonic_main[256] =
 	"ret p"    ,"pop af"   ,"jp p,A"   ,"di"        ,"call p,A" ,"push af"  ,"or B"      ,"rst 30h"  ,
 	"ret m"    ,"ld sp,hl" ,"jp m,A"   ,"ei"        ,"call m,A" ,"fd"       ,"cp B"      ,"rst 38h"
 };
+
+/*
+ * Instruction timings, see InstructionTiming. These are the regular Z80
+ * timings plus one wait state per M1 cycle (two for prefixed opcodes).
+ * The R800 only instructions (mulub, muluw) are left at zero because their
+ * duration is not expressed in Z80 T-states.
+ */
+
+const InstructionTiming timing_xx_cb[256] =
+{
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{22,22},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{ 0, 0}
+};
+
+const InstructionTiming timing_cb[256] =
+{
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{14,14},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{17,17},{10,10}
+};
+
+const InstructionTiming timing_ed[256] =
+{
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{14,14},{14,14},{17,17},{22,22},{10,10},{16,16},{10,10},{11,11},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{16,16},{ 0, 0},{11,11},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{ 0, 0},{10,10},{11,11},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{ 0, 0},{10,10},{11,11},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{ 0, 0},{ 0, 0},{20,20},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{ 0, 0},{ 0, 0},{20,20},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{14,14},{14,14},{17,17},{22,22},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{18,18},{18,18},{18,18},{18,18},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{18,18},{18,18},{18,18},{18,18},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{23,18},{23,18},{23,18},{23,18},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{23,18},{23,18},{23,18},{23,18},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0}
+};
+
+const InstructionTiming timing_xx[256] =
+{
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{17,17},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{17,17},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{16,16},{22,22},{12,12},{10,10},{10,10},{13,13},{ 0, 0},
+	{ 0, 0},{17,17},{22,22},{12,12},{10,10},{10,10},{13,13},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{25,25},{25,25},{21,21},{ 0, 0},
+	{ 0, 0},{17,17},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{21,21},{10,10},
+	{10,10},{10,10},{10,10},{10,10},{10,10},{10,10},{21,21},{10,10},
+	{21,21},{21,21},{21,21},{21,21},{21,21},{21,21},{ 0, 0},{21,21},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{10,10},{10,10},{21,21},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{16,16},{ 0, 0},{25,25},{ 0, 0},{17,17},{ 0, 0},{ 0, 0},
+	{ 0, 0},{10,10},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},
+	{ 0, 0},{12,12},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0},{ 0, 0}
+};
+
+const InstructionTiming timing_main[256] =
+{
+	{ 5, 5},{11,11},{ 8, 8},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{12,12},{ 8, 8},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{14, 9},{11,11},{ 8, 8},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{13,13},{12,12},{ 8, 8},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{13, 8},{11,11},{17,17},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{13, 8},{12,12},{17,17},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{13, 8},{11,11},{14,14},{ 7, 7},{12,12},{12,12},{11,11},{ 5, 5},
+	{13, 8},{12,12},{14,14},{ 7, 7},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 8, 8},{ 8, 8},{ 8, 8},{ 8, 8},{ 8, 8},{ 8, 8},{ 5, 5},{ 8, 8},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 5, 5},{ 8, 8},{ 5, 5},
+	{12, 6},{11,11},{11,11},{11,11},{18,11},{12,12},{ 8, 8},{12,12},
+	{12, 6},{11,11},{11,11},{ 0, 0},{18,11},{18,18},{ 8, 8},{12,12},
+	{12, 6},{11,11},{11,11},{12,12},{18,11},{12,12},{ 8, 8},{12,12},
+	{12, 6},{11,11},{11,11},{12,12},{18,11},{ 0, 0},{ 8, 8},{12,12},
+	{12, 6},{11,11},{11,11},{20,20},{18,11},{12,12},{ 8, 8},{12,12},
+	{12, 6},{ 5, 5},{11,11},{ 5, 5},{18,11},{ 0, 0},{ 8, 8},{12,12},
+	{12, 6},{11,11},{11,11},{ 5, 5},{18,11},{12,12},{ 8, 8},{12,12},
+	{12, 6},{ 7, 7},{11,11},{ 5, 5},{18,11},{ 0, 0},{ 8, 8},{12,12}
+};
@@ -1,10 +1,28 @@
 #ifndef DASMTABLES_H
 #define DASMTABLES_H
 
+#include <stdint.h>
+
 extern const char* const mnemonic_xx_cb[256];
 extern const char* const mnemonic_cb[256];
 extern const char* const mnemonic_ed[256];
 extern const char* const mnemonic_xx[256];
 extern const char* const mnemonic_main[256];
 
+// Duration of an instruction in T-states as seen on an MSX, so including
+// the extra wait state the MSX inserts in every M1 cycle. 'taken' applies
+// when a conditional jump/call/return is taken or when a block instruction
+// repeats, 'notTaken' otherwise. Both are equal for all other instructions
+// and both are zero when the duration is unknown (invalid opcodes).
+struct InstructionTiming {
+	uint8_t taken;
+	uint8_t notTaken;
+};
+
+extern const InstructionTiming timing_xx_cb[256];
+extern const InstructionTiming timing_cb[256];
+extern const InstructionTiming timing_ed[256];
+extern const InstructionTiming timing_xx[256];
+extern const InstructionTiming timing_main[256];
+
 #endif // DASMTABLES_H
@@ -3,8 +3,10 @@
 #include "ranges.h"
 #include <qglobal.h>
 #include <QStringList>
+#include <QSet>
 #include <QDebug>
 #include <algorithm>
+#include <unordered_set>
 // class MemoryLayout
 
 static const char* const TypeNames[] = { "breakpoint", "memread", "memwrite", "ioread", "iowrite",
@@ -62,25 +64,31 @@ bool Breakpoint::operator==(const Breakpoint &bp) const
 		// compare slot
 		if (bp.slot.ps != slot.ps || bp.slot.ss != slot.ss || bp.segment != segment) return false;
 	}
-	// compare condition
-	return bp.condition == condition;
+	// compare condition, trace and recording
+	return bp.condition == condition && bp.trace == trace && bp.record == record;
 }
 
 void Breakpoints::clear()
 {
 	breakpoints.clear();
+	addressFlags.clear();
 }
 
 void Breakpoints::setMemoryLayout(MemoryLayout* ml)
 {
 	memLayout = ml;
+	addressFlags.clear();
 }
 
 QString Breakpoints::createSetCommand(Breakpoint::Type type, std::optional<AddressRange> range,
                                       Slot slot, std::optional<uint8_t> segment,
-                                      QString condition)
+                                      QString condition, QString trace, bool record)
 {
-	QString cmd("debug %1 %2 %3");
+	// a recording watchpoint logs the writes, a tracepoint gets a trace
+	// tag and logs its expression, both instead of breaking
+	record = record && type == Breakpoint::WATCHPOINT_MEMWRITE;
+	trace = record ? QString() : trace.trimmed();
+	QString cmd(trace.isEmpty() ? "debug %1 %2 %3" : "debug_set_trace %1 %2 %3");
 	QString addr, cond;
 	condition = condition.trimmed();
 
@@ -104,9 +112,13 @@ QString Breakpoints::createSetCommand(Breakpoint::Type type, std::optional<Addre
 		       .arg(segment ? QString::number(*segment) : "X")
 		       .arg(condition.isEmpty() ? QString() : QString("&& ( %1 ) ").arg(condition));
 	}
-	return cmd.arg(BreakpointSetCodes[type])
-	          .arg(addr)
-	          .arg(escapeXML(cond));
+	cmd = cmd.arg(BreakpointSetCodes[type])
+	         .arg(addr)
+	         .arg(escapeXML(cond));
+	// the expression goes last, so it isn't touched by arg()
+	if (!trace.isEmpty()) cmd += ' ' + escapeXML('{' + trace + '}');
+	if (record) cmd += " debug_write_log";
+	return cmd;
 }
 
 QString Breakpoints::createRemoveCommand(const QString& id)
@@ -125,83 +137,191 @@ QString Breakpoints::createRemoveCommand(const QString& id)
 
 void Breakpoints::setBreakpoints(const QString& str)
 {
-	breakpoints.clear();
+	clear();
 
 	QStringList bps = str.split('\n');
+	for (auto& line : bps) {
+		if (auto bp = parseBreakpoint(line)) {
+			insertBreakpoint(*bp);
+		}
+	}
+}
+
+QStringList Breakpoints::addBreakpoints(const QString& str)
+{
+	std::vector<Breakpoint> bps;
+	QStringList lines = str.split('\n');
+	for (auto& line : lines) {
+		if (auto bp = parseBreakpoint(line)) {
+			bps.push_back(std::move(*bp));
+		}
+	}
+	return addBreakpoints(std::move(bps));
+}
+
+QStringList Breakpoints::addBreakpoints(std::vector<Breakpoint> bps)
+{
+	QSet<QString> known;
+	known.reserve(int(breakpoints.size() + bps.size()));
+	for (const auto& bp : breakpoints) known.insert(bp.id);
+
+	QStringList added;
 	for (auto& bp : bps) {
-		if (bp.trimmed().isEmpty()) continue;
-
-		Breakpoint newBp;
-
-		// set id
-		int p = 0;
-		newBp.id = getNextArgument(bp, p);
-
-		// determine type
-		if (bp.startsWith("bp#")) {
-			newBp.type = Breakpoint::BREAKPOINT;
-		} else if (bp.startsWith("wp#")) {
-			// determine watchpoint type
-			static const char* const WpTypeNames[] = {"read_mem", "write_mem", "read_io", "write_io"};
-			QString wpType = getNextArgument(bp, p);
-			if (auto it = ranges::find(WpTypeNames, wpType); it != std::end(WpTypeNames)) {
-				newBp.type = static_cast<Breakpoint::Type>(std::distance(WpTypeNames, it) + 1);
-			} else {
-				continue;
-			}
-		} else if (bp.startsWith("cond#")) {
-			newBp.type = Breakpoint::CONDITION;
-		} else { // unknown
-			continue;
+		if (known.contains(bp.id)) continue;
+		known.insert(bp.id);
+		added << bp.id;
+		breakpoints.push_back(std::move(bp));
+	}
+	if (added.isEmpty()) return added;
+
+	// the order of insertBreakpoint(), in one pass
+	std::stable_sort(breakpoints.begin(), breakpoints.end(), [](const auto& a, const auto& b) {
+		return (a.range ? a.range->start : -1) < (b.range ? b.range->start : -1);
+	});
+	addressFlags.clear();
+	return added;
+}
+
+bool Breakpoints::removeBreakpoint(const QString& id)
+{
+	auto index = findBreakpoint(id);
+	if (!index) return false;
+	breakpoints.erase(breakpoints.begin() + *index);
+	addressFlags.clear();
+	return true;
+}
+
+// position of the opening brace of the last braced word in 'line', or -1
+static int lastBracedWord(const QString& line)
+{
+	int depth = 0;
+	for (int i = line.size() - 1; i >= 0; --i) {
+		if (line[i] == '}') {
+			++depth;
+		} else if (line[i] == '{' && depth > 0 && --depth == 0) {
+			return i;
 		}
+	}
+	return -1;
+}
 
-		// get address
-		p++;
-		if (newBp.type != Breakpoint::CONDITION) {
-			if (bp[p] == '{') {
-				p++;
-				auto s = getNextArgument(bp, p);
-				auto start = stringToValue<uint16_t>(s);
-				if (!start) continue;
-				newBp.range = AddressRange(*start);
-				int q = bp.indexOf('}', p);
-				auto end = stringToValue<uint16_t>(bp.mid(p, q - p));
-				newBp.range->end = end;
-				p = q + 1;
-			} else {
-				auto s = getNextArgument(bp, p);
-				auto start = stringToValue<uint16_t>(s);
-				if (!start) continue;
-				newBp.range = AddressRange(*start);
-			}
+// the '{debug_trace <tag> <expression>}' command of a tracepoint
+static bool parseTrace(const QString& command, Breakpoint& bp)
+{
+	static const QString prefix = "{debug_trace ";
+	if (!command.startsWith(prefix) || !command.endsWith('}')) return false;
+	QString args = command.mid(prefix.size(), command.size() - prefix.size() - 1).trimmed();
+	int space = args.indexOf(' ');
+	if (space < 0) return false;
+	bool ok;
+	bp.traceTag = args.left(space).toInt(&ok);
+	if (!ok) return false;
+	QString expression = args.mid(space + 1).trimmed();
+	if (expression.startsWith('{') && expression.endsWith('}')) {
+		expression = expression.mid(1, expression.size() - 2);
+	}
+	bp.trace = unescapeXML(expression);
+	return !bp.trace.isEmpty();
+}
+
+// a line of debug_list_all_breaks, empty for unknown or non-default ones
+std::optional<Breakpoint> Breakpoints::parseBreakpoint(QString& bp)
+{
+	if (bp.trimmed().isEmpty()) return {};
+
+	Breakpoint newBp;
+
+	// set id
+	int p = 0;
+	newBp.id = getNextArgument(bp, p);
+
+	// determine type
+	if (bp.startsWith("bp#")) {
+		newBp.type = Breakpoint::BREAKPOINT;
+	} else if (bp.startsWith("wp#")) {
+		// determine watchpoint type
+		static const char* const WpTypeNames[] = {"read_mem", "write_mem", "read_io", "write_io"};
+		QString wpType = getNextArgument(bp, p);
+		if (auto it = ranges::find(WpTypeNames, wpType); it != std::end(WpTypeNames)) {
+			newBp.type = static_cast<Breakpoint::Type>(std::distance(WpTypeNames, it) + 1);
+		} else {
+			return {};
 		}
-		// check and clip command (skip non-default commands)
-		int q = bp.lastIndexOf('{');
-		if (bp.mid(q).simplified() != "{debug break}") continue;
+	} else if (bp.startsWith("cond#")) {
+		newBp.type = Breakpoint::CONDITION;
+	} else { // unknown
+		return {};
+	}
 
-		newBp.condition = unescapeXML(bp.mid(p, q - p).trimmed());
-		parseCondition(newBp);
-		insertBreakpoint(newBp);
+	// get address
+	p++;
+	if (newBp.type != Breakpoint::CONDITION) {
+		if (bp[p] == '{') {
+			p++;
+			auto s = getNextArgument(bp, p);
+			auto start = stringToValue<uint16_t>(s);
+			if (!start) return {};
+			newBp.range = AddressRange(*start);
+			int q = bp.indexOf('}', p);
+			auto end = stringToValue<uint16_t>(bp.mid(p, q - p));
+			newBp.range->end = end;
+			p = q + 1;
+		} else {
+			auto s = getNextArgument(bp, p);
+			auto start = stringToValue<uint16_t>(s);
+			if (!start) return {};
+			newBp.range = AddressRange(*start);
+		}
 	}
+	// check and clip command (skip non-default commands)
+	int q = lastBracedWord(bp);
+	if (q < 0) return {};
+	QString command = bp.mid(q).simplified();
+	if (command == "{debug_write_log}") {
+		newBp.record = true;
+	} else if (command != "{debug break}" && !parseTrace(command, newBp)) {
+		return {};
+	}
+
+	newBp.condition = unescapeXML(bp.mid(p, q - p).trimmed());
+	parseCondition(newBp);
+	return newBp;
+}
+
+// consistent with Breakpoint::operator==
+static size_t contentHash(const Breakpoint& bp)
+{
+	size_t h = ((qHash(bp.condition) * 31 + qHash(bp.trace)) * 31 + bp.record) * 31 + bp.type;
+	if (bp.type != Breakpoint::CONDITION) {
+		h = h * 31 + bp.range->start;
+		if (bp.type != Breakpoint::BREAKPOINT) {
+			h = h * 31 + (bp.range->end ? *bp.range->end + 1 : 0);
+		}
+		h = h * 31 + (bp.slot.ps ? *bp.slot.ps + 1 : 0);
+		h = h * 31 + (bp.slot.ss ? *bp.slot.ss + 1 : 0);
+		h = h * 31 + (bp.segment ? *bp.segment + 1 : 0);
+	}
+	return h;
 }
 
 QString Breakpoints::mergeBreakpoints(const QString& str)
 {
-	// copy breakpoints
-	auto oldBps = breakpoints;
+	// keep the old breakpoints
+	auto oldBps = std::move(breakpoints);
 	// parse new list
 	setBreakpoints(str);
-	// check old list against new one
+	// check old list against new one, on content
+	auto hash = [](const Breakpoint* bp) { return contentHash(*bp); };
+	auto equal = [](const Breakpoint* a, const Breakpoint* b) { return *a == *b; };
+	std::unordered_set<const Breakpoint*, decltype(hash), decltype(equal)>
+		newBps(breakpoints.size(), hash, equal);
+	for (const auto& bp : breakpoints) newBps.insert(&bp);
+
 	QStringList mergeSet;
 	for (const auto& old : oldBps) {
-		auto newit = breakpoints.begin();
-		for (/**/; newit != breakpoints.end(); ++newit) {
-			// check for identical data
-			if (old  == *newit) break;
-		}
-		if (newit == breakpoints.end()) {
+		if (!newBps.count(&old)) {
 			// create command to set this breakpoint again
-			QString cmd = createSetCommand(old.type, old.range, old.slot, old.segment, old.condition);
+			QString cmd = createSetCommand(old.type, old.range, old.slot, old.segment, old.condition, old.trace, old.record);
 			mergeSet << cmd;
 		}
 	}
@@ -271,15 +391,62 @@ void Breakpoints::insertBreakpoint(Breakpoint& bp)
 {
 	auto it = ranges::upper_bound(breakpoints, bp.range->start, {}, [](auto& bp) { return bp.range ? bp.range->start : -1; });
 	breakpoints.insert(it, bp);
+	addressFlags.clear();
 }
 
-int Breakpoints::breakpointCount()
+// the parts of the layout that inCurrentSlot() looks at
+static bool sameSlotSelection(const MemoryLayout& a, const MemoryLayout& b)
+{
+	return std::equal(std::begin(a.primarySlot), std::end(a.primarySlot), std::begin(b.primarySlot))
+	    && std::equal(std::begin(a.secondarySlot), std::end(a.secondarySlot), std::begin(b.secondarySlot))
+	    && std::equal(std::begin(a.mapperSegment), std::end(a.mapperSegment), std::begin(b.mapperSegment))
+	    && std::equal(std::begin(a.isSubslotted), std::end(a.isSubslotted), std::begin(b.isSubslotted))
+	    && std::equal(&a.mapperSize[0][0], &a.mapperSize[0][0] + 16, &b.mapperSize[0][0]);
+}
+
+uint8_t Breakpoints::flagsAt(uint16_t addr)
+{
+	// the layout is changed in place by the slot viewer, so compare it
+	if (addressFlags.empty() || (memLayout && !sameSlotSelection(*memLayout, flagsLayout))) {
+		buildAddressFlags();
+	}
+	return addressFlags[addr];
+}
+
+void Breakpoints::buildAddressFlags()
+{
+	addressFlags.assign(0x10000, 0);
+	if (memLayout) flagsLayout = *memLayout;
+
+	for (const auto& bp : breakpoints) {
+		uint8_t flags;
+		if (bp.type == Breakpoint::BREAKPOINT) {
+			flags = BREAK_ANY | (inCurrentSlot(bp) ? BREAK_SLOT : 0);
+		} else if (bp.type == Breakpoint::WATCHPOINT_MEMREAD || bp.type == Breakpoint::WATCHPOINT_MEMWRITE) {
+			flags = WATCH_ANY | (inCurrentSlot(bp) ? WATCH_SLOT : 0);
+		} else {
+			continue;
+		}
+		assert(bp.range);
+		// a breakpoint only ever covers its start address
+		int last = bp.type == Breakpoint::BREAKPOINT || !bp.range->end
+		         ? bp.range->start : *bp.range->end;
+		for (int addr = bp.range->start; addr <= last; ++addr) {
+			addressFlags[addr] |= flags;
+		}
+	}
+}
+
+int Breakpoints::breakpointCount() const
 {
 	return breakpoints.size();
 }
 
 bool Breakpoints::isBreakpoint(uint16_t addr, QString* id, bool checkSlot)
 {
+	if (!(flagsAt(addr) & (checkSlot ? BREAK_SLOT : BREAK_ANY))) return false;
+	if (!id) return true;
+
 	if (std::optional<uint16_t> index = findBreakpoint(addr)) {
 		for (auto i = *index; i < breakpointCount() && breakpoints[i].range && breakpoints[i].range->start == addr; i++) {
 			const auto& bp = breakpoints[i];
@@ -294,6 +461,9 @@ bool Breakpoints::isBreakpoint(uint16_t addr, QString* id, bool checkSlot)
 
 bool Breakpoints::isWatchpoint(quint16 addr, QString* id, bool checkSlot)
 {
+	if (!(flagsAt(addr) & (checkSlot ? WATCH_SLOT : WATCH_ANY))) return false;
+	if (!id) return true;
+
 	for (const auto& bp : breakpoints) {
 		if (bp.type == Breakpoint::WATCHPOINT_MEMREAD || bp.type == Breakpoint::WATCHPOINT_MEMWRITE) {
 			assert(bp.range);
@@ -319,7 +489,32 @@ Breakpoints::findBreakpoint(uint16_t addr)
 	return {};
 }
 
-const Breakpoint& Breakpoints::getBreakpoint(int index)
+std::optional<int> Breakpoints::findBreakpoint(const QString& id) const
+{
+	if (auto it = ranges::find(breakpoints, id, &Breakpoint::id); it != breakpoints.end()) {
+		return int(std::distance(breakpoints.begin(), it));
+	}
+	return {};
+}
+
+bool Breakpoints::hasTracepoints() const
+{
+	return std::any_of(breakpoints.begin(), breakpoints.end(),
+	                   [](const auto& bp) { return !bp.trace.isEmpty(); });
+}
+
+bool Breakpoints::hasRecordingWatchpoints() const
+{
+	return std::any_of(breakpoints.begin(), breakpoints.end(),
+	                   [](const auto& bp) { return bp.record; });
+}
+
+void Breakpoints::setTraceHits(QHash<int, unsigned> newHits)
+{
+	hits = std::move(newHits);
+}
+
+const Breakpoint& Breakpoints::getBreakpoint(int index) const
 {
 	assert((long unsigned) index < breakpoints.size());
 	return breakpoints[index];
@@ -354,6 +549,8 @@ void Breakpoints::saveBreakpoints(QXmlStreamWriter& xml)
 
 		// condition
 		xml.writeTextElement("condition", bp.condition);
+		if (!bp.trace.isEmpty()) xml.writeTextElement("trace", bp.trace);
+		if (bp.record) xml.writeTextElement("record", "true");
 
 		// complete
 		xml.writeEndElement();
@@ -386,6 +583,8 @@ void Breakpoints::loadBreakpoints(QXmlStreamReader& xml)
 
 				// id
 				bp.id = xml.attributes().value("id").toString();
+				bp.trace.clear();
+				bp.record = false;
 
 				// slot/segment
 				char c = xml.attributes().value("primarySlot").at(0).toLatin1();
@@ -408,6 +607,10 @@ void Breakpoints::loadBreakpoints(QXmlStreamReader& xml)
 				bp.range->end = stringToValue<uint16_t>(xml.readElementText());
 			} else if (xml.name() == "condition") {
 				bp.condition = xml.readElementText().trimmed();
+			} else if (xml.name() == "trace") {
+				bp.trace = xml.readElementText().trimmed();
+			} else if (xml.name() == "record") {
+				bp.record = xml.readElementText().trimmed() == "true";
 			}
 		}
 	}
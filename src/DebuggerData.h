@@ -1,7 +1,9 @@
 #ifndef DEBUGGERDATA_H
 #define DEBUGGERDATA_H
 
+#include <QHash>
 #include <QString>
+#include <QStringList>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <optional>
@@ -56,6 +58,12 @@ struct Breakpoint {
 	std::optional<uint8_t> segment; 
 	// general condition
 	QString condition;
+	// expression that is logged instead of breaking, when not empty
+	QString trace;
+	// tag of the records of a trace in openMSX
+	int traceTag = 0;
+	// a write watchpoint that logs the writes instead of breaking
+	bool record = false;
 	// compare content
 	bool operator==(const Breakpoint &bp) const;
 
@@ -72,7 +80,11 @@ public:
 	void setMemoryLayout(MemoryLayout* ml);
 	void setBreakpoints(const QString& str);
 	QString mergeBreakpoints(const QString& str);
-	int breakpointCount();
+	// Adds the breakpoints in 'str' that aren't known yet, returns their ids.
+	QStringList addBreakpoints(const QString& str);
+	QStringList addBreakpoints(std::vector<Breakpoint> bps);
+	bool removeBreakpoint(const QString& id);
+	int breakpointCount() const;
 	bool isBreakpoint(uint16_t addr, QString *id = nullptr, bool checkSlot = true);
 	bool isWatchpoint(uint16_t addr, QString *id = nullptr, bool checkSlot = true);
 
@@ -81,21 +93,43 @@ public:
 	void loadBreakpoints(QXmlStreamReader& xml);
 
 	std::optional<uint16_t> findBreakpoint(uint16_t addr);
+	std::optional<int> findBreakpoint(const QString& id) const;
 
 	static QString createSetCommand(Breakpoint::Type type, std::optional<AddressRange> range = {},
 	                                Slot slot = {}, std::optional<uint8_t> segment = {},
-                                    QString condition = {});
+                                    QString condition = {}, QString trace = {}, bool record = false);
 	static QString createRemoveCommand(const QString& id);
 
-	const Breakpoint& getBreakpoint(int index);
+	const Breakpoint& getBreakpoint(int index) const;
 	bool inCurrentSlot(const Breakpoint& bp);
+
+	// hit counts of the tracepoints per trace tag, from openMSX
+	bool hasTracepoints() const;
+	bool hasRecordingWatchpoints() const;
+	void setTraceHits(QHash<int, unsigned> hits);
+	[[nodiscard]] unsigned traceHits(const Breakpoint& bp) const { return hits.value(bp.traceTag); }
 private:
 
 	std::vector<Breakpoint> breakpoints;
 	MemoryLayout* memLayout = nullptr;
-
+	QHash<int, unsigned> hits; // kept when the breakpoints are reloaded
+
+	// Per address, the kinds of breakpoints that cover it, with and without
+	// the slot check. The disassembler asks for every visible row on each
+	// repaint, so this is rebuilt on the next query after the breakpoints
+	// or the slot selection changed, instead of searching every time.
+	enum AddressFlag : uint8_t {
+		BREAK_ANY = 1 << 0, WATCH_ANY = 1 << 1,
+		BREAK_SLOT = 1 << 2, WATCH_SLOT = 1 << 3
+	};
+	std::vector<uint8_t> addressFlags; // empty when outdated
+	MemoryLayout flagsLayout; // the layout the slot flags were built for
+
+	std::optional<Breakpoint> parseBreakpoint(QString& line);
 	void parseCondition(Breakpoint& bp);
 	void insertBreakpoint(Breakpoint& bp);
+	uint8_t flagsAt(uint16_t addr);
+	void buildAddressFlags();
 };
 
 #endif // DEBUGGERDATA_H
@@ -17,12 +17,22 @@
 #include "BreakpointDialog.h"
 #include "CommandDialog.h"
 #include "GotoDialog.h"
+#include "ExportDisasmDialog.h"
+#include "OpenImageDialog.h"
+#include "ExecutionPreviewDialog.h"
 #include "DebuggableViewer.h"
+#include "DisasmSearchViewer.h"
+#include "PeepholeViewer.h"
+#include "VramTimingViewer.h"
+#include "SourceViewer.h"
+#include "TraceViewer.h"
+#include "CodeAnalyzer.h"
 #include "VDPRegViewer.h"
 #include "VDPStatusRegViewer.h"
 #include "VDPCommandRegViewer.h"
 #include "Settings.h"
 #include "Version.h"
+#include "Convert.h"
 #include <QAction>
 #include <QMessageBox>
 #include <QMenu>
@@ -39,6 +49,7 @@
 #include <QPixmap>
 #include <QFileDialog>
 #include <QCloseEvent>
+#include <QSet>
 #include <iostream>
 
 class QueryPauseHandler : public SimpleCommand
@@ -165,6 +176,9 @@ DebuggerForm::DebuggerForm(QWidget* parent)
 	updateRecentFiles();
 
 	connect(&session.symbolTable(), &SymbolTable::symbolFileChanged, this, &DebuggerForm::symbolFileChanged);
+	connect(&session.symbolTable(), &SymbolTable::symbolsReloaded, disasmView, &DisasmViewer::symbolsReloaded);
+	connect(&session.symbolTable(), &SymbolTable::symbolsReloaded, bpView, &BreakpointViewer::onSymbolsReloaded);
+	connect(&session.symbolTable(), &SymbolTable::sourceLinesChanged, disasmView, [this] { disasmView->update(); });
 }
 
 void DebuggerForm::createActions()
@@ -183,6 +197,10 @@ void DebuggerForm::createActions()
 	fileSaveSessionAsAction = new QAction(tr("Save Session &As"), this);
 	fileSaveSessionAsAction->setStatusTip(tr("Save the debug session in a selected file"));
 
+	fileExportDisasmAction = new QAction(tr("&Export Disassembly ..."), this);
+	fileExportDisasmAction->setStatusTip(tr("Write the disassembly of a complete debuggable to a source file"));
+	fileExportDisasmAction->setEnabled(false);
+
 	fileQuitAction = new QAction(tr("&Quit"), this);
 	fileQuitAction->setShortcut(tr("Ctrl+Q"));
 	fileQuitAction->setStatusTip(tr("Quit the openMSX debugger"));
@@ -207,6 +225,9 @@ void DebuggerForm::createActions()
 	systemDisconnectAction->setIcon(QIcon(":/icons/disconnect.png"));
 	systemDisconnectAction->setEnabled(false);
 
+	systemOpenImageAction = new QAction(tr("Open &Image ..."), this);
+	systemOpenImageAction->setStatusTip(tr("Examine a ROM image or memory dump without openMSX"));
+
 	systemPauseAction = new QAction(tr("&Pause emulator"), this);
 	systemPauseAction->setShortcut(Qt::Key_Pause);
 	systemPauseAction->setStatusTip(tr("Pause the emulation"));
@@ -222,6 +243,10 @@ void DebuggerForm::createActions()
 	systemSymbolManagerAction->setStatusTip(tr("Start the symbol manager"));
 	systemSymbolManagerAction->setIcon(QIcon(":/icons/symmanager.png"));
 
+	systemAnalyzeCodeAction = new QAction(tr("&Analyze code"), this);
+	systemAnalyzeCodeAction->setStatusTip(tr("Find the routines, their worst case stack use and their loops at every break"));
+	systemAnalyzeCodeAction->setCheckable(true);
+
 	systemPreferencesAction = new QAction(tr("Pre&ferences ..."), this);
 	systemPreferencesAction->setStatusTip(tr("Set the global debugger preferences"));
 
@@ -256,6 +281,21 @@ void DebuggerForm::createActions()
 	viewDebuggableViewerAction = new QAction(tr("Add debuggable viewer"), this);
 	viewDebuggableViewerAction->setStatusTip(tr("Add a hex viewer for debuggables"));
 
+	viewDisasmSearchAction = new QAction(tr("Add disassembly search"), this);
+	viewDisasmSearchAction->setStatusTip(tr("Add a search in the disassembly of memory or a debuggable"));
+
+	viewPeepholeAction = new QAction(tr("Add optimization hints"), this);
+	viewPeepholeAction->setStatusTip(tr("Add a list of cheaper instruction sequences for the analyzed code"));
+
+	viewVramTimingAction = new QAction(tr("Add VRAM timing check"), this);
+	viewVramTimingAction->setStatusTip(tr("Add a list of VRAM accesses in the analyzed code that may be too fast for the VDP"));
+
+	viewSourceAction = new QAction(tr("Add source view"), this);
+	viewSourceAction->setStatusTip(tr("Add a view of the source line of the program counter, from the loaded SLD files"));
+
+	viewTraceAction = new QAction(tr("Add trace log"), this);
+	viewTraceAction->setStatusTip(tr("Add a view of the values that the tracepoints logged"));
+
 	viewVDPStatusRegsAction = new QAction(tr("Status Registers"), this);
 	viewVDPStatusRegsAction->setStatusTip(tr("The VDP status registers interpreted"));
 	viewVDPStatusRegsAction->setCheckable(true);
@@ -303,6 +343,12 @@ void DebuggerForm::createActions()
 	executeStepOverAction->setIcon(QIcon(":/icons/stepover.png"));
 	executeStepOverAction->setEnabled(false);
 	connect(this, &DebuggerForm::runStateEntered,   [this]{ executeStepOverAction->setEnabled(false); });
+	connect(this, &DebuggerForm::runStateEntered,   [this]{
+		// forget the predicted next PC, and any prediction still underway
+		++stepPrediction;
+		executeStepAction->setToolTip(QString());
+		executeStepOverAction->setToolTip(QString());
+	});
 	connect(this, &DebuggerForm::breakStateEntered, [this]{ executeStepOverAction->setEnabled(true); });
 
 	executeStepOutAction = new QAction(tr("Step out"), this);
@@ -329,6 +375,12 @@ void DebuggerForm::createActions()
 	connect(this, &DebuggerForm::runStateEntered,   [this]{ executeRunToAction->setEnabled(false); });
 	connect(this, &DebuggerForm::breakStateEntered, [this]{ executeRunToAction->setEnabled(true); });
 
+	executePreviewAction = new QAction(tr("Preview execution ..."), this);
+	executePreviewAction->setStatusTip(tr("Show what the next instructions will do, without running the emulator"));
+	executePreviewAction->setEnabled(false);
+	connect(this, &DebuggerForm::runStateEntered,   [this]{ executePreviewAction->setEnabled(false); });
+	connect(this, &DebuggerForm::breakStateEntered, [this]{ executePreviewAction->setEnabled(true); });
+
 	breakpointToggleAction = new QAction(tr("Toggle"), this);
 	breakpointToggleAction->setShortcut(tr("F5"));
 	breakpointToggleAction->setStatusTip(tr("Toggle breakpoint on/off at cursor"));
@@ -351,13 +403,16 @@ void DebuggerForm::createActions()
 	connect(fileOpenSessionAction, &QAction::triggered, this, &DebuggerForm::fileOpenSession);
 	connect(fileSaveSessionAction, &QAction::triggered, this, &DebuggerForm::fileSaveSession);
 	connect(fileSaveSessionAsAction, &QAction::triggered, this, &DebuggerForm::fileSaveSessionAs);
+	connect(fileExportDisasmAction, &QAction::triggered, this, &DebuggerForm::fileExportDisasm);
 	connect(fileQuitAction, &QAction::triggered, this, &DebuggerForm::close);
 	connect(copyCodeViewAction, &QAction::triggered, this, &DebuggerForm::copyCodeView);
 	connect(systemConnectAction, &QAction::triggered, this, &DebuggerForm::systemConnect);
 	connect(systemDisconnectAction, &QAction::triggered, this, &DebuggerForm::systemDisconnect);
+	connect(systemOpenImageAction, &QAction::triggered, this, &DebuggerForm::systemOpenImage);
 	connect(systemPauseAction, &QAction::triggered, this, &DebuggerForm::systemPause);
 	connect(systemRebootAction, &QAction::triggered, this, &DebuggerForm::systemReboot);
 	connect(systemSymbolManagerAction, &QAction::triggered, this, &DebuggerForm::systemSymbolManager);
+	connect(systemAnalyzeCodeAction, &QAction::toggled, this, &DebuggerForm::systemAnalyzeCode);
 	connect(systemPreferencesAction, &QAction::triggered, this, &DebuggerForm::systemPreferences);
 	connect(searchGotoAction, &QAction::triggered, this, &DebuggerForm::searchGoto);
 	connect(viewRegistersAction, &QAction::triggered, this, &DebuggerForm::toggleRegisterDisplay);
@@ -367,6 +422,11 @@ void DebuggerForm::createActions()
 	connect(viewSlotsAction, &QAction::triggered, this, &DebuggerForm::toggleSlotsDisplay);
 	connect(viewMemoryAction, &QAction::triggered, this, &DebuggerForm::toggleMemoryDisplay);
 	connect(viewDebuggableViewerAction, &QAction::triggered, this, &DebuggerForm::addDebuggableViewer);
+	connect(viewDisasmSearchAction, &QAction::triggered, this, &DebuggerForm::addDisasmSearch);
+	connect(viewPeepholeAction, &QAction::triggered, this, &DebuggerForm::addPeepholeViewer);
+	connect(viewVramTimingAction, &QAction::triggered, this, &DebuggerForm::addVramTimingViewer);
+	connect(viewSourceAction, &QAction::triggered, this, &DebuggerForm::addSourceViewer);
+	connect(viewTraceAction, &QAction::triggered, this, &DebuggerForm::addTraceViewer);
 	connect(viewBitMappedAction, &QAction::triggered, this, &DebuggerForm::toggleBitMappedDisplay);
 	connect(viewCharMappedAction, &QAction::triggered, this, &DebuggerForm::toggleCharMappedDisplay);
 	connect(viewSpritesAction, &QAction::triggered, this, &DebuggerForm::toggleSpritesDisplay);
@@ -378,6 +438,7 @@ void DebuggerForm::createActions()
 	connect(executeStepAction, &QAction::triggered, this, &DebuggerForm::executeStep);
 	connect(executeStepOverAction, &QAction::triggered, this, &DebuggerForm::executeStepOver);
 	connect(executeRunToAction, &QAction::triggered, this, &DebuggerForm::executeRunTo);
+	connect(executePreviewAction, &QAction::triggered, this, &DebuggerForm::executePreview);
 	connect(executeStepOutAction, &QAction::triggered, this, &DebuggerForm::executeStepOut);
 	connect(executeStepBackAction, &QAction::triggered, this, &DebuggerForm::executeStepBack);
 	connect(breakpointToggleAction, &QAction::triggered, this, &DebuggerForm::toggleBreakpoint);
@@ -394,6 +455,8 @@ void DebuggerForm::createMenus()
 	fileMenu->addAction(fileOpenSessionAction);
 	fileMenu->addAction(fileSaveSessionAction);
 	fileMenu->addAction(fileSaveSessionAsAction);
+	fileMenu->addSeparator();
+	fileMenu->addAction(fileExportDisasmAction);
 
 	recentFileSeparator = fileMenu->addSeparator();
 	for (auto* rfa : recentFileActions)
@@ -410,12 +473,14 @@ void DebuggerForm::createMenus()
 	systemMenu = menuBar()->addMenu(tr("&System"));
 	systemMenu->addAction(systemConnectAction);
 	systemMenu->addAction(systemDisconnectAction);
+	systemMenu->addAction(systemOpenImageAction);
 	systemMenu->addSeparator();
 	systemMenu->addAction(systemPauseAction);
 	systemMenu->addSeparator();
 	systemMenu->addAction(systemRebootAction);
 	systemMenu->addSeparator();
 	systemMenu->addAction(systemSymbolManagerAction);
+	systemMenu->addAction(systemAnalyzeCodeAction);
 	systemMenu->addSeparator();
 	systemMenu->addAction(systemPreferencesAction);
 
@@ -435,6 +500,11 @@ void DebuggerForm::createMenus()
 	viewMenu->addSeparator();
 	viewFloatingWidgetsMenu = viewMenu->addMenu("Floating widgets:");
 	viewMenu->addAction(viewDebuggableViewerAction);
+	viewMenu->addAction(viewDisasmSearchAction);
+	viewMenu->addAction(viewPeepholeAction);
+	viewMenu->addAction(viewVramTimingAction);
+	viewMenu->addAction(viewSourceAction);
+	viewMenu->addAction(viewTraceAction);
 	connect(viewMenu, &QMenu::aboutToShow, this, &DebuggerForm::updateViewMenu);
 
 	// create VDP dialogs menu
@@ -459,6 +529,8 @@ void DebuggerForm::createMenus()
 	executeMenu->addAction(executeStepOutAction);
 	executeMenu->addAction(executeStepBackAction);
 	executeMenu->addAction(executeRunToAction);
+	executeMenu->addSeparator();
+	executeMenu->addAction(executePreviewAction);
 
 	// create breakpoint menu
 	breakpointMenu = menuBar()->addMenu(tr("&Breakpoint"));
@@ -520,6 +592,10 @@ void DebuggerForm::createStatusbar()
 {
 	// create the statusbar
 	statusBar()->showMessage("No emulation running.");
+
+	// timing of the selected code, filled in by the disasm viewer
+	cyclesLabel = new QLabel();
+	statusBar()->addPermanentWidget(cyclesLabel);
 }
 
 void DebuggerForm::createForm()
@@ -535,6 +611,7 @@ void DebuggerForm::createForm()
 
 	// create the disasm viewer widget
 	disasmView = new DisasmViewer();
+	codeAnalyzer = new CodeAnalyzer(session.symbolTable(), memLayout, this);
 	dw->setWidget(disasmView);
 	dw->setTitle(tr("Code view"));
 	dw->setId("CODEVIEW");
@@ -683,6 +760,14 @@ void DebuggerForm::createForm()
 	connect(this, &DebuggerForm::connected, disasmView, &DisasmViewer::refresh);
 	connect(this, &DebuggerForm::symbolsChanged, disasmView, &DisasmViewer::refresh);
 	connect(this, &DebuggerForm::settingsChanged, disasmView, &DisasmViewer::updateLayout);
+	connect(disasmView, &DisasmViewer::cyclesSelected, this, &DebuggerForm::showSelectedCycles);
+	connect(codeAnalyzer, &CodeAnalyzer::analysisReady, this, [this]{
+		disasmView->setCallGraph(codeAnalyzer->callGraph());
+		disasmView->setLoopAnalysis(codeAnalyzer->loopAnalysis());
+	});
+	connect(this, &DebuggerForm::breakStateEntered, this, [this]{
+		if (systemAnalyzeCodeAction->isChecked()) codeAnalyzer->start();
+	});
 
 	// Main memory viewer
 	connect(this, &DebuggerForm::connected, mainMemoryView, &MainMemoryViewer::refresh);
@@ -693,9 +778,26 @@ void DebuggerForm::createForm()
 	connect(this, &DebuggerForm::breakStateEntered, slotView, &SlotViewer::refresh);
 	// Received status update back from widget after breakStateEntered/connected
 	connect(slotView, &SlotViewer::slotsUpdated, this, &DebuggerForm::onSlotsUpdated);
+	// a bank switch maps other blocks of the ROM that is compared with
+	connect(slotView, &SlotViewer::slotsUpdated, disasmView, &DisasmViewer::memoryLayoutChanged);
 
 	// Breakpoint viewer
 	connect(this, &DebuggerForm::breakpointsUpdated, bpView, &BreakpointViewer::refresh);
+	connect(this, &DebuggerForm::breakpointsAdded, bpView, &BreakpointViewer::onBreakpointsAdded);
+	connect(this, &DebuggerForm::breakpointRemoved, bpView, &BreakpointViewer::onBreakpointRemoved);
+	connect(this, &DebuggerForm::traceHitsUpdated, bpView, &BreakpointViewer::refreshHits);
+
+	// Tracepoints and recording watchpoints log without stopping, fetch
+	// their records in bulk
+	logTimer.setInterval(1000);
+	connect(&logTimer, &QTimer::timeout, this, &DebuggerForm::fetchTraceLog);
+	connect(&logTimer, &QTimer::timeout, this, &DebuggerForm::fetchWriteLog);
+	connect(this, &DebuggerForm::runStateEntered, this, [this]{ logTimer.start(); });
+	connect(this, &DebuggerForm::breakStateEntered, this, [this]{
+		logTimer.stop();
+		fetchTraceLog();
+		fetchWriteLog();
+	});
 	connect(this, &DebuggerForm::runStateEntered, bpView, &BreakpointViewer::setRunState);
 	connect(this, &DebuggerForm::breakStateEntered, bpView, &BreakpointViewer::setBreakState);
 
@@ -719,10 +821,12 @@ void DebuggerForm::createForm()
 	disasmView->setSymbolTable(&session.symbolTable());
 	mainMemoryView->setRegsView(regsView);
 	mainMemoryView->setSymbolTable(&session.symbolTable());
+	mainMemoryView->setWriteLog(&writeLog);
 	mainMemoryView->setDebuggable("memory", 0x10000);
 	stackView->setData(mainMemory, 0x10000);
 	slotView->setMemoryLayout(&memLayout);
 	bpView->setBreakpoints(&session.breakpoints());
+	traceLog.setBreakpoints(&session.breakpoints());
 }
 
 void DebuggerForm::closeEvent(QCloseEvent* e)
@@ -817,6 +921,7 @@ void DebuggerForm::updateWindowTitle()
 void DebuggerForm::initConnection()
 {
 	copyCodeViewAction->setEnabled(true);
+	fileExportDisasmAction->setEnabled(true);
 	systemConnectAction->setEnabled(false);
 	systemDisconnectAction->setEnabled(true);
 
@@ -904,6 +1009,85 @@ void DebuggerForm::initConnection()
 		"  return $result\n"
 		"}\n"));
 
+	// define 'debug_list_breaks' proc for internal use, lists only the given ids
+	comm.sendCommand(new SimpleCommand(
+		"proc debug_list_breaks { ids } {\n"
+		"  set wanted [dict create]\n"
+		"  foreach id $ids { dict set wanted $id 1 }\n"
+		"  set result \"\"\n"
+		"  foreach line [split [debug_list_all_breaks] \"\\n\"] {\n"
+		"    if { [dict exists $wanted [lindex [split $line] 0]] } {\n"
+		"      append result $line \"\\n\"\n"
+		"    }\n"
+		"  }\n"
+		"  return $result\n"
+		"}\n"));
+
+	// define the 'debug_set_trace' proc for internal use, it sets a
+	// breakpoint, watchpoint or condition that calls 'debug_trace'
+	// instead of breaking
+	comm.sendCommand(new SimpleCommand(
+		"proc debug_set_trace { args } {\n"
+		"  set tag [incr ::debug_trace_tags]\n"
+		"  debug {*}[lrange $args 0 end-1] [list debug_trace $tag [lindex $args end]]\n"
+		"}\n"));
+
+	// define the 'debug_trace' proc for internal use, it counts the hits
+	// of a tracepoint and logs its expression in a ring buffer
+	comm.sendCommand(new SimpleCommand(
+		"if { ![info exists ::debug_trace_count] } {\n"
+		"  set ::debug_trace_count 0\n"
+		"  set ::debug_trace_hits [dict create]\n"
+		"}\n"
+		"proc debug_trace { tag expression } {\n"
+		"  dict incr ::debug_trace_hits $tag\n"
+		"  set values [string map [list \"\\n\" \" \"] [uplevel #0 [list subst $expression]]]\n"
+		"  set ::debug_trace_log([expr {$::debug_trace_count % 65536}]) \\\n"
+		"    \"$::debug_trace_count [machine_info time] $tag $values\"\n"
+		"  incr ::debug_trace_count\n"
+		"}\n"));
+
+	// define the 'debug_trace_fetch' proc for internal use, it returns the
+	// number of records, the hits and the records from 'from' on
+	comm.sendCommand(new SimpleCommand(
+		"proc debug_trace_fetch { from } {\n"
+		"  set first [expr {max($from, $::debug_trace_count - 65536)}]\n"
+		"  set result \"$::debug_trace_count\\n$::debug_trace_hits\\n\"\n"
+		"  for { set i $first } { $i &lt; $::debug_trace_count } { incr i } {\n"
+		"    append result $::debug_trace_log([expr {$i % 65536}]) \"\\n\"\n"
+		"  }\n"
+		"  return $result\n"
+		"}\n"));
+
+	// define the 'debug_write_log' proc for internal use, the command of
+	// the recording watchpoints, it appends a 13 byte record (time, pc,
+	// address, value) to a buffer that keeps at least the last 128K
+	comm.sendCommand(new SimpleCommand(
+		"if { ![info exists ::debug_write_log_count] } {\n"
+		"  set ::debug_write_log_count 0\n"
+		"  set ::debug_write_log_first 0\n"
+		"  set ::debug_write_log [binary format {}]\n"
+		"}\n"
+		"proc debug_write_log { } {\n"
+		"  append ::debug_write_log [binary format qssc [machine_info time] [reg PC] \\\n"
+		"    $::wp_last_address $::wp_last_value]\n"
+		"  if { [incr ::debug_write_log_count] - $::debug_write_log_first >= 262144 } {\n"
+		"    set ::debug_write_log [string range $::debug_write_log [expr {131072 * 13}] end]\n"
+		"    incr ::debug_write_log_first 131072\n"
+		"  }\n"
+		"}\n"));
+
+	// define the 'debug_write_log_fetch' proc for internal use, it returns
+	// the sequence of the first record and the number of records, then the
+	// records from 'from' on in hex
+	comm.sendCommand(new SimpleCommand(
+		"proc debug_write_log_fetch { from } {\n"
+		"  set first [expr {max($from, $::debug_write_log_first)}]\n"
+		"  set offset [expr {($first - $::debug_write_log_first) * 13}]\n"
+		"  binary scan [string range $::debug_write_log $offset end] H* hex\n"
+		"  return \"$first $::debug_write_log_count\\n$hex\"\n"
+		"}\n"));
+
 	// define 'debug_check_debuggables' proc for internal use
 	comm.sendCommand(new SimpleCommand(
 		"proc debug_check_debuggables { debuggables } {\n"
@@ -924,13 +1108,22 @@ void DebuggerForm::connectionClosed()
 	executeStepOutAction->setEnabled(false);
 	executeStepBackAction->setEnabled(false);
 	executeRunToAction->setEnabled(false);
+	executePreviewAction->setEnabled(false);
 	copyCodeViewAction->setEnabled(false);
+	fileExportDisasmAction->setEnabled(false);
 	systemDisconnectAction->setEnabled(false);
 	systemConnectAction->setEnabled(true);
 	breakpointToggleAction->setEnabled(false);
 	breakpointAddAction->setEnabled(false);
 	commandAction->setEnabled(false);
 
+	// pending commands are cancelled
+	addedBreakpoints.clear();
+	fetchingBreakpoints = false;
+	fetchingTrace = false;
+	fetchingWriteLog = false;
+	logTimer.stop();
+
 	for (auto* w : dockMan.managedWidgets()) {
 		w->widget()->setEnabled(false);
 	}
@@ -964,8 +1157,19 @@ void DebuggerForm::handleUpdate(const QString& type, const QString& name,
                                 const QString& message)
 {
 	if (type == "debug") {
-		// TODO: read only new breakpoint
-		reloadBreakpoints(false);
+		// 'name' is the id of the breakpoint, only fetch the added ones
+		if (message == "add") {
+			addedBreakpoints.insert(name);
+			if (!fetchingBreakpoints) fetchAddedBreakpoints();
+		} else if (message == "remove") {
+			addedBreakpoints.remove(name);
+			if (session.breakpoints().removeBreakpoint(name)) {
+				breakpointsModified();
+				emit breakpointRemoved(name);
+			}
+		} else {
+			reloadBreakpoints(false);
+		}
 	} else if (type == "status") {
 		if (name == "cpu") {
 			// running state by default.
@@ -1087,6 +1291,12 @@ void DebuggerForm::fileSaveSessionAs()
 	updateWindowTitle();
 }
 
+void DebuggerForm::fileExportDisasm()
+{
+	ExportDisasmDialog d(debuggables, session.symbolTable(), this);
+	d.exec();
+}
+
 void DebuggerForm::fileRecentOpen()
 {
 	if (auto* action = qobject_cast<QAction *>(sender())) {
@@ -1111,6 +1321,34 @@ void DebuggerForm::systemDisconnect()
 	comm.closeConnection();
 }
 
+void DebuggerForm::systemOpenImage()
+{
+	OpenImageDialog d(this);
+	if (!d.exec()) return;
+
+	auto image = d.takeImage();
+	int size = image->size();
+	comm.openImage(std::move(image));
+
+	// the image answers the queries of the views, but there is
+	// no machine to run or to set breakpoints in
+	copyCodeViewAction->setEnabled(true);
+	fileExportDisasmAction->setEnabled(true);
+	systemDisconnectAction->setEnabled(true);
+
+	debuggables.clear();
+	debuggables["memory"] = 0x10000;
+	debuggables[OfflineImage::DEBUGGABLE] = size;
+	emit debuggablesChanged(debuggables);
+
+	breakOccured();
+	emit connected();
+
+	for (auto* w : dockMan.managedWidgets()) {
+		w->widget()->setEnabled(true);
+	}
+}
+
 void DebuggerForm::systemPause()
 {
 	comm.sendCommand(new SimpleCommand(QString("set pause ") +
@@ -1132,22 +1370,35 @@ void DebuggerForm::systemSymbolManager()
 {
 	symManager = new SymbolManager(session.symbolTable(), this);
 
-	connect(this, &DebuggerForm::symbolFilesChanged,
-	        disasmView, &DisasmViewer::refresh);
 	connect(symManager, &SymbolManager::symbolTableChanged,
 	        &session, &DebugSession::sessionModified);
 	connect(symManager, &SymbolManager::symbolTableChanged,
 	        bpView, &BreakpointViewer::onSymbolTableChanged);
+	connect(symManager, &SymbolManager::setBreakpointsRequested,
+	        this, &DebuggerForm::setSymbolBreakpoints);
+	connect(symManager, &SymbolManager::removeBreakpointsRequested,
+	        this, &DebuggerForm::removeSymbolBreakpoints);
 	connect(this, &DebuggerForm::symbolFilesChanged,
 	        symManager, &SymbolManager::refresh);
-	connect(this, &DebuggerForm::symbolFilesChanged,
-	        bpView, &BreakpointViewer::refresh);
+	connect(codeAnalyzer, &CodeAnalyzer::analysisReady, symManager, [this, m = symManager.data()]{
+		m->setCallGraph(codeAnalyzer->callGraph());
+	});
+	symManager->setCallGraph(codeAnalyzer->callGraph());
 	symManager->exec();
 
 	emit symbolsChanged();
 	updateWindowTitle();
 }
 
+void DebuggerForm::systemAnalyzeCode(bool enabled)
+{
+	if (!enabled) {
+		codeAnalyzer->clear();
+	} else if (disasmView->isEnabled()) {
+		codeAnalyzer->start();
+	}
+}
+
 void DebuggerForm::systemPreferences()
 {
 	PreferencesDialog prefs(this);
@@ -1197,6 +1448,91 @@ void DebuggerForm::executeRunTo()
 	setRunMode();
 }
 
+static Z80Core::Registers readRegisters(CPURegsViewer& regsView)
+{
+	Z80Core::Registers regs = {};
+	regs.af  = regsView.readRegister(CpuRegs::REG_AF);
+	regs.bc  = regsView.readRegister(CpuRegs::REG_BC);
+	regs.de  = regsView.readRegister(CpuRegs::REG_DE);
+	regs.hl  = regsView.readRegister(CpuRegs::REG_HL);
+	regs.af2 = regsView.readRegister(CpuRegs::REG_AF2);
+	regs.bc2 = regsView.readRegister(CpuRegs::REG_BC2);
+	regs.de2 = regsView.readRegister(CpuRegs::REG_DE2);
+	regs.hl2 = regsView.readRegister(CpuRegs::REG_HL2);
+	regs.ix  = regsView.readRegister(CpuRegs::REG_IX);
+	regs.iy  = regsView.readRegister(CpuRegs::REG_IY);
+	regs.sp  = regsView.readRegister(CpuRegs::REG_SP);
+	regs.pc  = regsView.readRegister(CpuRegs::REG_PC);
+	regs.i   = regsView.readRegister(CpuRegs::REG_I);
+	regs.r   = regsView.readRegister(CpuRegs::REG_R);
+	regs.im  = regsView.readRegister(CpuRegs::REG_IM);
+	regs.iff1 = regs.iff2 = regsView.readRegister(CpuRegs::REG_IFF) & 1;
+	return regs;
+}
+
+void DebuggerForm::executePreview()
+{
+	ExecutionPreviewDialog d(readRegisters(*regsView), memLayout, session.symbolTable(), this);
+	d.exec();
+}
+
+// The length of the instructions that step_over runs to their end (call,
+// rst, halt and the repeating block instructions), 0 for the others.
+static int stepOverLength(const uint8_t* op)
+{
+	if (op[0] == 0xCD || (op[0] & 0xC7) == 0xC4) return 3;
+	if ((op[0] & 0xC7) == 0xC7 || op[0] == 0x76) return 1;
+	if (op[0] == 0xED && (op[1] & 0xF4) == 0xB0) return 2;
+	return 0;
+}
+
+void DebuggerForm::predictStep()
+{
+	if (!executeStepAction->isEnabled()) return;
+
+	// Where a step goes only depends on the registers, the instruction,
+	// the return address for a ret and (HL) for cpir/cpdr. Only those
+	// bytes are read, the local core executes the instruction on them.
+	Z80Core::Registers regs = readRegisters(*regsView);
+	std::vector<uint16_t> addresses;
+	for (int i = 0; i < 4; ++i) {
+		addresses.push_back(uint16_t(regs.pc + i));
+	}
+	addresses.push_back(regs.sp);
+	addresses.push_back(uint16_t(regs.sp + 1));
+	addresses.push_back(regs.hl);
+	QString cmd = "list";
+	for (auto addr : addresses) {
+		cmd += QString(" [debug read memory %1]").arg(addr);
+	}
+
+	int prediction = ++stepPrediction;
+	comm.sendCommand(new Command(cmd,
+		[this, regs, addresses, prediction](const QString& reply) {
+			// skip the replies for an older break
+			if (prediction != stepPrediction) return;
+			QStringList values = reply.split(" ", Qt::SplitBehaviorFlags::SkipEmptyParts);
+			if (values.size() != int(addresses.size())) return;
+
+			std::vector<uint8_t> memory(0x10000 + 3);
+			for (size_t i = 0; i < addresses.size(); ++i) {
+				memory[addresses[i]] = uint8_t(values[i].toUInt());
+			}
+			uint8_t op[2] = {memory[regs.pc], memory[uint16_t(regs.pc + 1)]};
+
+			Z80Core core(memory.data());
+			core.regs = regs;
+			core.step();
+			uint16_t into = core.regs.pc;
+			int length = stepOverLength(op);
+			uint16_t over = length ? uint16_t(regs.pc + length) : into;
+
+			// an interrupt that is accepted first is not predicted
+			executeStepAction->setToolTip(tr("Step into, to %1").arg(hexValue(into, 4)));
+			executeStepOverAction->setToolTip(tr("Step over, to %1").arg(hexValue(over, 4)));
+		}));
+}
+
 void DebuggerForm::executeStepOut()
 {
 	comm.sendCommand(new SimpleCommand("step_out"));
@@ -1468,6 +1804,120 @@ void DebuggerForm::addDebuggableViewer()
 	viewer->setEnabled(disasmView->isEnabled());
 }
 
+void DebuggerForm::addDisasmSearch()
+{
+	auto* viewer = new DisasmSearchViewer();
+	auto* dw = new DockableWidget(dockMan);
+	dw->setWidget(viewer);
+	dw->setTitle(tr("Disassembly search"));
+	dw->setId("DISASMSEARCH-" + QString::number(++counter));
+	dw->setFloating(true);
+	dw->setDestroyable(true);
+	dw->setMovable(true);
+	dw->setClosable(true);
+	connect(dw, &DockableWidget::visibilityChanged,
+	        this, &DebuggerForm::dockWidgetVisibilityChanged);
+	connect(this, &DebuggerForm::debuggablesChanged,
+	        viewer, &DisasmSearchViewer::setDebuggables);
+	connect(this, &DebuggerForm::breakStateEntered,
+	        viewer, &DisasmSearchViewer::refresh);
+	connect(viewer, &DisasmSearchViewer::addressSelected, this, [this](uint16_t addr) {
+		disasmView->setCursorAddress(addr, 0, DisasmViewer::MiddleAlways);
+	});
+	viewer->setSymbolTable(&session.symbolTable());
+	viewer->setMemoryLayout(&memLayout);
+	viewer->setDebuggables(debuggables);
+	viewer->setEnabled(disasmView->isEnabled());
+}
+
+void DebuggerForm::addPeepholeViewer()
+{
+	auto* viewer = new PeepholeViewer();
+	auto* dw = new DockableWidget(dockMan);
+	dw->setWidget(viewer);
+	dw->setTitle(tr("Optimization hints"));
+	dw->setId("PEEPHOLE-" + QString::number(++counter));
+	dw->setFloating(true);
+	dw->setDestroyable(true);
+	dw->setMovable(true);
+	dw->setClosable(true);
+	connect(dw, &DockableWidget::visibilityChanged,
+	        this, &DebuggerForm::dockWidgetVisibilityChanged);
+	connect(codeAnalyzer, &CodeAnalyzer::analysisReady, viewer, [this, viewer] {
+		viewer->setAdvice(codeAnalyzer->peepholeAdvice());
+	});
+	connect(viewer, &PeepholeViewer::addressSelected, this, [this](uint16_t addr) {
+		disasmView->setCursorAddress(addr, 0, DisasmViewer::MiddleAlways);
+	});
+	viewer->setSymbolTable(&session.symbolTable());
+	viewer->setMemoryLayout(&memLayout);
+	viewer->setAdvice(codeAnalyzer->peepholeAdvice());
+	// the hints come from the code analysis
+	systemAnalyzeCodeAction->setChecked(true);
+}
+
+void DebuggerForm::addVramTimingViewer()
+{
+	auto* viewer = new VramTimingViewer();
+	auto* dw = new DockableWidget(dockMan);
+	dw->setWidget(viewer);
+	dw->setTitle(tr("VRAM timing check"));
+	dw->setId("VRAMTIMING-" + QString::number(++counter));
+	dw->setFloating(true);
+	dw->setDestroyable(true);
+	dw->setMovable(true);
+	dw->setClosable(true);
+	connect(dw, &DockableWidget::visibilityChanged,
+	        this, &DebuggerForm::dockWidgetVisibilityChanged);
+	connect(codeAnalyzer, &CodeAnalyzer::analysisReady, viewer, [this, viewer] {
+		viewer->setTiming(codeAnalyzer->vramTiming());
+	});
+	connect(viewer, &VramTimingViewer::addressSelected, this, [this](uint16_t addr) {
+		disasmView->setCursorAddress(addr, 0, DisasmViewer::MiddleAlways);
+	});
+	viewer->setSymbolTable(&session.symbolTable());
+	viewer->setMemoryLayout(&memLayout);
+	viewer->setTiming(codeAnalyzer->vramTiming());
+	// the accesses come from the code analysis
+	systemAnalyzeCodeAction->setChecked(true);
+}
+
+void DebuggerForm::addTraceViewer()
+{
+	auto* viewer = new TraceViewer(traceLog);
+	auto* dw = new DockableWidget(dockMan);
+	dw->setWidget(viewer);
+	dw->setTitle(tr("Trace log"));
+	dw->setId("TRACE-" + QString::number(++counter));
+	dw->setFloating(true);
+	dw->setDestroyable(true);
+	dw->setMovable(true);
+	dw->setClosable(true);
+	connect(dw, &DockableWidget::visibilityChanged,
+	        this, &DebuggerForm::dockWidgetVisibilityChanged);
+	fetchTraceLog();
+}
+
+void DebuggerForm::addSourceViewer()
+{
+	auto* viewer = new SourceViewer();
+	auto* dw = new DockableWidget(dockMan);
+	dw->setWidget(viewer);
+	dw->setTitle(tr("Source"));
+	dw->setId("SOURCE-" + QString::number(++counter));
+	dw->setFloating(true);
+	dw->setDestroyable(true);
+	dw->setMovable(true);
+	dw->setClosable(true);
+	connect(dw, &DockableWidget::visibilityChanged,
+	        this, &DebuggerForm::dockWidgetVisibilityChanged);
+	connect(regsView, &CPURegsViewer::pcChanged, viewer, &SourceViewer::setProgramCounter);
+	connect(&session.symbolTable(), &SymbolTable::sourceLinesChanged, viewer, &SourceViewer::refresh);
+	viewer->setSymbolTable(&session.symbolTable());
+	viewer->setMemoryLayout(&memLayout);
+	viewer->setProgramCounter(regsView->readRegister(CpuRegs::REG_PC));
+}
+
 void DebuggerForm::showFloatingWidget()
 {
 	QObject * s = sender();
@@ -1607,10 +2057,213 @@ void DebuggerForm::reloadBreakpoints(bool merge)
 void DebuggerForm::processBreakpoints(const QString& message)
 {
 	session.breakpoints().setBreakpoints(message);
+	breakpointsModified();
+	emit breakpointsUpdated();
+}
+
+void DebuggerForm::fetchAddedBreakpoints()
+{
+	// Updates that arrive while this is fetched are collected and fetched
+	// together afterwards, so a script that sets thousands of breakpoints
+	// costs a few round trips instead of a full list per breakpoint.
+	QStringList ids = addedBreakpoints.values();
+	addedBreakpoints.clear();
+	fetchingBreakpoints = true;
+
+	auto* command = new Command(QString("debug_list_breaks {%1}").arg(ids.join(' ')),
+		[this](const QString& message) {
+			fetchingBreakpoints = false;
+			QStringList added = session.breakpoints().addBreakpoints(message);
+			if (!added.isEmpty()) {
+				breakpointsModified();
+				emit breakpointsAdded(added);
+			}
+			if (!addedBreakpoints.isEmpty()) fetchAddedBreakpoints();
+		},
+		[this](const QString& /*error*/) {
+			fetchingBreakpoints = false;
+			addedBreakpoints.clear();
+			reloadBreakpoints(false);
+		});
+	comm.sendCommand(command);
+}
+
+void DebuggerForm::fetchTraceLog()
+{
+	// the tracepoints log in openMSX, this only costs a round trip per fetch
+	if (fetchingTrace || !session.breakpoints().hasTracepoints()) return;
+	fetchingTrace = true;
+
+	auto* command = new Command(QString("debug_trace_fetch %1").arg(traceLog.nextSequence()),
+		[this](const QString& message) {
+			fetchingTrace = false;
+			session.breakpoints().setTraceHits(traceLog.addFetched(message));
+			emit traceHitsUpdated();
+		},
+		[this](const QString& /*error*/) {
+			fetchingTrace = false;
+		});
+	comm.sendCommand(command);
+}
+
+void DebuggerForm::fetchWriteLog()
+{
+	// tens of thousands of writes per second arrive in one reply
+	if (fetchingWriteLog || !session.breakpoints().hasRecordingWatchpoints()) return;
+	fetchingWriteLog = true;
+
+	auto* command = new Command(QString("debug_write_log_fetch %1").arg(writeLog.nextSequence()),
+		[this](const QString& message) {
+			fetchingWriteLog = false;
+			writeLog.addFetched(message);
+		},
+		[this](const QString& /*error*/) {
+			fetchingWriteLog = false;
+		});
+	comm.sendCommand(command);
+}
+
+void DebuggerForm::breakpointsModified()
+{
 	disasmView->update();
 	session.sessionModified();
 	updateWindowTitle();
-	emit breakpointsUpdated();
+}
+
+// the slot a breakpoint on the symbol is limited to, when all its valid
+// slots are in one primary slot
+static Slot symbolSlot(const Symbol& symbol, const MemoryLayout& ml)
+{
+	uint16_t valid = symbol.validSlots();
+	for (int8_t ps = 0; ps < 4; ++ps) {
+		uint16_t mask = 0xF << (4 * ps);
+		if (!(valid & mask)) continue;
+		if (valid & ~mask) return {};
+		Slot slot;
+		slot.ps = ps;
+		int sub = (valid & mask) >> (4 * ps);
+		if (ml.isSubslotted[ps] && (sub & (sub - 1)) == 0) {
+			int8_t ss = 0;
+			while (!(sub & (1 << ss))) ++ss;
+			slot.ss = ss;
+		}
+		return slot;
+	}
+	return {};
+}
+
+// identifies the breakpoint setSymbolBreakpoints() sets for a symbol at
+// 'address' in 'slot'
+static int symbolBreakpointKey(int address, const Slot& slot)
+{
+	return address << 8 | (slot.ps ? *slot.ps + 1 : 0) << 4 | (slot.ss ? *slot.ss + 1 : 0);
+}
+
+// the key of 'bp' when it could have been set for a symbol, -1 for the ones
+// with a range, segment, condition or trace
+static int symbolBreakpointKey(const Breakpoint& bp)
+{
+	if (bp.type != Breakpoint::BREAKPOINT || !bp.range || bp.range->end) return -1;
+	if (bp.segment || !bp.condition.isEmpty() || !bp.trace.isEmpty()) return -1;
+	return symbolBreakpointKey(bp.range->start, bp.slot);
+}
+
+void DebuggerForm::setSymbolBreakpoints(const QList<Symbol*>& symbols)
+{
+	// All breakpoints are set by one command that lists their ids, so the
+	// reply can be added locally in one pass without fetching them again.
+	auto& breakpoints = session.breakpoints();
+	QSet<int> existing;
+	existing.reserve(breakpoints.breakpointCount() + symbols.size());
+	for (int i = 0; i < breakpoints.breakpointCount(); ++i) {
+		int key = symbolBreakpointKey(breakpoints.getBreakpoint(i));
+		if (key >= 0) existing.insert(key);
+	}
+
+	std::vector<Breakpoint> bps;
+	QStringList commands;
+	for (const auto* symbol : symbols) {
+		int address = symbol->value();
+		if (address < 0 || address > 0xFFFF) continue;
+		Slot slot = symbolSlot(*symbol, memLayout);
+		int key = symbolBreakpointKey(address, slot);
+		if (existing.contains(key)) continue;
+		existing.insert(key);
+
+		Breakpoint bp;
+		bp.type = Breakpoint::BREAKPOINT;
+		bp.range = AddressRange(uint16_t(address));
+		bp.slot = slot;
+		commands << '[' + Breakpoints::createSetCommand(bp.type, bp.range, bp.slot) + ']';
+		bps.push_back(std::move(bp));
+	}
+	if (bps.empty()) return;
+
+	auto* command = new Command("list " + commands.join(' '),
+		[this, bps = std::move(bps)](const QString& message) mutable {
+			QStringList ids = message.split(' ', Qt::SplitBehaviorFlags::SkipEmptyParts);
+			if (ids.size() != int(bps.size())) {
+				reloadBreakpoints(false);
+				return;
+			}
+			for (size_t i = 0; i < bps.size(); ++i) {
+				bps[i].id = ids[i];
+				// no need to fetch what the updates reported
+				addedBreakpoints.remove(ids[i]);
+			}
+			QStringList added = session.breakpoints().addBreakpoints(std::move(bps));
+			if (!added.isEmpty()) {
+				breakpointsModified();
+				emit breakpointsAdded(added);
+			}
+		},
+		[this](const QString& /*error*/) {
+			// some of them may have been set
+			reloadBreakpoints(false);
+		});
+	comm.sendCommand(command);
+}
+
+void DebuggerForm::removeSymbolBreakpoints(const QList<Symbol*>& symbols)
+{
+	// only the breakpoints setSymbolBreakpoints() would set, not the ones
+	// the user limited to another slot or gave a condition
+	QSet<int> keys;
+	keys.reserve(symbols.size());
+	for (const auto* symbol : symbols) {
+		int address = symbol->value();
+		if (address < 0 || address > 0xFFFF) continue;
+		keys.insert(symbolBreakpointKey(address, symbolSlot(*symbol, memLayout)));
+	}
+
+	QStringList ids, commands;
+	auto& breakpoints = session.breakpoints();
+	for (int i = 0; i < breakpoints.breakpointCount(); ++i) {
+		const auto& bp = breakpoints.getBreakpoint(i);
+		int key = symbolBreakpointKey(bp);
+		if (key >= 0 && keys.contains(key)) {
+			ids << bp.id;
+			commands << Breakpoints::createRemoveCommand(bp.id);
+		}
+	}
+	if (commands.isEmpty()) return;
+
+	auto* command = new Command(commands.join(" ; "),
+		[this, ids](const QString& /*message*/) {
+			// normally the updates already removed them
+			bool removed = false;
+			for (const auto& id : ids) {
+				if (session.breakpoints().removeBreakpoint(id)) {
+					removed = true;
+					emit breakpointRemoved(id);
+				}
+			}
+			if (removed) breakpointsModified();
+		},
+		[this](const QString& /*error*/) {
+			reloadBreakpoints(false);
+		});
+	comm.sendCommand(command);
 }
 
 void DebuggerForm::processMerge(const QString& message)
@@ -1624,6 +2277,19 @@ void DebuggerForm::processMerge(const QString& message)
 	}
 }
 
+void DebuggerForm::showSelectedCycles(int instructions, int cycles, int cyclesNotTaken)
+{
+	if (instructions == 0) {
+		cyclesLabel->clear();
+	} else if (cycles == cyclesNotTaken) {
+		cyclesLabel->setText(tr("%n instruction(s), %1 T-states", "", instructions)
+		                     .arg(cycles));
+	} else {
+		cyclesLabel->setText(tr("%n instruction(s), %1/%2 T-states", "", instructions)
+		                     .arg(cycles).arg(cyclesNotTaken));
+	}
+}
+
 QByteArray DebuggerForm::saveCommands() const
 {
 	QByteArray output;
@@ -1678,6 +2344,7 @@ void DebuggerForm::onSlotsUpdated(bool slotsChanged)
 
 void DebuggerForm::onPCChanged(uint16_t address)
 {
+	predictStep();
 	if (disasmStatus != RESET) {
 		disasmView->setProgramCounter(address, disasmStatus == SLOTS_CHANGED);
 	} else {
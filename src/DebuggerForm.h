@@ -6,9 +6,13 @@
 #include "DebugSession.h"
 #include "SymbolManager.h"
 #include "CommandDialog.h"
+#include "TraceLog.h"
+#include "WriteLog.h"
 #include <QMainWindow>
 #include <QMap>
 #include <QPointer>
+#include <QSet>
+#include <QTimer>
 #include <cstdint>
 #include <memory>
 
@@ -26,6 +30,8 @@ class VDPStatusRegViewer;
 class VDPRegViewer;
 class VDPCommandRegViewer;
 class BreakpointViewer;
+class CodeAnalyzer;
+class QLabel;
 
 
 class DebuggerForm : public QMainWindow
@@ -89,6 +95,7 @@ private:
 	QAction* fileOpenSessionAction;
 	QAction* fileSaveSessionAction;
 	QAction* fileSaveSessionAsAction;
+	QAction* fileExportDisasmAction;
 	QAction* fileQuitAction;
 
 	QAction* copyCodeViewAction;
@@ -99,9 +106,11 @@ private:
 
 	QAction* systemConnectAction;
 	QAction* systemDisconnectAction;
+	QAction* systemOpenImageAction;
 	QAction* systemPauseAction;
 	QAction* systemRebootAction;
 	QAction* systemSymbolManagerAction;
+	QAction* systemAnalyzeCodeAction;
 	QAction* systemPreferencesAction;
 
 	QAction* searchGotoAction;
@@ -113,6 +122,11 @@ private:
 	QAction* viewMemoryAction;
 	QAction* viewBreakpointsAction;
 	QAction* viewDebuggableViewerAction;
+	QAction* viewDisasmSearchAction;
+	QAction* viewPeepholeAction;
+	QAction* viewVramTimingAction;
+	QAction* viewSourceAction;
+	QAction* viewTraceAction;
 
 	QAction* viewBitMappedAction;
 	QAction* viewCharMappedAction;
@@ -126,6 +140,7 @@ private:
 	QAction* executeStepAction;
 	QAction* executeStepOverAction;
 	QAction* executeRunToAction;
+	QAction* executePreviewAction;
 	QAction* executeStepOutAction;
 	QAction* executeStepBackAction;
 
@@ -149,6 +164,8 @@ private:
 	VDPCommandRegViewer* VDPCommandRegView;
 	BreakpointViewer* bpView;
 	QPointer<SymbolManager> symManager;
+	CodeAnalyzer* codeAnalyzer;
+	QLabel* cyclesLabel;
 
 	CommClient& comm;
 	DebugSession session;
@@ -156,11 +173,23 @@ private:
 	uint8_t mainMemory[0x10000 + 4] = {}; // 4 extra to avoid wrap-check during disasm
 
 	bool mergeBreakpoints;
+	// ids of breakpoints that openMSX reported as added, still to be fetched
+	QSet<QString> addedBreakpoints;
+	bool fetchingBreakpoints = false;
+	// the records of the tracepoints and the recording watchpoints,
+	// fetched periodically while running
+	TraceLog traceLog;
+	WriteLog writeLog;
+	QTimer logTimer;
+	bool fetchingTrace = false;
+	bool fetchingWriteLog = false;
 	QMap<QString, int> debuggables;
 
 	static int counter;
 	enum {RESET = 0, SLOTS_CHECKED, PC_CHANGED, SLOTS_CHANGED} disasmStatus = RESET;
 	uint16_t disasmAddress;
+	// the last prediction of the next PC, see predictStep()
+	int stepPrediction = 0;
 
 	QList<CommandRef> commands;
 	void updateCustomActions();
@@ -169,13 +198,16 @@ private:
 	void fileOpenSession();
 	void fileSaveSession();
 	void fileSaveSessionAs();
+	void fileExportDisasm();
 	void fileRecentOpen();
 	void copyCodeView();
 	void systemConnect();
 	void systemDisconnect();
+	void systemOpenImage();
 	void systemPause();
 	void systemReboot();
 	void systemSymbolManager();
+	void systemAnalyzeCode(bool enabled);
 	void systemPreferences();
 	void searchGoto();
 	void toggleBreakpointsDisplay();
@@ -191,11 +223,18 @@ private:
 	void toggleVDPStatusRegsDisplay();
 	void toggleVDPCommandRegsDisplay();
 	void addDebuggableViewer();
+	void addDisasmSearch();
+	void addPeepholeViewer();
+	void addVramTimingViewer();
+	void addSourceViewer();
+	void addTraceViewer();
 	void executeBreak();
 	void executeRun();
 	void executeStep();
 	void executeStepOver();
 	void executeRunTo();
+	void executePreview();
+	void predictStep();
 	void executeStepOut();
 	void executeStepBack();
 
@@ -222,6 +261,13 @@ private:
 	void showFloatingWidget();
 	void processBreakpoints(const QString& message);
 	void processMerge(const QString& message);
+	void fetchAddedBreakpoints();
+	void breakpointsModified();
+	void setSymbolBreakpoints(const QList<Symbol*>& symbols);
+	void fetchTraceLog();
+	void fetchWriteLog();
+	void removeSymbolBreakpoints(const QList<Symbol*>& symbols);
+	void showSelectedCycles(int instructions, int cycles, int cyclesNotTaken);
 
 	QByteArray saveCommands() const;
 	void restoreCommands(const QByteArray& input);
@@ -241,6 +287,9 @@ signals:
 	void runStateEntered();
 	void breakStateEntered();
 	void breakpointsUpdated();
+	void breakpointsAdded(const QStringList& ids);
+	void breakpointRemoved(const QString& id);
+	void traceHitsUpdated();
 	void debuggablesChanged(const QMap<QString, int>& list);
 };
 
@@ -0,0 +1,171 @@
+#include "DisasmExport.h"
+#include "Dasm.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+DisasmExporter::DisasmExporter(const uint8_t* image_, std::vector<Segment> segments_,
+                               const AddressSymbolIndex& symbols_)
+	: image(image_), segments(std::move(segments_)), banked(0x10000)
+{
+	// the export threads must not read the names from the symbol table
+	for (int pos = 0; pos < symbols_.size(); ++pos) {
+		symbols.add(symbols_.address(pos), std::string(symbols_.name(pos)));
+	}
+	for (const auto& s : segments) {
+		for (uint32_t a = s.address; a < std::min(s.address + s.size, 0x10000u); ++a) {
+			banked[a] = true;
+		}
+	}
+}
+
+std::vector<DisasmExporter::Segment> DisasmExporter::split(
+	uint32_t imageSize, uint32_t segmentSize, uint16_t firstAddress, uint16_t address)
+{
+	if (segmentSize == 0) {
+		segmentSize = firstAddress + imageSize <= 0x10000 ? imageSize : 0x4000;
+	}
+	std::vector<Segment> result;
+	for (uint32_t offset = 0; offset < imageSize; offset += segmentSize) {
+		result.push_back({offset, std::min(segmentSize, imageSize - offset),
+		                  offset == 0 ? firstAddress : address});
+	}
+	return result;
+}
+
+bool DisasmExporter::fits(const std::vector<Segment>& segments)
+{
+	return std::all_of(segments.begin(), segments.end(), [](const Segment& s) {
+		return s.address + s.size <= 0x10000;
+	});
+}
+
+bool DisasmExporter::inWindow(size_t segment, uint16_t addr) const
+{
+	const auto& s = segments[segment];
+	return addr >= s.address && addr < s.address + s.size;
+}
+
+AddressSymbolIndex DisasmExporter::segmentSymbols(size_t segment) const
+{
+	// Symbols carry no segment, so a label inside the window belongs to
+	// every segment visible there. Only the first of these segments uses
+	// the plain name, the others get a suffix to keep the labels unique.
+	AddressSymbolIndex result;
+	for (int pos = 0; pos < symbols.size(); ++pos) {
+		uint16_t addr = symbols.address(pos);
+		if (!banked[addr]) {
+			result.add(addr, std::string(symbols.name(pos)));
+		} else if (inWindow(segment, addr)) {
+			size_t first = 0;
+			while (!inWindow(first, addr)) ++first;
+			std::string name(symbols.name(pos));
+			result.add(addr, first == segment ? name : name + "_s" + std::to_string(segment));
+		}
+	}
+	return result;
+}
+
+DisasmExporter::Result DisasmExporter::disassemble(size_t segment) const
+{
+	const auto& s = segments[segment];
+	uint32_t end = s.address + s.size;
+
+	// the disassembler reads a few bytes past the end
+	std::vector<unsigned char> memory(0x10000 + 4);
+	std::copy_n(image + s.offset, std::min(s.size, 0x10000u - s.address),
+	            memory.begin() + s.address);
+
+	AddressSymbolIndex index = segmentSymbols(segment);
+	DisasmLines rows;
+	dasm(memory.data(), s.address, int(end), rows, index, 0x20000);
+
+	Result result;
+	result.text = "; segment " + std::to_string(segment)
+	            + " (offset #" + toHex(s.offset, 6) + ")\n"
+	            + "\torg #" + toHex(s.address, 4) + "\n";
+	for (auto& row : rows) {
+		if (row.addr >= end) break;
+		if (row.rowType == DisasmRow::LABEL) {
+			result.text += disasmText(row, index) + ":\n";
+			continue;
+		}
+		// instructions running past the end of the segment are data
+		if (row.addr + row.numBytes > end) {
+			row.table = DisasmRow::DATA;
+			row.numBytes = end - row.addr;
+		}
+		if (row.hasAddressOperand() && row.symbol != AddressSymbolIndex::NOT_FOUND
+		    && !banked[row.operand]) {
+			result.externals.emplace(row.operand, std::string(index.name(row.symbol)));
+		}
+		std::string text = disasmText(row, index);
+		text.erase(text.find_last_not_of(' ') + 1);
+		result.text += '\t' + text + '\n';
+	}
+	result.text += '\n';
+	return result;
+}
+
+bool DisasmExporter::write(std::ostream& out, const Progress& progress)
+{
+	std::vector<Result> results(segments.size());
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::atomic<size_t> next{0};
+	std::atomic<bool> aborted{false};
+
+	auto worker = [&] {
+		while (!aborted) {
+			size_t i = next++;
+			if (i >= segments.size()) break;
+			Result r = disassemble(i);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				results[i] = std::move(r);
+				results[i].done = true;
+			}
+			finished.notify_all();
+		}
+	};
+	size_t numThreads = std::min<size_t>(
+		std::max(1u, std::thread::hardware_concurrency()), segments.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < numThreads; ++i) {
+		threads.emplace_back(worker);
+	}
+
+	// segments are written in order, as soon as they are available
+	std::set<External> externals;
+	for (size_t i = 0; i < segments.size(); ++i) {
+		Result r;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [&] { return results[i].done; });
+			r = std::move(results[i]);
+		}
+		out << r.text;
+		externals.insert(r.externals.begin(), r.externals.end());
+		if (progress && !progress(i + 1, segments.size())) {
+			aborted = true;
+			break;
+		}
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	if (aborted) return false;
+
+	if (!externals.empty()) {
+		out << "; symbols outside the exported segments\n";
+		std::string previous;
+		for (const auto& [addr, name] : externals) {
+			if (name == previous) continue;
+			out << name << ":\tequ #" << toHex(addr, 4) << '\n';
+			previous = name;
+		}
+	}
+	return out.good();
+}
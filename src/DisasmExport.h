@@ -0,0 +1,62 @@
+#ifndef DISASMEXPORT_H
+#define DISASMEXPORT_H
+
+#include "SymbolTable.h"
+#include <functional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+// Disassembles a complete image (a ROM, a RAM dump or a mapper with all its
+// segments) to source code that sjasm and tniASM assemble back to the same
+// bytes. Segments are disassembled in parallel and written in order.
+class DisasmExporter
+{
+public:
+	struct Segment {
+		uint32_t offset;  // in the image
+		uint32_t size;
+		uint16_t address; // where the segment is visible to the Z80
+	};
+	// called after each written segment, return false to abort
+	using Progress = std::function<bool(size_t done, size_t total)>;
+
+	DisasmExporter(const uint8_t* image, std::vector<Segment> segments,
+	               const AddressSymbolIndex& symbols);
+
+	// Splits an image in segments of 'segmentSize' bytes (0 for a single
+	// segment), the first one visible at 'firstAddress', the others at
+	// 'address'. An image that doesn't fit in the Z80 address space as a
+	// single segment, like a MegaROM, is split in 16kB segments.
+	static std::vector<Segment> split(uint32_t imageSize, uint32_t segmentSize,
+	                                  uint16_t firstAddress, uint16_t address);
+	// whether every segment is completely visible to the Z80, only then
+	// every byte of the image is disassembled
+	[[nodiscard]] static bool fits(const std::vector<Segment>& segments);
+
+	bool write(std::ostream& out, const Progress& progress = {});
+
+private:
+	using External = std::pair<uint16_t, std::string>;
+	struct Result {
+		std::string text;
+		std::set<External> externals;
+		bool done = false;
+	};
+
+	[[nodiscard]] bool inWindow(size_t segment, uint16_t addr) const;
+	[[nodiscard]] AddressSymbolIndex segmentSymbols(size_t segment) const;
+	[[nodiscard]] Result disassemble(size_t segment) const;
+
+	const uint8_t* image;
+	std::vector<Segment> segments;
+	AddressSymbolIndex symbols;
+	// addresses that are inside the window of some segment, symbols
+	// outside all windows are global and resolved with an 'equ'
+	std::vector<bool> banked;
+};
+
+#endif // DISASMEXPORT_H
@@ -0,0 +1,143 @@
+#include "DisasmSearch.h"
+#include "SymbolTable.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <regex>
+
+static bool isWordChar(char c)
+{
+	return isalnum(static_cast<unsigned char>(c)) || (c && strchr("_#$.@'", c));
+}
+
+static std::string toLower(std::string s)
+{
+	for (auto& c : s) c = char(tolower(static_cast<unsigned char>(c)));
+	return s;
+}
+
+// '*' matches any text and '?' any character, both within one operand,
+// a '+' before them also matches the '-' of a negative displacement
+static bool globMatch(const char* pattern, const char* text)
+{
+	for (; *pattern; ++pattern, ++text) {
+		if (*pattern == '*') {
+			for (const char* t = text; ; ++t) {
+				if (globMatch(pattern + 1, t)) return true;
+				if (!*t || *t == ',') return false;
+			}
+		}
+		if (*pattern == '+' && *text == '-' && (pattern[1] == '*' || pattern[1] == '?')) {
+			continue;
+		}
+		if (!*text || (*pattern == '?' ? *text == ',' : *pattern != *text)) {
+			return false;
+		}
+	}
+	return !*text;
+}
+
+void DisasmSearchIndex::clear()
+{
+	entries.clear();
+	mnemonics.clear();
+	words.clear();
+}
+
+void DisasmSearchIndex::addSegment(uint16_t segment, const DisasmLines& rows,
+                                   const AddressSymbolIndex& symbols, uint32_t start, uint32_t end)
+{
+	for (const auto& row : rows) {
+		if (row.rowType != DisasmRow::INSTRUCTION) continue;
+		if (row.addr < start || row.addr >= end) continue;
+
+		// drop the padding after the mnemonic
+		std::string text = toLower(disasmText(row, symbols));
+		auto mnemonicEnd = text.find(' ');
+		auto operandStart = text.find_first_not_of(' ', mnemonicEnd);
+		std::string mnemonic = text.substr(0, mnemonicEnd);
+		if (operandStart != std::string::npos) {
+			auto operandEnd = text.find_last_not_of(' ') + 1;
+			text = mnemonic + ' ' + text.substr(operandStart, operandEnd - operandStart);
+		} else {
+			text = mnemonic;
+		}
+
+		int id = int(entries.size());
+		entries.push_back({row.addr, segment, uint16_t(std::min(mnemonic.size() + 1, text.size())), text});
+		mnemonics[mnemonic].push_back(id);
+
+		// every word once, so the lists stay sorted and unique
+		for (size_t i = 0; i < text.size(); ) {
+			if (!isWordChar(text[i])) {
+				++i;
+				continue;
+			}
+			size_t j = i;
+			while (j < text.size() && isWordChar(text[j])) ++j;
+			auto& list = words[text.substr(i, j - i)];
+			if (list.empty() || list.back() != id) list.push_back(id);
+			i = j;
+		}
+	}
+}
+
+std::vector<int> DisasmSearchIndex::find(const std::string& query, bool regex) const
+{
+	auto first = query.find_first_not_of(" \t");
+	if (first == std::string::npos) return {};
+	std::string q = query.substr(first, query.find_last_not_of(" \t") + 1 - first);
+
+	if (regex) return findRegex(q);
+	if (std::all_of(q.begin(), q.end(), isWordChar)) return findWord(toLower(q));
+	return findPattern(toLower(q));
+}
+
+std::vector<int> DisasmSearchIndex::findWord(const std::string& word) const
+{
+	auto it = words.find(word);
+	return it == words.end() ? std::vector<int>() : it->second;
+}
+
+std::vector<int> DisasmSearchIndex::findPattern(const std::string& pattern) const
+{
+	auto mnemonicEnd = pattern.find_first_of(" \t");
+	std::string mnemonic = pattern.substr(0, mnemonicEnd);
+	std::string operands;
+	if (mnemonicEnd != std::string::npos) {
+		for (char c : pattern.substr(mnemonicEnd)) {
+			if (c != ' ' && c != '\t') operands += c;
+		}
+	}
+
+	std::vector<int> result;
+	auto matchOperands = [&](const std::vector<int>& candidates) {
+		for (int id : candidates) {
+			const auto& e = entries[id];
+			if (operands.empty() || operands == "*" ||
+			    globMatch(operands.c_str(), e.text.c_str() + e.operands)) {
+				result.push_back(id);
+			}
+		}
+	};
+	if (mnemonic.find_first_of("*?") == std::string::npos) {
+		auto it = mnemonics.find(mnemonic);
+		if (it != mnemonics.end()) matchOperands(it->second);
+	} else {
+		for (const auto& [m, candidates] : mnemonics) {
+			if (globMatch(mnemonic.c_str(), m.c_str())) matchOperands(candidates);
+		}
+		std::sort(result.begin(), result.end());
+	}
+	return result;
+}
+
+std::vector<int> DisasmSearchIndex::findRegex(const std::string& expression) const
+{
+	std::regex re(expression, std::regex::ECMAScript | std::regex::icase);
+	std::vector<int> result;
+	for (int id = 0; id < size(); ++id) {
+		if (std::regex_search(entries[id].text, re)) result.push_back(id);
+	}
+	return result;
+}
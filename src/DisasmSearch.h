@@ -0,0 +1,57 @@
+#ifndef DISASMSEARCH_H
+#define DISASMSEARCH_H
+
+#include "Dasm.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+class AddressSymbolIndex;
+
+/**
+ * Searchable text of a disassembly. All instructions are rendered once and
+ * indexed by mnemonic and by the words in their operands, so queries only
+ * look at the instructions that can match. Supported queries:
+ *  - a single word, e.g. "ldir", "enaslt" or "#98", matches instructions
+ *    with that mnemonic or operand word
+ *  - an instruction pattern, e.g. "ld (ix+*),*" or "out (#98),a", where '*'
+ *    matches any text within an operand and '?' a single character, a
+ *    lone '*' matches all operands and "+*" also a negative displacement
+ *  - a regular expression over the instruction text
+ * Matching is case insensitive.
+ */
+class DisasmSearchIndex
+{
+public:
+	struct Entry {
+		uint16_t addr;
+		uint16_t segment;
+		uint16_t operands; // start of the operands in text
+		std::string text;  // e.g. "ld (ix+#05),a"
+	};
+
+	void clear();
+	// add the instructions in [start, end) of a disassembled segment
+	void addSegment(uint16_t segment, const DisasmLines& rows,
+	                const AddressSymbolIndex& symbols, uint32_t start, uint32_t end);
+
+	[[nodiscard]] int size() const { return int(entries.size()); }
+	[[nodiscard]] const Entry& entry(int i) const { return entries[i]; }
+
+	// matching entries in segment and address order,
+	// throws std::regex_error for an invalid expression
+	[[nodiscard]] std::vector<int> find(const std::string& query, bool regex = false) const;
+
+private:
+	[[nodiscard]] std::vector<int> findWord(const std::string& word) const;
+	[[nodiscard]] std::vector<int> findPattern(const std::string& pattern) const;
+	[[nodiscard]] std::vector<int> findRegex(const std::string& expression) const;
+
+	std::vector<Entry> entries;
+	std::map<std::string, std::vector<int>> mnemonics;
+	std::unordered_map<std::string, std::vector<int>> words;
+};
+
+#endif // DISASMSEARCH_H
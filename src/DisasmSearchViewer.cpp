@@ -0,0 +1,235 @@
+#include "DisasmSearchViewer.h"
+#include "DisasmExport.h"
+#include "SymbolTable.h"
+#include "Convert.h"
+#include <QCheckBox>
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <regex>
+
+// more results are counted, but not listed
+static const int MAX_LISTED_RESULTS = 5000;
+
+DisasmSearchViewer::DisasmSearchViewer(QWidget* parent)
+	: QWidget(parent)
+{
+	debuggableList = new QComboBox();
+	debuggableList->setEditable(false);
+
+	segmentSizeList = new QComboBox();
+	segmentSizeList->addItems({tr("Whole"), tr("16 kB"), tr("8 kB")});
+	segmentSizeList->setToolTip(tr("Size of the segments of a ROM or mapper"));
+
+	addressEdit = new QLineEdit("#8000");
+	addressEdit->setToolTip(tr("Address where the segments are visible"));
+	addressEdit->setMaximumWidth(fontMetrics().horizontalAdvance("#00000"));
+
+	queryEdit = new QLineEdit();
+	queryEdit->setPlaceholderText(tr("ldir, ld (ix+*),*, out (#98),a, label ..."));
+	queryEdit->setClearButtonEnabled(true);
+
+	regexCheck = new QCheckBox(tr("Regex"));
+
+	resultList = new QTreeWidget();
+	resultList->setColumnCount(2);
+	resultList->setHeaderLabels({tr("Address"), tr("Instruction")});
+	resultList->setRootIsDecorated(false);
+	resultList->setUniformRowHeights(true);
+	resultList->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+
+	statusLabel = new QLabel();
+
+	auto* sourceBox = new QHBoxLayout();
+	sourceBox->addWidget(debuggableList, 1);
+	sourceBox->addWidget(segmentSizeList);
+	sourceBox->addWidget(addressEdit);
+
+	auto* queryBox = new QHBoxLayout();
+	queryBox->addWidget(queryEdit, 1);
+	queryBox->addWidget(regexCheck);
+
+	auto* vbox = new QVBoxLayout();
+	vbox->setMargin(0);
+	vbox->addLayout(sourceBox);
+	vbox->addLayout(queryBox);
+	vbox->addWidget(resultList);
+	vbox->addWidget(statusLabel);
+	setLayout(vbox);
+
+	connect(debuggableList, qOverload<int>(&QComboBox::currentIndexChanged),
+	        this, &DisasmSearchViewer::sourceChanged);
+	connect(segmentSizeList, qOverload<int>(&QComboBox::currentIndexChanged),
+	        this, &DisasmSearchViewer::buildIndex);
+	connect(addressEdit, &QLineEdit::editingFinished, this, &DisasmSearchViewer::buildIndex);
+	connect(queryEdit, &QLineEdit::textChanged, this, &DisasmSearchViewer::search);
+	connect(regexCheck, &QCheckBox::toggled, this, &DisasmSearchViewer::search);
+	connect(resultList, &QTreeWidget::itemActivated, this, &DisasmSearchViewer::resultActivated);
+}
+
+void DisasmSearchViewer::setDebuggables(const QMap<QString, int>& list)
+{
+	debuggables = list;
+	QString current = debuggableList->currentData().toString();
+
+	debuggableList->blockSignals(true);
+	debuggableList->clear();
+	for (auto it = list.begin(); it != list.end(); ++it) {
+		// show the name without braces
+		QString name = it.key();
+		if (name.contains(QChar(' '))) {
+			name = name.mid(1, name.size() - 2);
+		}
+		debuggableList->addItem(name, it.key());
+	}
+	int select = debuggableList->findData(current.isEmpty() ? QString("memory") : current);
+	debuggableList->setCurrentIndex(std::max(select, 0));
+	debuggableList->blockSignals(false);
+
+	if (debuggableList->currentData().toString() != indexedDebuggable) {
+		sourceChanged();
+	}
+}
+
+void DisasmSearchViewer::setSymbolTable(SymbolTable* st)
+{
+	symTable = st;
+}
+
+void DisasmSearchViewer::setMemoryLayout(MemoryLayout* ml)
+{
+	memLayout = ml;
+}
+
+void DisasmSearchViewer::sourceChanged()
+{
+	bool memory = debuggableList->currentData().toString() == "memory";
+	segmentSizeList->setEnabled(!memory);
+	addressEdit->setEnabled(!memory);
+	refresh();
+}
+
+void DisasmSearchViewer::refresh()
+{
+	QString debuggable = debuggableList->currentData().toString();
+	int size = debuggables.value(debuggable);
+	if (size <= 0) return;
+	// the contents of ROMs don't change
+	if (debuggable != "memory" && debuggable == indexedDebuggable) return;
+
+	if (waitingForData) {
+		refreshPending = true;
+		return;
+	}
+	indexedDebuggable = debuggable;
+	image.assign(size, 0);
+	waitingForData = true;
+	statusLabel->setText(tr("Reading %1 ...").arg(debuggableList->currentText()));
+	new SimpleHexRequest(debuggable, 0, size, image.data(), *this);
+}
+
+void DisasmSearchViewer::DataHexRequestReceived()
+{
+	waitingForData = false;
+	if (refreshPending) {
+		refreshPending = false;
+		indexedDebuggable.clear();
+		refresh();
+		return;
+	}
+	buildIndex();
+}
+
+void DisasmSearchViewer::DataHexRequestCanceled()
+{
+	waitingForData = false;
+	refreshPending = false;
+	indexedDebuggable.clear();
+	image.clear();
+	buildIndex();
+}
+
+void DisasmSearchViewer::buildIndex()
+{
+	index.clear();
+	numSegments = 0;
+	if (!image.empty() && symTable) {
+		std::vector<DisasmExporter::Segment> segments;
+		if (indexedDebuggable == "memory") {
+			segments.push_back({0, uint32_t(image.size()), 0});
+		} else {
+			static const uint32_t segmentSizes[] = {0, 0x4000, 0x2000};
+			uint16_t address = stringToValue<uint16_t>(addressEdit->text()).value_or(0);
+			segments = DisasmExporter::split(
+				uint32_t(image.size()), segmentSizes[segmentSizeList->currentIndex()],
+				address, address);
+			if (!DisasmExporter::fits(segments)) {
+				resultList->clear();
+				statusLabel->setText(tr("The segments don't fit below address #10000"));
+				return;
+			}
+		}
+		const auto& symbols = indexedDebuggable == "memory"
+		                    ? symTable->addressIndex(memLayout)
+		                    : symTable->addressIndex();
+
+		std::vector<unsigned char> memory(0x10000 + 4);
+		DisasmLines rows;
+		for (const auto& s : segments) {
+			uint32_t end = s.address + s.size;
+			std::fill(memory.begin(), memory.end(), 0);
+			std::copy_n(image.begin() + s.offset, s.size, memory.begin() + s.address);
+			dasm(memory.data(), s.address, int(end), rows, symbols, 0x20000);
+			index.addSegment(uint16_t(numSegments++), rows, symbols, s.address, end);
+		}
+	}
+	search();
+}
+
+void DisasmSearchViewer::search()
+{
+	resultList->clear();
+	if (queryEdit->text().trimmed().isEmpty()) {
+		statusLabel->setText(tr("%n instruction(s) indexed", "", index.size()));
+		return;
+	}
+
+	std::vector<int> found;
+	try {
+		found = index.find(queryEdit->text().toStdString(), regexCheck->isChecked());
+	} catch (std::regex_error&) {
+		statusLabel->setText(tr("Invalid regular expression"));
+		return;
+	}
+
+	QList<QTreeWidgetItem*> items;
+	for (int id : found) {
+		if (items.size() == MAX_LISTED_RESULTS) break;
+		const auto& e = index.entry(id);
+		QString address = hexValue(e.addr, 4);
+		if (numSegments > 1) {
+			address.prepend(QString("%1:").arg(e.segment, 2, 16, QChar('0')).toUpper());
+		}
+		auto* item = new QTreeWidgetItem({address, QString::fromStdString(e.text)});
+		item->setData(0, Qt::UserRole, e.addr);
+		items.append(item);
+	}
+	resultList->addTopLevelItems(items);
+
+	if (int(found.size()) > MAX_LISTED_RESULTS) {
+		statusLabel->setText(tr("%1 matches, the first %2 are listed")
+		                     .arg(found.size()).arg(MAX_LISTED_RESULTS));
+	} else {
+		statusLabel->setText(tr("%n match(es)", "", int(found.size())));
+	}
+}
+
+void DisasmSearchViewer::resultActivated(QTreeWidgetItem* item)
+{
+	emit addressSelected(item->data(0, Qt::UserRole).toUInt());
+}
@@ -0,0 +1,64 @@
+#ifndef DISASMSEARCHVIEWER_H
+#define DISASMSEARCHVIEWER_H
+
+#include "DisasmSearch.h"
+#include "SimpleHexRequest.h"
+#include <QWidget>
+#include <QMap>
+#include <vector>
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QTreeWidget;
+class QTreeWidgetItem;
+class SymbolTable;
+struct MemoryLayout;
+
+// Searches the disassembly of the memory or of a complete debuggable.
+class DisasmSearchViewer : public QWidget, public SimpleHexRequestUser
+{
+	Q_OBJECT
+public:
+	DisasmSearchViewer(QWidget* parent = nullptr);
+
+	void setDebuggables(const QMap<QString, int>& list);
+	void setSymbolTable(SymbolTable* st);
+	void setMemoryLayout(MemoryLayout* ml);
+	// read the data again and rebuild the index
+	void refresh();
+
+signals:
+	void addressSelected(uint16_t addr);
+
+private:
+	void DataHexRequestReceived() override;
+	void DataHexRequestCanceled() override;
+
+	void sourceChanged();
+	void buildIndex();
+	void search();
+	void resultActivated(QTreeWidgetItem* item);
+
+	QComboBox* debuggableList;
+	QComboBox* segmentSizeList;
+	QLineEdit* addressEdit;
+	QLineEdit* queryEdit;
+	QCheckBox* regexCheck;
+	QTreeWidget* resultList;
+	QLabel* statusLabel;
+
+	QMap<QString, int> debuggables;
+	SymbolTable* symTable = nullptr;
+	MemoryLayout* memLayout = nullptr;
+
+	QString indexedDebuggable;
+	std::vector<unsigned char> image;
+	bool waitingForData = false;
+	bool refreshPending = false;
+	DisasmSearchIndex index;
+	int numSegments = 0;
+};
+
+#endif // DISASMSEARCHVIEWER_H
@@ -2,19 +2,31 @@
 #include "OpenMSXConnection.h"
 #include "CommClient.h"
 #include "DebuggerData.h"
+#include "SymbolTable.h"
 #include "Settings.h"
+#include "CodeAnalyzer.h"
+#include "LoopAnalysis.h"
+#include "OfflineImage.h"
 #include <QPaintEvent>
 #include <QPainter>
 #include <QStyleOptionFocusRect>
 #include <QScrollBar>
 #include <QWheelEvent>
+#include <QAction>
 #include <QApplication>
 #include <QClipboard>
 #include <QDesktopWidget>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QMessageBox>
 #include <algorithm>
 #include <cmath>
 #include <cassert>
-#include <regex>
+
+// loop nesting levels shown left of the addresses
+static const int LOOP_LEVELS = 4;
+static const int LOOP_SPACING = 4;
+static const int LOOP_MARGIN = LOOP_LEVELS * LOOP_SPACING;
 
 class CommMemoryRequest : public ReadDebugBlockCommand
 {
@@ -66,6 +78,7 @@ DisasmViewer::DisasmViewer(QWidget* parent)
 	memory = nullptr;
 	cursorAddr = 0;
 	cursorLine = 0;
+	selectAnchor = -1;
 	visibleLines = 0;
 	programAddr = 0xFFFF;
 	waitingForData = false;
@@ -77,6 +90,28 @@ DisasmViewer::DisasmViewer(QWidget* parent)
 	scrollBar->setSingleStep(0);
 	scrollBar->setPageStep(0);
 
+	showCycles = Settings::get().value("CodeView/ShowCycles", false).toBool();
+	showCyclesAction = new QAction(tr("Show T-states"), this);
+	showCyclesAction->setStatusTip(tr("Show the instruction timing and the total per basic block."));
+	showCyclesAction->setCheckable(true);
+	showCyclesAction->setChecked(showCycles);
+	connect(showCyclesAction, &QAction::toggled, this, &DisasmViewer::setShowCycles);
+	addAction(showCyclesAction);
+
+	compareSnapshotAction = new QAction(tr("Compare with snapshot"), this);
+	compareSnapshotAction->setStatusTip(tr("Take a snapshot of the memory and highlight the bytes that change from now on."));
+	connect(compareSnapshotAction, &QAction::triggered, this, &DisasmViewer::compareWithSnapshot);
+	addAction(compareSnapshotAction);
+	compareRomAction = new QAction(tr("Compare with ROM image..."), this);
+	compareRomAction->setStatusTip(tr("Highlight the bytes that differ from the ROM image mapped in the cartridge slot."));
+	connect(compareRomAction, &QAction::triggered, this, &DisasmViewer::compareWithRom);
+	addAction(compareRomAction);
+	stopComparingAction = new QAction(tr("Stop comparing"), this);
+	stopComparingAction->setEnabled(false);
+	connect(stopComparingAction, &QAction::triggered, this, &DisasmViewer::stopComparing);
+	addAction(stopComparingAction);
+	setContextMenuPolicy(Qt::ActionsContextMenu);
+
 	updateLayout();
 
 	// manual scrollbar handling routines (real size of the data is not known)
@@ -122,12 +157,18 @@ void DisasmViewer::updateLayout()
 
 	// calculate layout locations
 	int charWidth = cfm.horizontalAdvance("0");
-	xAddr = frameL + 40;
+	xAddr = frameL + 40 + (loopAnalysis ? LOOP_MARGIN : 0);
 	xMCode[0] = xAddr     + 6 * charWidth;
 	xMCode[1] = xMCode[0] + 3 * charWidth;
 	xMCode[2] = xMCode[1] + 3 * charWidth;
 	xMCode[3] = xMCode[2] + 3 * charWidth;
-	xMnem = xMCode[3] + 4 * charWidth;
+	if (showCycles) {
+		xCycles = xMCode[3] + 4 * charWidth;
+		xBlockCycles = xCycles + 6 * charWidth;
+		xMnem = xBlockCycles + 6 * charWidth;
+	} else {
+		xCycles = xBlockCycles = xMnem = xMCode[3] + 4 * charWidth;
+	}
 	xMnemArg = xMnem  + 7 * charWidth;
 
 	setMinimumSize(xMCode[0], 2*codeFontHeight);
@@ -136,6 +177,13 @@ void DisasmViewer::updateLayout()
 	update();
 }
 
+void DisasmViewer::setShowCycles(bool enabled)
+{
+	showCycles = enabled;
+	Settings::get().setValue("CodeView/ShowCycles", enabled);
+	updateLayout();
+}
+
 void DisasmViewer::requestMemory(uint16_t start, uint16_t end, uint16_t addr, int infoLine, int method)
 {
 	auto* req = new CommMemoryRequest(start, end - start, &memory[start], *this);
@@ -161,6 +209,28 @@ void DisasmViewer::refresh()
 	requestMemory(start, end, disasmLines[disasmTopLine].addr, infoLine, TopAlways);
 }
 
+void DisasmViewer::symbolsReloaded(const SymbolChanges& changes)
+{
+	// The rows refer to positions in the symbol index, so the memory that
+	// is shown is disassembled again, without asking openMSX for it. Only
+	// redraw when a label or an operand of the shown rows changed.
+	int start = disasmLines.front().addr;
+	int end = disasmLines.back().addr + disasmLines.back().numBytes - 1;
+	bool affected = changes.affects(start, end) ||
+		std::any_of(disasmLines.begin(), disasmLines.end(), [&](const DisasmRow& row) {
+			return row.hasAddressOperand() && changes.affects(row.operand, row.operand);
+		});
+	uint16_t topAddr = disasmLines[disasmTopLine].addr;
+	int topLine = disasmLines[disasmTopLine].infoLine;
+
+	dasm(memory, start, std::min(end, 0xFFFF), disasmLines, memLayout, symTable, programAddr);
+	textCache.clear();
+	updateBlockCycles();
+	disasmTopLine = findDisasmLine(topAddr, topLine);
+	disasmTopLine = std::max(std::min(disasmTopLine, int(disasmLines.size()) - visibleLines), 0);
+	if (affected) update();
+}
+
 void DisasmViewer::paintEvent(QPaintEvent* e)
 {
 	// call parent for drawing the actual frame
@@ -187,6 +257,7 @@ void DisasmViewer::paintEvent(QPaintEvent* e)
 	QString hexStr;
 	const DisasmRow* row;
 	bool displayDisasm = memory != nullptr && isEnabled();
+	const AddressSymbolIndex& symbols = symTable->addressIndex(memLayout);
 
 	Settings& s = Settings::get();
 	p.setFont(s.font(Settings::CODE_FONT));
@@ -221,12 +292,20 @@ void DisasmViewer::paintEvent(QPaintEvent* e)
 				style()->drawPrimitive(QStyle::PE_FrameFocusRect, &so, &p, this);
 			}
 			p.setPen(palette().color(QPalette::HighlightedText));
+		} else if (displayDisasm && isSelected(*row)) {
+			QColor c = palette().color(QPalette::Highlight);
+			c.setAlpha(64);
+			p.fillRect(frameL + 32, y, width() - 32 - frameL - frameR, h, c);
+		}
+
+		if (loopAnalysis && displayDisasm) {
+			drawLoopMarkers(p, *row, y, h);
 		}
 
 		// if there is a label here, draw the label, otherwise code
 		if (row->rowType == DisasmRow::LABEL) {
 			// draw label
-			hexStr = QString("%1:").arg(row->instr.c_str());
+			hexStr = QString("%1:").arg(textCache.text(*row, symbols).c_str());
 			p.setFont(s.font(Settings::LABEL_FONT));
 			if (!isCursorLine) {
 				p.setPen(s.fontColor(Settings::LABEL_FONT));
@@ -262,15 +341,70 @@ void DisasmViewer::paintEvent(QPaintEvent* e)
 			hexStr = QString("%1").arg(row->addr, 4, 16, QChar('0')).toUpper();
 			p.drawText(xAddr, y + a, hexStr);
 
-			// print 1 to 4 bytes
+			// print 1 to 4 bytes, the changed ones highlighted
 			for (int j = 0; j < row->numBytes; ++j) {
-				hexStr = QString("%1").arg(displayDisasm ? memory[row->addr + j] : 0, 2, 16, QChar('0')).toUpper();
+				uint16_t byteAddr = row->addr + j;
+				hexStr = QString("%1").arg(displayDisasm ? memory[byteAddr] : 0, 2, 16, QChar('0')).toUpper();
+				if (displayDisasm && memoryDiff.differs(byteAddr)) {
+					p.fillRect(xMCode[j] - 1, y, p.fontMetrics().horizontalAdvance(hexStr) + 2, h,
+					           QColor(255, 160, 96));
+				}
 				p.drawText(xMCode[j], y + a, hexStr);
 			}
 
+			// print the timing and the basic block total
+			if (showCycles && displayDisasm && row->cycles) {
+				hexStr = QString::number(row->cycles);
+				if (row->cyclesNotTaken != row->cycles) {
+					hexStr += QString("/%1").arg(row->cyclesNotTaken);
+				}
+				p.drawText(xCycles, y + a, hexStr);
+				if (int total = blockCycles[disasmTopLine + visibleLines]) {
+					p.drawText(xBlockCycles, y + a, QString("=%1").arg(total));
+				}
+			}
+
 			// print the instruction and arguments
-			p.drawText(xMnem,    y + a, row->instr.substr(0, 7).c_str());
-			p.drawText(xMnemArg, y + a, row->instr.substr(7   ).c_str());
+			if (displayDisasm) {
+				const std::string& instr = textCache.text(*row, symbols);
+				QString args = instr.substr(7).c_str();
+				p.drawText(xMnem,    y + a, instr.substr(0, 7).c_str());
+				p.drawText(xMnemArg, y + a, args);
+
+				// annotate the start of a routine with its stack use
+				// and a loop header with the cost of an iteration
+				const CallGraph::Routine* routine = callGraph && row->infoLine == 0
+				                                  ? callGraph->routine(row->addr) : nullptr;
+				const LoopAnalysis::Loop* loop = loopAnalysis && row->infoLine == 0
+				                               ? loopAnalysis->loop(row->addr) : nullptr;
+				QStringList notes;
+				const auto* source = symTable && row->infoLine == 0
+				                   ? symTable->sourceLine(row->addr, memLayout) : nullptr;
+				if (source) {
+					QString file = QString::fromStdString(symTable->sourceFile(*source));
+					notes << QString("%1:%2").arg(file.section('/', -1)).arg(source->line);
+				}
+				if (routine) {
+					notes << tr("stack %1").arg(CodeAnalyzer::stackUse(*routine));
+				}
+				if (loop) {
+					QString cycles = QString::number(loop->maxCycles);
+					if (loop->minCycles != loop->maxCycles) {
+						cycles.prepend(QString("%1..").arg(loop->minCycles));
+					}
+					notes << tr("loop %1 T/iteration").arg(cycles);
+				}
+				if (!notes.isEmpty()) {
+					if (!isCursorLine) {
+						p.setPen(routine && CodeAnalyzer::isSuspect(*routine) ? QColor(192, 0, 0)
+						                                                      : QColor(128, 128, 128));
+					}
+					int x = xMnemArg + p.fontMetrics().horizontalAdvance(args + "  ");
+					p.drawText(x, y + a, "; " + notes.join(", "));
+				}
+			} else {
+				p.drawText(xMnem,    y + a, "-");
+			}
 		}
 		// next line
 		y += h;
@@ -293,19 +427,21 @@ void DisasmViewer::copyCodeToClipboard() const
 	int maxY = height() - frameB;
 	int maxLine = int(disasmLines.size());
 	int y = frameT;
+	const AddressSymbolIndex& symbols = symTable->addressIndex(memLayout);
 
 	for (int currentLine = disasmTopLine;
 			(y < maxY) && (currentLine < maxLine);
 			++currentLine) {
 		const DisasmRow* row = &disasmLines[currentLine];
+		std::string instr = disasmText(*row, symbols);
 		switch (row->rowType) {
 			case DisasmRow::INSTRUCTION:
 				buffer += QString("%1%2\n")
-						.arg(row->instr.substr(0, 7).c_str())
-						.arg(row->instr.substr(7   ).c_str());
+						.arg(instr.substr(0, 7).c_str())
+						.arg(instr.substr(7   ).c_str());
 				break;
 			case DisasmRow::LABEL:
-				buffer += QString("%1:\n").arg(row->instr.c_str());
+				buffer += QString("%1:\n").arg(instr.c_str());
 				break;
 		}
 		// next line
@@ -319,6 +455,7 @@ void DisasmViewer::setCursorAddress(uint16_t addr, int infoLine, int method)
 {
 	cursorAddr = addr;
 	cursorLine = 0;
+	selectAnchor = -1;
 	setAddress(addr, infoLine, method);
 }
 
@@ -432,6 +569,9 @@ void DisasmViewer::memoryUpdated(CommMemoryRequest* req)
 	// disassemble the newly received memory
 	dasm(memory, req->offset, req->offset + req->size - 1, disasmLines,
 	     memLayout, symTable, programAddr);
+	textCache.clear();
+	memoryDiff.update(memory, req->offset, req->size);
+	updateBlockCycles();
 
 	// locate the requested line
 	disasmTopLine = findDisasmLine(req->address, req->line);
@@ -493,6 +633,7 @@ void DisasmViewer::setProgramCounter(uint16_t pc, bool reload)
 {
 	cursorAddr = pc;
 	programAddr = pc;
+	selectAnchor = -1;
 	setAddress(pc, 0, reload ? Reload : MiddleAlways);
 }
 
@@ -565,17 +706,78 @@ void DisasmViewer::setMemory(unsigned char* memPtr)
 {
 	memory = memPtr;
 	// init disasmLines
-	DisasmRow newRow;
+	DisasmRow newRow = {};
 	newRow.rowType = DisasmRow::INSTRUCTION;
+	newRow.table = DisasmRow::MAIN; // nop
 	newRow.numBytes = 1;
-	newRow.infoLine = 0;
-	newRow.instr = "nop";
-	newRow.instr.resize(8, ' ');
+	newRow.symbol = -1;
+	disasmLines.clear();
+	disasmLines.reserve(150);
 	for (int i = 0; i < 150; ++i) {
 		newRow.addr = i;
 		disasmLines.push_back(newRow);
 	}
 	disasmTopLine = 50;
+	textCache.clear();
+	updateBlockCycles();
+}
+
+void DisasmViewer::updateBlockCycles()
+{
+	// Only blocks that start within the disassembled range (after a label
+	// or a control transfer) get a total, the others would be misleading.
+	blockCycles.assign(disasmLines.size(), 0);
+	int total = 0;
+	bool complete = false;
+	for (size_t i = 0; i < disasmLines.size(); ++i) {
+		const DisasmRow& row = disasmLines[i];
+		if (row.rowType == DisasmRow::LABEL) {
+			total = 0;
+			complete = true;
+		} else if (row.cycles == 0) {
+			// data, the block can't be timed
+			complete = false;
+		} else {
+			total += row.cycles;
+			if (row.blockEnd) {
+				if (complete) blockCycles[i] = total;
+				total = 0;
+				complete = true;
+			}
+		}
+	}
+}
+
+void DisasmViewer::updateSelectionAnchor(Qt::KeyboardModifiers modifiers)
+{
+	if (modifiers & Qt::ShiftModifier) {
+		if (selectAnchor < 0) selectAnchor = cursorAddr;
+	} else {
+		selectAnchor = -1;
+	}
+}
+
+bool DisasmViewer::isSelected(const DisasmRow& row) const
+{
+	if (selectAnchor < 0) return false;
+	int first = std::min<int>(selectAnchor, cursorAddr);
+	int last  = std::max<int>(selectAnchor, cursorAddr);
+	return row.addr >= first && row.addr <= last;
+}
+
+void DisasmViewer::emitSelectedCycles()
+{
+	int first = selectAnchor < 0 ? cursorAddr : std::min<int>(selectAnchor, cursorAddr);
+	int last  = selectAnchor < 0 ? cursorAddr : std::max<int>(selectAnchor, cursorAddr);
+	int instructions = 0, cycles = 0, cyclesNotTaken = 0;
+	for (const auto& row : disasmLines) {
+		if (row.rowType != DisasmRow::INSTRUCTION || row.cycles == 0) continue;
+		if (row.addr < first || row.addr > last) continue;
+		++instructions;
+		cycles += row.cycles;
+		cyclesNotTaken += row.cyclesNotTaken;
+	}
+	emit cyclesSelected(instructions, cycles, cyclesNotTaken);
 }
 
 void DisasmViewer::setBreakpoints(Breakpoints* bps)
@@ -593,8 +795,201 @@ void DisasmViewer::setSymbolTable(SymbolTable* st)
 	symTable = st;
 }
 
+void DisasmViewer::setCallGraph(std::shared_ptr<const CallGraph> graph)
+{
+	callGraph = std::move(graph);
+	update();
+}
+
+void DisasmViewer::setLoopAnalysis(std::shared_ptr<const LoopAnalysis> loops)
+{
+	bool layoutChanged = !loops != !loopAnalysis;
+	loopAnalysis = std::move(loops);
+	if (layoutChanged) {
+		updateLayout();
+	} else {
+		update();
+	}
+}
+
+void DisasmViewer::compareWithSnapshot()
+{
+	if (waitingForSnapshot) return;
+	snapshot.assign(0x10000, 0);
+	waitingForSnapshot = true;
+	new SimpleHexRequest("memory", 0, 0x10000, snapshot.data(), *this);
+}
+
+void DisasmViewer::DataHexRequestReceived()
+{
+	waitingForSnapshot = false;
+	romImage.reset();
+	memoryDiff.setReference(snapshot.data());
+	snapshot.clear();
+	compareChanged();
+}
+
+void DisasmViewer::DataHexRequestCanceled()
+{
+	waitingForSnapshot = false;
+	snapshot.clear();
+}
+
+void DisasmViewer::compareWithRom()
+{
+	if (!memLayout) return;
+	QString title = tr("Compare with ROM image");
+	QString filename = QFileDialog::getOpenFileName(
+		this, title, QString(), tr("ROM images (*.rom *.ri *.bin);;All files (*)"));
+	if (filename.isEmpty()) return;
+	auto image = OfflineImage::open(filename);
+	if (!image) {
+		QMessageBox::warning(this, title, tr("Can't read %1.").arg(filename));
+		return;
+	}
+
+	// the ROM is in the slot that shows mapper blocks, or else in the
+	// slot visible at #4000
+	const auto& ml = *memLayout;
+	int romPage = 1;
+	auto it = std::find_if(std::begin(ml.romBlock), std::end(ml.romBlock),
+	                       [](int b) { return b >= 0; });
+	if (it != std::end(ml.romBlock)) {
+		romPage = int(it - std::begin(ml.romBlock)) / 2;
+	}
+	// openMSX gives the mapper blocks in units of the bank size
+	int blocksPerBank = 1;
+	if (it != std::end(ml.romBlock)) {
+		bool ok;
+		QStringList sizes = {tr("8 kB"), tr("16 kB")};
+		QString size = QInputDialog::getItem(this, title, tr("Size of the mapper banks:"),
+		                                     sizes, 0, false, &ok);
+		if (!ok) return;
+		blocksPerBank = size == sizes[1] ? 2 : 1;
+	}
+
+	romImage = std::move(image);
+	romSlot = ml.primarySlot[romPage];
+	romSubslot = ml.secondarySlot[romPage];
+	romBlocksPerBank = blocksPerBank;
+	auto blocks = romBlocks();
+	if (std::all_of(blocks.begin(), blocks.end(),
+	                [](int b) { return b == OfflineImage::UNMAPPED; })) {
+		romImage.reset();
+		QMessageBox::warning(this, title, tr("The image doesn't fit in the visible slots."));
+		return;
+	}
+	setRomReference(blocks);
+	compareChanged();
+}
+
+// the image block visible in each 8kB region of the current layout
+std::array<int, 8> DisasmViewer::romBlocks() const
+{
+	std::array<int, 8> blocks;
+	const auto& ml = *memLayout;
+	for (int q = 0; q < 8; ++q) {
+		blocks[q] = OfflineImage::UNMAPPED;
+		if (ml.primarySlot[q / 2] != romSlot || ml.secondarySlot[q / 2] != romSubslot) continue;
+		int block = ml.romBlock[q] >= 0
+		          ? ml.romBlock[q] * romBlocksPerBank + (romBlocksPerBank == 2 ? q % 2 : 0)
+		          : romImage->block(q);
+		if (block == OfflineImage::UNMAPPED) continue;
+		if ((block + 1) * OfflineImage::BLOCK_SIZE > romImage->size()) continue;
+		blocks[q] = block;
+	}
+	return blocks;
+}
+
+void DisasmViewer::setRomReference(const std::array<int, 8>& blocks)
+{
+	std::vector<uint8_t> reference(0x10000, 0xFF);
+	uint8_t regions = 0;
+	for (int q = 0; q < 8; ++q) {
+		if (blocks[q] == OfflineImage::UNMAPPED) continue;
+		std::copy_n(romImage->data() + blocks[q] * OfflineImage::BLOCK_SIZE,
+		            OfflineImage::BLOCK_SIZE, &reference[q * OfflineImage::BLOCK_SIZE]);
+		regions |= 1 << q;
+	}
+	romMapping = blocks;
+	memoryDiff.setReference(reference.data(), regions);
+}
+
+void DisasmViewer::memoryLayoutChanged()
+{
+	if (!romImage || !memLayout) return;
+	auto blocks = romBlocks();
+	if (blocks == romMapping) return;
+	setRomReference(blocks);
+	compareChanged();
+}
+
+void DisasmViewer::stopComparing()
+{
+	romImage.reset();
+	memoryDiff.clear();
+	compareChanged();
+}
+
+void DisasmViewer::compareChanged()
+{
+	// a ROM that isn't visible in the current layout is still compared with
+	stopComparingAction->setEnabled(memoryDiff.isActive() || romImage);
+	if (memory && !disasmLines.empty()) {
+		int start = disasmLines.front().addr;
+		int end = disasmLines.back().addr + disasmLines.back().numBytes;
+		memoryDiff.update(memory, start, std::min(end, 0x10000) - start);
+	}
+	update();
+}
+
+void DisasmViewer::drawLoopMarkers(QPainter& p, const DisasmRow& row, int y, int h)
+{
+	// a bar per nesting level, the loop header and the jumps back
+	// are marked with a tick towards the code
+	int depth = loopAnalysis->depth(row.addr);
+	const LoopAnalysis::Loop* header = loopAnalysis->loop(row.addr);
+	if (row.rowType == DisasmRow::LABEL && header) --depth;
+	bool latch = row.rowType == DisasmRow::INSTRUCTION && loopAnalysis->isLatch(row.addr);
+
+	p.save();
+	p.setPen(QColor(128, 128, 128));
+	for (int level = 1; level <= std::min(depth, LOOP_LEVELS); ++level) {
+		int x = frameL + 34 + LOOP_SPACING * (level - 1);
+		int top = y;
+		int bottom = y + h - 1;
+		if (row.rowType == DisasmRow::INSTRUCTION && header && level == header->depth) {
+			top = y + h / 2;
+			p.drawLine(x, top, x + LOOP_SPACING - 1, top);
+		}
+		if (latch && level == depth) {
+			bottom = y + h / 2;
+			p.drawLine(x, bottom, x + LOOP_SPACING - 1, bottom);
+		}
+		p.drawLine(x, top, x, bottom);
+	}
+	p.restore();
+}
+
 void DisasmViewer::keyPressEvent(QKeyEvent* e)
 {
+	switch (e->key()) {
+	case Qt::Key_Up:
+	case Qt::Key_Down:
+	case Qt::Key_PageUp:
+	case Qt::Key_PageDown:
+		updateSelectionAnchor(e->modifiers());
+		break;
+	case Qt::Key_Home:
+	case Qt::Key_End:
+	case Qt::Key_Right:
+	case Qt::Key_Return:
+	case Qt::Key_Left:
+	case Qt::Key_Backspace:
+		selectAnchor = -1;
+		break;
+	}
+
 	switch (e->key()) {
 	case Qt::Key_Up: {
 		int line = findDisasmLine(cursorAddr, cursorLine);
@@ -672,18 +1067,12 @@ void DisasmViewer::keyPressEvent(QKeyEvent* e)
 	case Qt::Key_Return: {
 		int line = findDisasmLine(cursorAddr, cursorLine);
 		if (line >= 0 && line < int(disasmLines.size())) {
-			int naddr = INT_MAX;
+			// follow call, jp, jr and djnz
 			const DisasmRow &row = disasmLines[line];
-			std::string instr = row.instr;
-			std::regex re_absolute("(call|jp)\\ .*");
-			std::regex re_relative("(djnz|jr)\\ .*");
-			if (std::regex_match(instr, re_absolute))
-				naddr = memory[row.addr + 1] + memory[row.addr + 2] * 256;
-			else if (std::regex_match(instr, re_relative))
-				naddr = (row.addr + 2 + (signed char)memory[row.addr + 1]) & 0xFFFF;
-			if (naddr != INT_MAX) {
+			if (row.rowType == DisasmRow::INSTRUCTION && row.blockEnd &&
+			    row.hasAddressOperand()) {
 				jumpStack.push_back(cursorAddr);
-				setCursorAddress(naddr, 0, Middle);
+				setCursorAddress(row.operand, 0, Middle);
 			}
 		}
 		e->accept();
@@ -700,7 +1089,9 @@ void DisasmViewer::keyPressEvent(QKeyEvent* e)
 	}
 	default:
 		QFrame::keyReleaseEvent(e);
+		return;
 	}
+	emitSelectedCycles();
 }
 
 void DisasmViewer::wheelEvent(QWheelEvent* e)
@@ -729,8 +1120,10 @@ void DisasmViewer::mousePressEvent(QMouseEvent* e)
 			// check if the line exists
 			// (bottom of memory could have an empty line)
 			if (line + disasmTopLine < int(disasmLines.size())) {
+				updateSelectionAnchor(e->modifiers());
 				cursorAddr = disasmLines[disasmTopLine + line].addr;
 				cursorLine = disasmLines[disasmTopLine + line].infoLine;
+				emitSelectedCycles();
 			} else {
 				return;
 			}
@@ -2,16 +2,27 @@
 #define DISASMVIEWER_H
 
 #include "Dasm.h"
+#include "MemoryDiff.h"
+#include "OfflineImage.h"
+#include "SimpleHexRequest.h"
 #include <QFrame>
 #include <QPixmap>
+#include <array>
+#include <memory>
+#include <vector>
 
 class CommMemoryRequest;
 class QScrollBar;
+class QAction;
+class QPainter;
 class Breakpoints;
+class CallGraph;
+class LoopAnalysis;
 class SymbolTable;
+struct SymbolChanges;
 struct MemoryLayout;
 
-class DisasmViewer : public QFrame
+class DisasmViewer : public QFrame, public SimpleHexRequestUser
 {
 	Q_OBJECT
 public:
@@ -21,6 +32,8 @@ public:
 	void setBreakpoints(Breakpoints* bps);
 	void setMemoryLayout(MemoryLayout* ml);
 	void setSymbolTable(SymbolTable* st);
+	void setCallGraph(std::shared_ptr<const CallGraph> graph);
+	void setLoopAnalysis(std::shared_ptr<const LoopAnalysis> loops);
 	void memoryUpdated(CommMemoryRequest* req);
 	void updateCancelled(CommMemoryRequest* req);
 	uint16_t programCounter() const;
@@ -38,6 +51,10 @@ public:
 	void scrollBarChanged(int value);
 	void updateLayout();
 	void refresh();
+	void symbolsReloaded(const SymbolChanges& changes);
+	void setShowCycles(bool enabled);
+	// the slot viewer updated the memory layout
+	void memoryLayoutChanged();
 
 private:
 	void requestMemory(uint16_t start, uint16_t end, uint16_t addr, int infoLine, int method);
@@ -49,9 +66,26 @@ private:
 	void mousePressEvent(QMouseEvent* e) override;
 	void wheelEvent(QWheelEvent* e) override;
 
+	void drawLoopMarkers(QPainter& p, const DisasmRow& row, int y, int h);
+
+	// self-modifying code, the bytes that differ from a reference
+	void compareWithSnapshot();
+	void compareWithRom();
+	std::array<int, 8> romBlocks() const;
+	void setRomReference(const std::array<int, 8>& blocks);
+	void stopComparing();
+	void compareChanged();
+	void DataHexRequestReceived() override;
+	void DataHexRequestCanceled() override;
+
 	int findDisasmLine(uint16_t lineAddr, int infoLine = 0);
 	int lineAtPos(const QPoint& pos);
 
+	void updateBlockCycles();
+	void updateSelectionAnchor(Qt::KeyboardModifiers modifiers);
+	bool isSelected(const DisasmRow& row) const;
+	void emitSelectedCycles();
+
 private:
 	QScrollBar* scrollBar;
 
@@ -62,6 +96,7 @@ private:
 	uint16_t programAddr;
 	uint16_t cursorAddr;
 	int cursorLine;
+	int selectAnchor; // -1 when only the cursor line is selected
 
 	QList<int> jumpStack;
 
@@ -71,10 +106,18 @@ private:
 	int frameL, frameR, frameT, frameB;
 	int labelFontHeight, labelFontAscent;
 	int codeFontHeight,  codeFontAscent;
-	int xAddr, xMCode[4], xMnem, xMnemArg;
+	int xAddr, xMCode[4], xCycles, xBlockCycles, xMnem, xMnemArg;
 	int visibleLines, partialBottomLine;
 	int disasmTopLine;
 	DisasmLines disasmLines;
+	DisasmTextCache textCache;
+	// per line: total T-states of the basic block ending at that line
+	std::vector<int> blockCycles;
+	bool showCycles;
+	QAction* showCyclesAction;
+	QAction* compareSnapshotAction;
+	QAction* compareRomAction;
+	QAction* stopComparingAction;
 
 	// display data
 	unsigned char* memory;
@@ -83,9 +126,22 @@ private:
 	Breakpoints* breakpoints;
 	MemoryLayout* memLayout;
 	SymbolTable* symTable;
+	std::shared_ptr<const CallGraph> callGraph;
+	std::shared_ptr<const LoopAnalysis> loopAnalysis;
+	MemoryDiff memoryDiff;
+	std::vector<uint8_t> snapshot;
+	bool waitingForSnapshot = false;
+	// the ROM that is compared with, it is mapped again when a bank or
+	// slot switch changes the image block visible in an 8kB region
+	std::unique_ptr<OfflineImage> romImage;
+	int romSlot = 0;
+	int romSubslot = -1;
+	int romBlocksPerBank = 1;
+	std::array<int, 8> romMapping;
 
 signals:
 	void breakpointToggled(int addr);
+	void cyclesSelected(int instructions, int cycles, int cyclesNotTaken);
 };
 
 #endif // DISASMVIEWER_H
@@ -0,0 +1,159 @@
+#include "ExecutionPreviewDialog.h"
+#include "Dasm.h"
+#include "SymbolTable.h"
+#include "Convert.h"
+#include <QStringList>
+#include <algorithm>
+
+// memory writes listed per instruction, block moves write many more
+static const int MAX_LISTED_WRITES = 4;
+
+ExecutionPreviewDialog::ExecutionPreviewDialog(
+		const Z80Core::Registers& regs, MemoryLayout& ml,
+		SymbolTable& symTable_, QWidget* parent)
+	: QDialog(parent), startRegs(regs), memLayout(ml), symTable(symTable_)
+	, snapshot(0x10000 + 3)
+{
+	setupUi(this);
+	btnRun->setEnabled(false);
+	lblSummary->setText(tr("Reading memory ..."));
+
+	connect(btnRun, &QPushButton::clicked, this, &ExecutionPreviewDialog::run);
+	connect(spnSteps, &QSpinBox::editingFinished, this, &ExecutionPreviewDialog::run);
+	connect(edtPatch, &QLineEdit::returnPressed, this, &ExecutionPreviewDialog::run);
+
+	new SimpleHexRequest("memory", 0, 0x10000, snapshot.data(), *this);
+}
+
+void ExecutionPreviewDialog::accept()
+{
+	// the pending request still writes to this dialog
+	if (waitingForData) return;
+	QDialog::accept();
+}
+
+void ExecutionPreviewDialog::reject()
+{
+	if (waitingForData) return;
+	QDialog::reject();
+}
+
+void ExecutionPreviewDialog::DataHexRequestReceived()
+{
+	waitingForData = false;
+	btnRun->setEnabled(true);
+	run();
+}
+
+void ExecutionPreviewDialog::DataHexRequestCanceled()
+{
+	waitingForData = false;
+	lblSummary->setText(tr("Could not read the memory."));
+}
+
+bool ExecutionPreviewDialog::applyPatch(std::vector<uint8_t>& memory) const
+{
+	QString text = edtPatch->text().trimmed();
+	if (text.isEmpty()) return true;
+
+	int colon = text.indexOf(':');
+	if (colon < 0) return false;
+	auto addr = stringToValue<int>(text.left(colon));
+	if (!addr || *addr < 0 || *addr > 0xFFFF) return false;
+	QStringList bytes = text.mid(colon + 1).split(" ", Qt::SplitBehaviorFlags::SkipEmptyParts);
+	if (bytes.isEmpty()) return false;
+
+	std::vector<uint8_t> patch;
+	for (const auto& b : bytes) {
+		bool ok;
+		unsigned value = b.toUInt(&ok, 16);
+		if (!ok || value > 0xFF) return false;
+		patch.push_back(uint8_t(value));
+	}
+	for (size_t i = 0; i < patch.size(); ++i) {
+		memory[(*addr + i) & 0xFFFF] = patch[i];
+	}
+	return true;
+}
+
+void ExecutionPreviewDialog::run()
+{
+	if (waitingForData) return;
+
+	// every run starts again from the break
+	std::vector<uint8_t> memory = snapshot;
+	if (!applyPatch(memory)) {
+		lblSummary->setText(tr("The patch must be an address and hex bytes, e.g. #4000: 3E 01 C9"));
+		return;
+	}
+	Z80Core core(memory.data());
+	core.regs = startRegs;
+
+	QStringList writes;
+	int numWrites = 0;
+	core.writeFilter = [&](uint16_t addr, uint8_t value) {
+		if (numWrites++ < MAX_LISTED_WRITES) {
+			writes << QString("(%1)=%2").arg(hexValue(addr, 4), hexValue(value, 2));
+		}
+		return true;
+	};
+
+	const auto& symbols = symTable.addressIndex(&memLayout);
+	QList<QTreeWidgetItem*> items;
+	DisasmLines rows;
+	uint64_t cycles = 0;
+	int steps = spnSteps->value();
+	int i = 0;
+	for (; i < steps && !core.halted; ++i) {
+		uint16_t pc = core.regs.pc;
+		dasm(memory.data(), pc, pc + 4, rows, symbols, 0x20000);
+		auto row = std::find_if(rows.begin(), rows.end(), [](const DisasmRow& r) {
+			return r.rowType == DisasmRow::INSTRUCTION;
+		});
+
+		auto before = core.regs;
+		writes.clear();
+		numWrites = 0;
+		int t = core.step();
+		cycles += t;
+
+		// registers that changed, F is left out because it changes so often
+		const auto& after = core.regs;
+		QStringList changes;
+		auto reg = [&](const char* name, uint16_t b, uint16_t a, int width) {
+			if (a != b) changes << QString("%1=%2").arg(name, hexValue(a, width));
+		};
+		reg("A", before.af >> 8, after.af >> 8, 2);
+		reg("BC", before.bc, after.bc, 4);
+		reg("DE", before.de, after.de, 4);
+		reg("HL", before.hl, after.hl, 4);
+		reg("IX", before.ix, after.ix, 4);
+		reg("IY", before.iy, after.iy, 4);
+		reg("SP", before.sp, after.sp, 4);
+		reg("AF'", before.af2, after.af2, 4);
+		reg("BC'", before.bc2, after.bc2, 4);
+		reg("DE'", before.de2, after.de2, 4);
+		reg("HL'", before.hl2, after.hl2, 4);
+		changes << writes;
+		if (numWrites > MAX_LISTED_WRITES) {
+			changes << tr("%n more write(s)", "", numWrites - MAX_LISTED_WRITES);
+		}
+
+		items.append(new QTreeWidgetItem({
+			hexValue(pc, 4),
+			row != rows.end() ? QString::fromStdString(disasmText(*row, symbols)) : QString(),
+			QString::number(t),
+			changes.join(' ')}));
+	}
+	treeTrace->clear();
+	treeTrace->addTopLevelItems(items);
+	for (int c = 0; c < 3; ++c) {
+		treeTrace->resizeColumnToContents(c);
+	}
+
+	QString summary = tr("%n instruction(s), %1 T-states, next PC %2", "", i)
+	                  .arg(cycles).arg(hexValue(core.regs.pc, 4));
+	if (core.halted) summary += tr(", halted");
+	if (!edtPatch->text().trimmed().isEmpty()) summary += tr(", patched");
+	lblSummary->setText(summary);
+}
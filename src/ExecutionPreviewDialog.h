@@ -0,0 +1,42 @@
+#ifndef EXECUTIONPREVIEWDIALOG_H
+#define EXECUTIONPREVIEWDIALOG_H
+
+#include "ui_ExecutionPreviewDialog.h"
+#include "SimpleHexRequest.h"
+#include "Z80Core.h"
+#include <QDialog>
+#include <vector>
+
+class SymbolTable;
+struct MemoryLayout;
+
+// Runs the code at the break on a local copy of the memory and lists
+// what every instruction changes, openMSX itself is not touched. A patch
+// can be written to the copy first, to see its effect before writing it
+// to openMSX.
+class ExecutionPreviewDialog : public QDialog, private Ui::ExecutionPreviewDialog,
+                               public SimpleHexRequestUser
+{
+	Q_OBJECT
+public:
+	ExecutionPreviewDialog(const Z80Core::Registers& regs, MemoryLayout& ml,
+	                       SymbolTable& symTable, QWidget* parent = nullptr);
+
+	void accept() override;
+	void reject() override;
+
+private:
+	void DataHexRequestReceived() override;
+	void DataHexRequestCanceled() override;
+
+	void run();
+	bool applyPatch(std::vector<uint8_t>& memory) const;
+
+	Z80Core::Registers startRegs;
+	MemoryLayout& memLayout;
+	SymbolTable& symTable;
+	std::vector<uint8_t> snapshot;
+	bool waitingForData = true;
+};
+
+#endif // EXECUTIONPREVIEWDIALOG_H
@@ -0,0 +1,132 @@
+#include "ExportDisasmDialog.h"
+#include "SymbolTable.h"
+#include "Convert.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QApplication>
+#include <fstream>
+
+
+ExportDisasmDialog::ExportDisasmDialog(const QMap<QString, int>& debuggables_,
+                                       SymbolTable& symTable_, QWidget* parent)
+	: QDialog(parent), debuggables(debuggables_), symTable(symTable_)
+{
+	setupUi(this);
+
+	cmbDebuggable->addItems(debuggables.keys());
+	cmbDebuggable->setCurrentIndex(cmbDebuggable->findText("memory"));
+
+	connect(btnBrowse, &QPushButton::clicked, this, &ExportDisasmDialog::browse);
+	connect(okButton, &QPushButton::clicked, this, &ExportDisasmDialog::accept);
+	connect(cancelButton, &QPushButton::clicked, this, &ExportDisasmDialog::reject);
+}
+
+void ExportDisasmDialog::browse()
+{
+	QString fileName = QFileDialog::getSaveFileName(
+		this, tr("Export disassembly"), edtFile->text(),
+		tr("Assembler source (*.asm);;All files (*)"));
+	if (!fileName.isEmpty()) {
+		edtFile->setText(fileName);
+	}
+}
+
+void ExportDisasmDialog::setBusy(bool busy)
+{
+	waiting = busy;
+	okButton->setEnabled(!busy);
+	cancelButton->setEnabled(!busy);
+	if (busy) {
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+	} else {
+		QApplication::restoreOverrideCursor();
+	}
+}
+
+void ExportDisasmDialog::accept()
+{
+	if (waiting) return;
+
+	if (!stringToValue<uint16_t>(edtFirstAddress->text()) ||
+	    !stringToValue<uint16_t>(edtAddress->text())) {
+		QMessageBox::warning(this, windowTitle(), tr("Invalid segment address."));
+		return;
+	}
+	if (edtFile->text().isEmpty()) {
+		browse();
+		if (edtFile->text().isEmpty()) return;
+	}
+	int size = debuggables.value(cmbDebuggable->currentText());
+	if (size <= 0) return;
+	if (!DisasmExporter::fits(segments(size))) {
+		QMessageBox::warning(this, windowTitle(),
+			tr("The segments don't fit below address #10000, "
+			   "choose smaller segments or a lower address."));
+		return;
+	}
+
+	image.assign(size, 0);
+	setBusy(true);
+	new SimpleHexRequest(cmbDebuggable->currentText(), 0, size, image.data(), *this);
+}
+
+void ExportDisasmDialog::reject()
+{
+	// the pending request still writes to this dialog
+	if (waiting) return;
+	QDialog::reject();
+}
+
+void ExportDisasmDialog::DataHexRequestReceived()
+{
+	setBusy(false);
+	if (exportImage()) {
+		QDialog::accept();
+	}
+}
+
+void ExportDisasmDialog::DataHexRequestCanceled()
+{
+	setBusy(false);
+	QMessageBox::warning(this, windowTitle(),
+		tr("Could not read debuggable '%1'.").arg(cmbDebuggable->currentText()));
+}
+
+std::vector<DisasmExporter::Segment> ExportDisasmDialog::segments(uint32_t imageSize) const
+{
+	static const uint32_t segmentSizes[] = {0, 0x4000, 0x2000};
+	return DisasmExporter::split(
+		imageSize, segmentSizes[cmbSegmentSize->currentIndex()],
+		*stringToValue<uint16_t>(edtFirstAddress->text()),
+		*stringToValue<uint16_t>(edtAddress->text()));
+}
+
+bool ExportDisasmDialog::exportImage()
+{
+	DisasmExporter exporter(image.data(), segments(uint32_t(image.size())),
+	                        symTable.addressIndex());
+
+	std::ofstream out(QFile::encodeName(edtFile->text()).constData());
+	if (!out) {
+		QMessageBox::warning(this, windowTitle(),
+			tr("Could not open file '%1'.").arg(edtFile->text()));
+		return false;
+	}
+	out << "; disassembly of " << cmbDebuggable->currentText().toStdString() << "\n\n";
+
+	QProgressDialog progress(tr("Disassembling..."), tr("Cancel"), 0, 0, this);
+	progress.setWindowModality(Qt::WindowModal);
+	progress.setMinimumDuration(500);
+	bool ok = exporter.write(out, [&](size_t done, size_t total) {
+		progress.setMaximum(int(total));
+		progress.setValue(int(done));
+		return !progress.wasCanceled();
+	});
+	if (!ok && !progress.wasCanceled()) {
+		QMessageBox::warning(this, windowTitle(),
+			tr("Error writing file '%1'.").arg(edtFile->text()));
+	}
+	return ok;
+}
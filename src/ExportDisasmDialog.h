@@ -0,0 +1,40 @@
+#ifndef EXPORTDISASMDIALOG_H
+#define EXPORTDISASMDIALOG_H
+
+#include "ui_ExportDisasmDialog.h"
+#include "DisasmExport.h"
+#include "SimpleHexRequest.h"
+#include <QDialog>
+#include <QMap>
+#include <vector>
+
+class SymbolTable;
+
+// Reads a complete debuggable and writes its disassembly to a source file.
+class ExportDisasmDialog : public QDialog, private Ui::ExportDisasmDialog,
+                           public SimpleHexRequestUser
+{
+	Q_OBJECT
+public:
+	ExportDisasmDialog(const QMap<QString, int>& debuggables, SymbolTable& symTable,
+	                   QWidget* parent = nullptr);
+
+	void accept() override;
+	void reject() override;
+
+private:
+	void browse();
+	void setBusy(bool busy);
+	[[nodiscard]] std::vector<DisasmExporter::Segment> segments(uint32_t imageSize) const;
+	bool exportImage();
+
+	void DataHexRequestReceived() override;
+	void DataHexRequestCanceled() override;
+
+	const QMap<QString, int>& debuggables;
+	SymbolTable& symTable;
+	std::vector<unsigned char> image;
+	bool waiting = false;
+};
+
+#endif // EXPORTDISASMDIALOG_H
@@ -1,7 +1,7 @@
 #include "GotoDialog.h"
 #include "DebugSession.h"
 #include "Convert.h"
-#include <QCompleter>
+#include "SymbolCompleter.h"
 
 
 GotoDialog::GotoDialog(const MemoryLayout& ml, DebugSession *session, QWidget* parent)
@@ -12,9 +12,9 @@ GotoDialog::GotoDialog(const MemoryLayout& ml, DebugSession *session, QWidget* p
 	debugSession = session;
 	if (session) {
 		// create address completer
-		auto* completer = new QCompleter(session->symbolTable().labelList(true, &ml), this);
-		completer->setCaseSensitivity(Qt::CaseInsensitive);
+		auto* completer = new SymbolCompleter(session->symbolTable(), true, &ml, this);
 		edtAddress->setCompleter(completer);
+		completer->watch(edtAddress);
 		connect(completer,  qOverload<const QString&>(&QCompleter::activated), this, &GotoDialog::addressChanged);
 	}
 
@@ -2,10 +2,13 @@
 #include "OpenMSXConnection.h"
 #include "CommClient.h"
 #include "Settings.h"
+#include "WriteLog.h"
+#include "Convert.h"
 #include <QScrollBar>
 #include <QPaintEvent>
 #include <QPainter>
 #include <QToolTip>
+#include <QStringList>
 #include <QAction>
 #include <algorithm>
 #include <cmath>
@@ -115,6 +118,11 @@ void HexViewer::setIsEditable(bool enabled)
 	setUseMarker(true);
 }
 
+void HexViewer::setWriteLog(const WriteLog* log)
+{
+	writeLog = log;
+}
+
 void HexViewer::setUseMarker(bool enabled)
 {
 	useMarker = enabled;
@@ -678,6 +686,26 @@ bool HexViewer::event(QEvent* e)
 				.arg((wd & 0x000F) >>  0, 4, 2, QChar('0'));
 			text += QString("\nDecimal: %1").arg(wd);
 		}
+
+		// the last recorded writers of this byte
+		if (writeLog && address <= 0xFFFF) {
+			auto writes = writeLog->writesTo(address, 4);
+			if (!writes.empty()) text += "\n\nLast writes:";
+			for (const auto& w : writes) {
+				text += QString("\n%1 by PC %2 at %3 s")
+					.arg(hexValue(w.value, 2)).arg(hexValue(w.pc, 4))
+					.arg(w.time, 0, 'f', 6);
+			}
+			if (!writes.empty()) {
+				// what else that instruction wrote
+				QStringList others;
+				for (const auto& w : writeLog->writesBy(writes.front().pc, 8)) {
+					others << hexValue(w.address, 4);
+				}
+				text += QString("\nPC %1 wrote to %2")
+					.arg(hexValue(writes.front().pc, 4)).arg(others.join(' '));
+			}
+		}
 		QToolTip::showText(helpEvent->globalPos(), text);
 	} else {
 		QToolTip::hideText();
@@ -8,6 +8,7 @@
 class HexRequest;
 class QScrollBar;
 class QPaintEvent;
+class WriteLog;
 
 class HexViewer : public QFrame
 {
@@ -21,6 +22,8 @@ public:
 	void setIsInteractive(bool enabled);
 	void setUseMarker(bool enabled);
 	void setIsEditable(bool enabled);
+	// the recorded writes are shown in the tooltips
+	void setWriteLog(const WriteLog* log);
 
 	void setDisplayMode(Mode mode);
 	void setDisplayWidth(short width);
@@ -79,6 +82,7 @@ private:
 	std::vector<uint8_t> hexData;
 	std::vector<uint8_t> previousHexData;
 	int debuggableSize = 0;
+	const WriteLog* writeLog = nullptr;
 	int hexTopAddress = 0;
 	int hexMarkAddress = 0;
 	bool waitingForData = false;
@@ -0,0 +1,303 @@
+#include "LoopAnalysis.h"
+#include <algorithm>
+#include <climits>
+
+using Kind = CallGraph::Kind;
+
+static uint64_t codeHash(const uint8_t* memory, const CallGraph& graph, const CallGraph::Routine& r)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&](uint8_t b) { hash = (hash ^ b) * 1099511628211ull; };
+	add(r.entry & 0xFF);
+	add(r.entry >> 8);
+	for (uint16_t addr : r.code) {
+		add(addr & 0xFF);
+		add(addr >> 8);
+		for (int i = 0; i < graph.step(addr).length; ++i) {
+			add(memory[addr + i]);
+		}
+	}
+	return hash;
+}
+
+void LoopAnalysis::analyze(const uint8_t* memory, const CallGraph& graph,
+                           const LoopAnalysis* previous)
+{
+	routines.assign(0x10000, nullptr);
+	headers.assign(0x10000, nullptr);
+	depthAt.assign(0x10000, 0);
+	latchAt.assign(0x10000, false);
+	loopCount = reused = analyzed = 0;
+	std::vector<int> indexAt(0x10000, -1);
+
+	for (const auto& r : graph.routines()) {
+		uint64_t hash = codeHash(memory, graph, r);
+		std::shared_ptr<const RoutineLoops> result;
+		if (previous && !previous->routines.empty()) {
+			const auto& old = previous->routines[r.entry];
+			if (old && old->hash == hash) {
+				result = old;
+				++reused;
+			}
+		}
+		if (!result) {
+			result = analyzeRoutine(graph, r, hash, indexAt);
+			++analyzed;
+		}
+		// code shared by several routines gets the deepest nesting
+		for (auto [addr, depth] : result->depths) {
+			depthAt[addr] = std::max(depthAt[addr], depth);
+		}
+		for (const auto& loop : result->loops) {
+			if (!headers[loop.header]) ++loopCount;
+			headers[loop.header] = &loop;
+			for (uint16_t latch : loop.latches) latchAt[latch] = true;
+		}
+		routines[r.entry] = std::move(result);
+	}
+}
+
+const LoopAnalysis::Loop* LoopAnalysis::loop(uint16_t header) const
+{
+	return headers.empty() ? nullptr : headers[header];
+}
+
+std::shared_ptr<const LoopAnalysis::RoutineLoops> LoopAnalysis::analyzeRoutine(
+	const CallGraph& graph, const CallGraph::Routine& r, uint64_t hash, std::vector<int>& indexAt)
+{
+	auto result = std::make_shared<RoutineLoops>();
+	result->hash = hash;
+
+	const auto& code = r.code;
+	int n = int(code.size());
+	for (int i = 0; i < n; ++i) indexAt[code[i]] = i;
+	auto indexOf = [&](uint16_t addr) { return indexAt[addr]; };
+	auto next = [&](int i) { return uint16_t(code[i] + graph.step(code[i]).length); };
+	auto fallsThrough = [&](int i) {
+		Kind k = graph.step(code[i]).kind;
+		return k == Kind::NEXT || k == Kind::CALL || k == Kind::LOAD_SP;
+	};
+
+	// basic blocks, they start at the entry, at jump targets and after
+	// anything that isn't a plain instruction or a call
+	std::vector<bool> leader(n, false);
+	for (int i = 0; i < n; ++i) {
+		const auto& s = graph.step(code[i]);
+		if (s.kind == Kind::JUMP || s.kind == Kind::BRANCH) {
+			if (int t = indexOf(s.target); t >= 0) leader[t] = true;
+		}
+		if (!fallsThrough(i)) {
+			if (int t = indexOf(next(i)); t >= 0) leader[t] = true;
+		}
+	}
+	struct Edge {
+		int to;
+		int cycles; // of the whole source block along this edge
+	};
+	struct Block {
+		int first, last; // instructions
+		int numSucc;
+		Edge succ[2];
+	};
+	std::vector<Block> blocks;
+	std::vector<int> blockOf(n);
+	for (int i = 0; i < n; ++i) {
+		if (i == 0 || leader[i] || !fallsThrough(i - 1) || next(i - 1) != code[i]) {
+			blocks.push_back({i, i, 0, {}});
+		}
+		blocks.back().last = i;
+		blockOf[i] = int(blocks.size()) - 1;
+	}
+	int numBlocks = int(blocks.size());
+	for (int b = 0; b < numBlocks; ++b) {
+		auto& block = blocks[b];
+		int base = 0;
+		for (int i = block.first; i < block.last; ++i) {
+			base += graph.step(code[i]).cyclesNotTaken;
+		}
+		const auto& s = graph.step(code[block.last]);
+		auto addEdge = [&](uint16_t to, int cycles) {
+			if (int t = indexOf(to); t >= 0) {
+				block.succ[block.numSucc++] = {blockOf[t], base + cycles};
+			}
+		};
+		switch (s.kind) {
+		case Kind::JUMP:
+			addEdge(s.target, s.cycles);
+			break;
+		case Kind::BRANCH:
+			addEdge(s.target, s.cycles);
+			addEdge(next(block.last), s.cyclesNotTaken);
+			break;
+		case Kind::RET:
+		case Kind::INDIRECT:
+			break;
+		default:
+			// block instructions are counted without repeating
+			addEdge(next(block.last), s.cyclesNotTaken);
+			break;
+		}
+	}
+	// predecessors, by block in 'preds' from predStart[b] to predStart[b + 1]
+	std::vector<int> predStart(numBlocks + 1, 0);
+	for (const auto& block : blocks) {
+		for (int e = 0; e < block.numSucc; ++e) ++predStart[block.succ[e].to + 1];
+	}
+	for (int b = 0; b < numBlocks; ++b) predStart[b + 1] += predStart[b];
+	std::vector<int> preds(predStart[numBlocks]);
+	{
+		std::vector<int> fill(predStart.begin(), predStart.end() - 1);
+		for (int b = 0; b < numBlocks; ++b) {
+			for (int e = 0; e < blocks[b].numSucc; ++e) preds[fill[blocks[b].succ[e].to]++] = b;
+		}
+	}
+
+	// reverse postorder from the entry
+	int entry = blockOf[indexOf(r.entry)];
+	std::vector<int> order;
+	std::vector<int> rpo(numBlocks, -1);
+	{
+		std::vector<bool> seen(numBlocks, false);
+		std::vector<std::pair<int, int>> stack = {{entry, 0}};
+		seen[entry] = true;
+		while (!stack.empty()) {
+			auto& [b, e] = stack.back();
+			if (e < blocks[b].numSucc) {
+				int s = blocks[b].succ[e++].to;
+				if (!seen[s]) {
+					seen[s] = true;
+					stack.push_back({s, 0});
+				}
+			} else {
+				order.push_back(b);
+				stack.pop_back();
+			}
+		}
+		std::reverse(order.begin(), order.end());
+		for (int i = 0; i < int(order.size()); ++i) rpo[order[i]] = i;
+	}
+
+	// dominators, Cooper, Harvey and Kennedy
+	std::vector<int> idom(numBlocks, -1);
+	idom[entry] = entry;
+	auto intersect = [&](int a, int b) {
+		while (a != b) {
+			while (rpo[a] > rpo[b]) a = idom[a];
+			while (rpo[b] > rpo[a]) b = idom[b];
+		}
+		return a;
+	};
+	for (bool changed = true; changed; ) {
+		changed = false;
+		for (int b : order) {
+			if (b == entry) continue;
+			int dom = -1;
+			for (int i = predStart[b]; i < predStart[b + 1]; ++i) {
+				int p = preds[i];
+				if (rpo[p] < 0 || idom[p] < 0) continue;
+				dom = dom < 0 ? p : intersect(p, dom);
+			}
+			if (dom >= 0 && idom[b] != dom) {
+				idom[b] = dom;
+				changed = true;
+			}
+		}
+	}
+	auto dominates = [&](int a, int b) {
+		while (true) {
+			if (a == b) return true;
+			if (b == entry) return false;
+			b = idom[b];
+		}
+	};
+
+	// natural loops, one per header
+	struct Body {
+		int header;
+		std::vector<int> latches;
+	};
+	std::vector<Body> bodies;
+	std::vector<int> bodyOf(numBlocks, -1);
+	for (int b : order) {
+		for (int j = 0; j < blocks[b].numSucc; ++j) {
+			const auto& e = blocks[b].succ[j];
+			if (rpo[e.to] > rpo[b] || !dominates(e.to, b)) continue;
+			if (bodyOf[e.to] < 0) {
+				bodyOf[e.to] = int(bodies.size());
+				bodies.push_back({e.to, {}});
+			}
+			bodies[bodyOf[e.to]].latches.push_back(b);
+		}
+	}
+
+	std::vector<int> mark(numBlocks, -1);
+	std::vector<int> blockDepth(numBlocks, 0);
+	std::vector<int> minDist(numBlocks), maxDist(numBlocks);
+	for (int i = 0; i < int(bodies.size()); ++i) {
+		const auto& body = bodies[i];
+		Loop loop;
+		loop.header = code[blocks[body.header].first];
+		loop.routine = r.entry;
+		loop.blocks = 0;
+		for (int l : body.latches) loop.latches.push_back(code[blocks[l].last]);
+
+		// the header dominates the body, so the body is in reverse
+		// postorder between the header and the last block found
+		int first = rpo[body.header];
+		int last = first;
+		mark[body.header] = i;
+		std::vector<int> work = body.latches;
+		while (!work.empty()) {
+			int w = work.back();
+			work.pop_back();
+			if (mark[w] == i) continue;
+			mark[w] = i;
+			last = std::max(last, rpo[w]);
+			for (int j = predStart[w]; j < predStart[w + 1]; ++j) {
+				if (rpo[preds[j]] >= 0) work.push_back(preds[j]);
+			}
+		}
+
+		// shortest and longest path through the body, without the
+		// retreating edges the body is acyclic in reverse postorder
+		for (int k = first; k <= last; ++k) {
+			minDist[order[k]] = INT_MAX;
+			maxDist[order[k]] = -1;
+		}
+		minDist[body.header] = maxDist[body.header] = 0;
+		loop.minCycles = INT_MAX;
+		loop.maxCycles = 0;
+		for (int k = first; k <= last; ++k) {
+			int b = order[k];
+			if (mark[b] != i) continue;
+			++loop.blocks;
+			++blockDepth[b];
+			if (maxDist[b] < 0) continue;
+			for (int j = 0; j < blocks[b].numSucc; ++j) {
+				const auto& e = blocks[b].succ[j];
+				if (e.to == body.header) {
+					loop.minCycles = std::min(loop.minCycles, minDist[b] + e.cycles);
+					loop.maxCycles = std::max(loop.maxCycles, maxDist[b] + e.cycles);
+				} else if (mark[e.to] == i && rpo[e.to] > k) {
+					minDist[e.to] = std::min(minDist[e.to], minDist[b] + e.cycles);
+					maxDist[e.to] = std::max(maxDist[e.to], maxDist[b] + e.cycles);
+				}
+			}
+		}
+		if (loop.minCycles == INT_MAX) loop.minCycles = loop.maxCycles;
+		result->loops.push_back(std::move(loop));
+	}
+	// a loop is nested in the loops that contain its header
+	for (int i = 0; i < int(bodies.size()); ++i) {
+		result->loops[i].depth = blockDepth[bodies[i].header];
+	}
+	for (int b = 0; b < numBlocks; ++b) {
+		if (!blockDepth[b]) continue;
+		for (int i = blocks[b].first; i <= blocks[b].last; ++i) {
+			result->depths.emplace_back(code[i], uint8_t(std::min(blockDepth[b], 255)));
+		}
+	}
+	for (uint16_t addr : code) indexAt[addr] = -1;
+	return result;
+}
@@ -0,0 +1,70 @@
+#ifndef LOOPANALYSIS_H
+#define LOOPANALYSIS_H
+
+#include "CallGraph.h"
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Loops in the routines of a call graph. Every routine is split in basic
+ * blocks, the dominators of the blocks give the back edges and a natural
+ * loop per loop header. The cost of a loop is the shortest and longest
+ * path from the header back to it, in T-states: conditional jumps count
+ * as taken or not taken along the path, inner loops and block instructions
+ * (ldir, ...) are counted once and calls without the called routine.
+ *
+ * The results are kept per routine. A new analysis takes the routines of
+ * which the code didn't change from the previous one, so changing a few
+ * bytes of memory only analyzes the affected routines again.
+ */
+class LoopAnalysis
+{
+public:
+	struct Loop {
+		uint16_t header;
+		uint16_t routine;  // entry of the routine
+		int depth;         // nesting level, 1 for an outermost loop
+		int minCycles;     // T-states of one iteration
+		int maxCycles;
+		int blocks;        // basic blocks in the body
+		std::vector<uint16_t> latches; // the jumps back to the header
+	};
+
+	// 'memory' is the one that 'graph' was built from
+	void analyze(const uint8_t* memory, const CallGraph& graph,
+	             const LoopAnalysis* previous = nullptr);
+
+	// the loop with the given header, or nullptr
+	[[nodiscard]] const Loop* loop(uint16_t header) const;
+	// number of loops around the instruction at 'addr'
+	[[nodiscard]] int depth(uint16_t addr) const { return depthAt.empty() ? 0 : depthAt[addr]; }
+	[[nodiscard]] bool isLatch(uint16_t addr) const { return !latchAt.empty() && latchAt[addr]; }
+
+	[[nodiscard]] int numLoops() const { return loopCount; }
+	// routines taken from the previous analysis, and analyzed again
+	[[nodiscard]] int reusedRoutines() const { return reused; }
+	[[nodiscard]] int analyzedRoutines() const { return analyzed; }
+
+private:
+	struct RoutineLoops {
+		uint64_t hash; // of the addresses and bytes of the code
+		std::vector<Loop> loops;
+		std::vector<std::pair<uint16_t, uint8_t>> depths; // instructions in loops
+	};
+	// 'indexAt' is scratch space for 64k entries, all -1
+	static std::shared_ptr<const RoutineLoops> analyzeRoutine(
+		const CallGraph& graph, const CallGraph::Routine& r, uint64_t hash,
+		std::vector<int>& indexAt);
+
+	// per address
+	std::vector<std::shared_ptr<const RoutineLoops>> routines; // at the entries
+	std::vector<const Loop*> headers;
+	std::vector<uint8_t> depthAt;
+	std::vector<bool> latchAt;
+	int loopCount = 0;
+	int reused = 0;
+	int analyzed = 0;
+};
+
+#endif // LOOPANALYSIS_H
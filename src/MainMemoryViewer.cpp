@@ -89,6 +89,11 @@ void MainMemoryViewer::setSymbolTable(SymbolTable* symtable)
 	symTable = symtable;
 }
 
+void MainMemoryViewer::setWriteLog(const WriteLog* log)
+{
+	hexView->setWriteLog(log);
+}
+
 void MainMemoryViewer::refresh()
 {
 	hexView->refresh();
@@ -6,6 +6,7 @@
 class HexViewer;
 class CPURegsViewer;
 class SymbolTable;
+class WriteLog;
 class QComboBox;
 class QLineEdit;
 
@@ -18,6 +19,7 @@ public:
 	void setDebuggable(const QString& name, int size);
 	void setRegsView(CPURegsViewer* viewer);
 	void setSymbolTable(SymbolTable* symtable);
+	void setWriteLog(const WriteLog* log);
 
 	void setLocation(int addr);
 	void settingsChanged();
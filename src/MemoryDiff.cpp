@@ -0,0 +1,57 @@
+#include "MemoryDiff.h"
+#include <algorithm>
+#include <cstring>
+
+void MemoryDiff::setReference(const uint8_t* image, uint8_t regions_)
+{
+	reference.assign(image, image + 0x10000);
+	diffBits.assign(0x10000 / 64, 0);
+	regions = regions_;
+}
+
+void MemoryDiff::clear()
+{
+	reference.clear();
+	diffBits.clear();
+	regions = 0;
+}
+
+void MemoryDiff::update(const uint8_t* memory, uint16_t start, unsigned size)
+{
+	if (!regions || !size) return;
+	int first = start / PAGE_SIZE;
+	int last = std::min(start + size - 1, 0xFFFFu) / PAGE_SIZE;
+	for (int page = first; page <= last; ++page) {
+		if (!(regions & (1 << (page * PAGE_SIZE / REGION_SIZE)))) continue;
+		comparePage(memory, page);
+	}
+}
+
+void MemoryDiff::comparePage(const uint8_t* memory, int page)
+{
+	const uint8_t* mem = memory + page * PAGE_SIZE;
+	const uint8_t* ref = &reference[page * PAGE_SIZE];
+	uint64_t* bits = &diffBits[page * PAGE_SIZE / 64];
+	// most pages are equal to the reference
+	if (std::memcmp(mem, ref, PAGE_SIZE) == 0) {
+		std::fill_n(bits, PAGE_SIZE / 64, 0);
+		return;
+	}
+	for (int word = 0; word < PAGE_SIZE / 64; ++word) {
+		uint64_t result = 0;
+		for (int i = 0; i < 64; i += 8) {
+			uint64_t a, b;
+			std::memcpy(&a, mem + 64 * word + i, 8);
+			std::memcpy(&b, ref + 64 * word + i, 8);
+			uint64_t x = a ^ b;
+			if (!x) continue;
+			// a bit per differing byte, in memory order
+			uint8_t bytes[8];
+			std::memcpy(bytes, &x, 8);
+			for (int j = 0; j < 8; ++j) {
+				if (bytes[j]) result |= uint64_t(1) << (i + j);
+			}
+		}
+		bits[word] = result;
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef MEMORYDIFF_H
+#define MEMORYDIFF_H
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Compares the memory with a reference image, e.g. a snapshot or the ROM
+ * that is mapped in, to show the bytes that were changed by the program.
+ *
+ * The memory is compared per page of 256 bytes, 8 bytes at a time.
+ */
+class MemoryDiff
+{
+public:
+	static constexpr int PAGE_SIZE = 0x100;
+	static constexpr int REGION_SIZE = 0x2000;
+
+	// 'image' is 64kB, only the 8kB regions with a bit set in 'regions'
+	// are compared
+	void setReference(const uint8_t* image, uint8_t regions = 0xFF);
+	void clear();
+	[[nodiscard]] bool isActive() const { return regions != 0; }
+
+	// compare the pages of 'memory' (64kB) that overlap the given range
+	void update(const uint8_t* memory, uint16_t start, unsigned size);
+
+	[[nodiscard]] bool differs(uint16_t addr) const
+	{
+		return !diffBits.empty() && (diffBits[addr / 64] >> (addr % 64)) & 1;
+	}
+
+private:
+	void comparePage(const uint8_t* memory, int page);
+
+	std::vector<uint8_t> reference;
+	std::vector<uint64_t> diffBits;  // per address
+	uint8_t regions = 0;
+};
+
+#endif // MEMORYDIFF_H
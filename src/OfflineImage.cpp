@@ -0,0 +1,124 @@
+#include "OfflineImage.h"
+#include "OpenMSXConnection.h"
+#include <algorithm>
+#include <vector>
+
+
+std::unique_ptr<OfflineImage> OfflineImage::open(const QString& filename)
+{
+	std::unique_ptr<OfflineImage> image(new OfflineImage(filename));
+	if (!image->file.open(QIODevice::ReadOnly)) return nullptr;
+	// the debuggables use int sizes
+	if (image->file.size() <= 0 || image->file.size() > 0x7FFFFFFF) return nullptr;
+	image->imageSize = unsigned(image->file.size());
+	image->mapped = image->file.map(0, image->imageSize);
+	if (!image->mapped) return nullptr;
+	image->setDefaultBlocks();
+	return image;
+}
+
+OfflineImage::OfflineImage(const QString& filename)
+	: file(filename)
+{
+	blocks.fill(UNMAPPED);
+}
+
+void OfflineImage::setDefaultBlocks()
+{
+	blocks.fill(UNMAPPED);
+	if (imageSize == 0x10000) {
+		// a memory dump
+		for (int r = 0; r < 8; ++r) blocks[r] = r;
+		return;
+	}
+	// ROMs start at #4000, except for 48kB ones that start at #0000;
+	// mappers show their first blocks
+	int first = imageSize == 0xC000 ? 0 : 2;
+	for (int b = 0; b < numBlocks() && first + b < 8 && b < 6; ++b) {
+		blocks[first + b] = b;
+	}
+}
+
+uint16_t OfflineImage::entryPoint() const
+{
+	uint8_t header[4];
+	for (unsigned addr : {0x4000u, 0x8000u, 0x0000u}) {
+		readMemory(addr, 4, header);
+		if (header[0] == 'A' && header[1] == 'B') {
+			uint16_t init = header[2] + 256 * header[3];
+			if (init) return init;
+		}
+	}
+	auto it = std::find_if(blocks.begin(), blocks.end(),
+	                       [](int b) { return b != UNMAPPED; });
+	return it == blocks.end() ? 0 : uint16_t((it - blocks.begin()) * BLOCK_SIZE);
+}
+
+void OfflineImage::readMemory(unsigned offset, unsigned size, uint8_t* target) const
+{
+	while (size) {
+		unsigned region = offset / BLOCK_SIZE;
+		unsigned inBlock = offset % BLOCK_SIZE;
+		unsigned n = std::min(size, BLOCK_SIZE - inBlock);
+		unsigned start = blocks[region] * BLOCK_SIZE + inBlock;
+		if (blocks[region] == UNMAPPED || start >= imageSize) {
+			std::fill_n(target, n, 0xFF);
+		} else {
+			unsigned available = std::min(n, imageSize - start);
+			std::copy_n(mapped + start, available, target);
+			std::fill_n(target + available, n - available, 0xFF);
+		}
+		target += n;
+		offset += n;
+		size -= n;
+	}
+}
+
+QString OfflineImage::memMapperReply() const
+{
+	// same format as the 'debug_memmapper' proc, see DebuggerForm
+	QString result;
+	for (int page = 0; page < 4; ++page) {
+		result += QString("%1X\n0\n").arg(primarySlot);
+	}
+	for (int ps = 0; ps < 4; ++ps) {
+		result += "0\n0\n";
+	}
+	for (int b : blocks) {
+		result += b == UNMAPPED ? QString("X\n") : QString("%1\n").arg(b);
+	}
+	return result;
+}
+
+bool OfflineImage::execute(CommandBase& command) const
+{
+	if (auto* read = dynamic_cast<ReadDebugBlockCommand*>(&command)) {
+		const QString& name = read->debuggable();
+		unsigned offset = read->blockOffset();
+		unsigned size = read->blockSize();
+		if (name == "memory") {
+			if (offset + size > 0x10000) return false;
+			std::vector<uint8_t> buffer(size);
+			readMemory(offset, size, buffer.data());
+			read->replyData(buffer.data());
+		} else if (name == DEBUGGABLE) {
+			if (offset + size > imageSize) return false;
+			read->replyData(mapped + offset);
+		} else if (name == "{CPU regs}") {
+			if (offset + size > 28) return false;
+			uint8_t regs[28] = {};
+			uint16_t pc = entryPoint();
+			regs[20] = pc >> 8;
+			regs[21] = pc & 255;
+			read->replyData(regs + offset);
+		} else {
+			return false;
+		}
+		return true;
+	}
+	if (command.getCommand() == "debug_memmapper") {
+		command.replyOk(memMapperReply());
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,66 @@
+#ifndef OFFLINEIMAGE_H
+#define OFFLINEIMAGE_H
+
+#include <QFile>
+#include <QString>
+#include <array>
+#include <memory>
+#include <stdint.h>
+
+class CommandBase;
+
+/**
+ * A ROM image or memory dump that is examined without openMSX. The file is
+ * memory mapped, so only the parts that are looked at are read from disk.
+ * It answers the memory, debuggable and slot queries of the viewers as if
+ * the image was plugged in a slot, with its 8kB blocks visible in the Z80
+ * address space as chosen by the user.
+ */
+class OfflineImage
+{
+public:
+	static constexpr unsigned BLOCK_SIZE = 0x2000;
+	static constexpr int UNMAPPED = -1;
+	// name of the debuggable with the complete file
+	static constexpr const char* DEBUGGABLE = "image";
+
+	// nullptr if the file can't be opened or mapped
+	static std::unique_ptr<OfflineImage> open(const QString& filename);
+
+	[[nodiscard]] QString fileName() const { return file.fileName(); }
+	[[nodiscard]] const uint8_t* data() const { return mapped; }
+	[[nodiscard]] unsigned size() const { return imageSize; }
+	[[nodiscard]] int numBlocks() const { return (imageSize + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+
+	// primary slot the image is shown in
+	void setSlot(int ps) { primarySlot = ps; }
+	[[nodiscard]] int slot() const { return primarySlot; }
+	// image block visible in the 8kB region 'region', or UNMAPPED
+	void setBlock(int region, int block) { blocks[region] = block; }
+	[[nodiscard]] int block(int region) const { return blocks[region]; }
+	// the layout openMSX would use for a file of this size
+	void setDefaultBlocks();
+
+	// ROM init address when there is a ROM header, else the first mapped address
+	[[nodiscard]] uint16_t entryPoint() const;
+
+	// Answers a command like openMSX would. Returns false for commands
+	// that need a running machine.
+	bool execute(CommandBase& command) const;
+
+	// the Z80 address space as mapped, #FF where nothing is mapped
+	void readMemory(unsigned offset, unsigned size, uint8_t* target) const;
+
+private:
+	explicit OfflineImage(const QString& filename);
+
+	[[nodiscard]] QString memMapperReply() const;
+
+	QFile file;
+	uint8_t* mapped = nullptr;
+	unsigned imageSize = 0;
+	int primarySlot = 1;
+	std::array<int, 8> blocks;
+};
+
+#endif // OFFLINEIMAGE_H
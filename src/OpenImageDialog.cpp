@@ -0,0 +1,53 @@
+#include "OpenImageDialog.h"
+#include "Settings.h"
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+
+
+OpenImageDialog::OpenImageDialog(QWidget* parent)
+	: QDialog(parent)
+{
+	setupUi(this);
+
+	blockSpins = {spnBlock0, spnBlock1, spnBlock2, spnBlock3,
+	              spnBlock4, spnBlock5, spnBlock6, spnBlock7};
+	grpMapping->setEnabled(false);
+	okButton->setEnabled(false);
+
+	connect(btnBrowse, &QPushButton::clicked, this, &OpenImageDialog::browse);
+}
+
+void OpenImageDialog::browse()
+{
+	QString fileName = QFileDialog::getOpenFileName(
+		this, tr("Open ROM or memory image"),
+		Settings::get().value("OfflineImage/Directory").toString(),
+		tr("ROM and memory images (*.rom *.ri *.bin *.mem);;All files (*)"));
+	if (fileName.isEmpty()) return;
+	Settings::get().setValue("OfflineImage/Directory", QFileInfo(fileName).absolutePath());
+
+	image = OfflineImage::open(fileName);
+	if (!image) {
+		QMessageBox::warning(this, windowTitle(),
+			tr("Could not open file '%1'.").arg(fileName));
+	} else {
+		edtFile->setText(fileName);
+		for (int r = 0; r < 8; ++r) {
+			blockSpins[r]->setMaximum(image->numBlocks() - 1);
+			blockSpins[r]->setValue(image->block(r));
+		}
+	}
+	grpMapping->setEnabled(image != nullptr);
+	okButton->setEnabled(image != nullptr);
+}
+
+void OpenImageDialog::accept()
+{
+	if (!image) return;
+	image->setSlot(spnSlot->value());
+	for (int r = 0; r < 8; ++r) {
+		image->setBlock(r, blockSpins[r]->value());
+	}
+	QDialog::accept();
+}
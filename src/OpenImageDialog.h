@@ -0,0 +1,30 @@
+#ifndef OPENIMAGEDIALOG_H
+#define OPENIMAGEDIALOG_H
+
+#include "ui_OpenImageDialog.h"
+#include "OfflineImage.h"
+#include <QDialog>
+#include <array>
+#include <memory>
+
+class QSpinBox;
+
+// Selects a ROM image or memory dump and where it is visible to the Z80.
+class OpenImageDialog : public QDialog, private Ui::OpenImageDialog
+{
+	Q_OBJECT
+public:
+	OpenImageDialog(QWidget* parent = nullptr);
+
+	void accept() override;
+	// the opened image with the chosen mapping
+	std::unique_ptr<OfflineImage> takeImage() { return std::move(image); }
+
+private:
+	void browse();
+
+	std::unique_ptr<OfflineImage> image;
+	std::array<QSpinBox*, 8> blockSpins;
+};
+
+#endif // OPENIMAGEDIALOG_H
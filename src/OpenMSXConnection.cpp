@@ -1,6 +1,7 @@
 #include "OpenMSXConnection.h"
 #include <QXmlStreamReader>
 #include <cassert>
+#include <cstring>
 
 
 void SimpleCommand::replyOk (const QString& /*message*/)
@@ -66,12 +67,20 @@ ReadDebugBlockCommand::ReadDebugBlockCommand(const QString& commandString,
 }
 
 ReadDebugBlockCommand::ReadDebugBlockCommand(const QString& debuggable,
-		unsigned offset, unsigned size_, unsigned char* target_)
-	: SimpleCommand(createDebugCommand(debuggable, offset, size_))
+		unsigned offset_, unsigned size_, unsigned char* target_)
+	: SimpleCommand(createDebugCommand(debuggable, offset_, size_))
+	, debuggableName(debuggable), startOffset(offset_)
 	, size(size_), target(target_)
 {
 }
 
+void ReadDebugBlockCommand::replyData(const unsigned char* data)
+{
+	memcpy(target, data, size);
+	dataCopied = true;
+	replyOk(QString());
+}
+
 static QString createDebugWriteCommand(const QString& debuggable,
 		unsigned offset, unsigned size, unsigned char *data)
 {
@@ -96,6 +105,7 @@ static unsigned char hex2val(char c)
 }
 void ReadDebugBlockCommand::copyData(const QString& message)
 {
+	if (dataCopied) return;
 	assert(static_cast<unsigned>(message.size()) == 2 * size);
 	for (unsigned i = 0; i < size; ++i) {
 		target[i] = (hex2val(message[2 * i + 0].toLatin1()) << 4) +
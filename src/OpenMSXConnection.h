@@ -62,12 +62,21 @@ public:
 	ReadDebugBlockCommand(const QString& debuggable, unsigned offset, unsigned size,
 	                      unsigned char* target);
 
+	const QString& debuggable() const { return debuggableName; }
+	unsigned blockOffset() const { return startOffset; }
+	unsigned blockSize() const { return size; }
+	// answer with data that doesn't come from openMSX, see OfflineImage
+	void replyData(const unsigned char* data);
+
 protected:
 	void copyData(const QString& message);
 
 private:
+	QString debuggableName; // empty for a raw command string
+	unsigned startOffset = 0;
 	unsigned size;
 	unsigned char* target;
+	bool dataCopied = false;
 };
 
 class WriteDebugBlockCommand : public SimpleCommand
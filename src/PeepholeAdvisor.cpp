@@ -0,0 +1,346 @@
+#include "PeepholeAdvisor.h"
+#include "CallGraph.h"
+#include "LoopAnalysis.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// The rules, tried in this order. A pattern is a list of:
+//   xx   the byte xx (hex)
+//   n    any byte, the first one is n1 in the replacement, then n2, ...
+//   xx+  the byte xx one or more times
+// and a replacement a list of:
+//   xx   the byte xx (hex)
+//   n1.. a byte of the pattern
+//   #    the repeat count as a word, -# the negated repeat count
+//   r    a relative jump to the address n1 n2, the rule doesn't apply when
+//        that's out of range
+// and the registers it clobbers, which must not be used after the sequence
+static const std::vector<PeepholeAdvisor::Rule> ruleTable = {
+	{"ld a,0 -> xor a",            "3E 00",     "AF",       "changes the flags", PeepholeAdvisor::FLAGS},
+	{"cp 0 -> or a",               "FE 00",     "B7",       "P/V, H and N differ"},
+	{"or 0 -> or a",               "F6 00",     "B7",       ""},
+	{"sla a -> add a,a",           "CB 27",     "87",       "P/V and H differ"},
+	{"jp nz -> jr nz",             "C2 n n",    "20 r",     ""},
+	{"jp z -> jr z",               "CA n n",    "28 r",     ""},
+	{"jp nc -> jr nc",             "D2 n n",    "30 r",     ""},
+	{"jp c -> jr c",               "DA n n",    "38 r",     ""},
+	{"call, ret -> jp",            "CD n n C9", "C3 n1 n2", "the called routine returns to the caller"},
+	{"ld b,ld c -> ld bc",         "06 n 0E n", "01 n2 n1", ""},
+	{"ld c,ld b -> ld bc",         "0E n 06 n", "01 n1 n2", ""},
+	{"ld d,ld e -> ld de",         "16 n 1E n", "11 n2 n1", ""},
+	{"ld e,ld d -> ld de",         "1E n 16 n", "11 n1 n2", ""},
+	{"ld h,ld l -> ld hl",         "26 n 2E n", "21 n2 n1", ""},
+	{"ld l,ld h -> ld hl",         "2E n 26 n", "21 n1 n2", ""},
+	{"inc hl (repeated) -> add hl,de", "23+",   "11 # 19",  "uses DE, changes the flags",
+	 PeepholeAdvisor::FLAGS | PeepholeAdvisor::DE},
+	{"dec hl (repeated) -> add hl,de", "2B+",   "11 -# 19", "uses DE, changes the flags",
+	 PeepholeAdvisor::FLAGS | PeepholeAdvisor::DE},
+};
+
+const std::vector<PeepholeAdvisor::Rule>& PeepholeAdvisor::rules()
+{
+	return ruleTable;
+}
+
+namespace {
+
+struct Token {
+	enum Type : uint8_t { BYTE, ANY, REPEAT, CAPTURE, COUNT, NEG_COUNT, RELATIVE };
+	Type type;
+	uint8_t value;
+};
+
+struct CompiledRule {
+	std::vector<Token> pattern;
+	std::vector<Token> replacement;
+};
+
+std::vector<Token> compile(const char* text, bool replacement)
+{
+	std::vector<Token> result;
+	const char* p = text;
+	while (*p) {
+		if (*p == ' ') {
+			++p;
+			continue;
+		}
+		const char* end = p + std::strcspn(p, " ");
+		std::string word(p, end);
+		p = end;
+		if (!replacement && word == "n") {
+			result.push_back({Token::ANY, 0});
+		} else if (replacement && word.size() == 2 && word[0] == 'n') {
+			result.push_back({Token::CAPTURE, uint8_t(word[1] - '1')});
+		} else if (replacement && word == "#") {
+			result.push_back({Token::COUNT, 0});
+		} else if (replacement && word == "-#") {
+			result.push_back({Token::NEG_COUNT, 0});
+		} else if (replacement && word == "r") {
+			result.push_back({Token::RELATIVE, 0});
+		} else {
+			bool repeat = !replacement && word.back() == '+';
+			if (repeat) word.pop_back();
+			assert(word.size() == 2);
+			auto value = uint8_t(std::strtol(word.c_str(), nullptr, 16));
+			result.push_back({repeat ? Token::REPEAT : Token::BYTE, value});
+		}
+	}
+	return result;
+}
+
+// the rules per first byte of their pattern
+struct RuleIndex {
+	std::vector<CompiledRule> compiled;
+	std::array<std::vector<int>, 256> byFirstByte;
+
+	RuleIndex()
+	{
+		for (const auto& rule : ruleTable) {
+			CompiledRule c = {compile(rule.pattern, false), compile(rule.replacement, true)};
+			assert(!c.pattern.empty() && c.pattern[0].type != Token::ANY);
+			byFirstByte[c.pattern[0].value].push_back(int(compiled.size()));
+			compiled.push_back(std::move(c));
+		}
+	}
+};
+
+// what an instruction does with the flags and DE, as Register bits
+struct RegisterUse {
+	uint8_t reads = 0;  // the value from before is used
+	uint8_t writes = 0; // the value is replaced completely
+};
+
+RegisterUse registerUse(const DisasmRow& row)
+{
+	using R = PeepholeAdvisor::Register;
+	const uint8_t ALL = R::FLAGS | R::DE;
+	uint8_t op = row.opcode;
+	// the register operand of the 8-bit loads and arithmetic
+	bool d_e = (op & 7) == 2 || (op & 7) == 3;
+	RegisterUse use;
+	switch (row.table) {
+	case DisasmRow::MAIN:
+	case DisasmRow::XX:
+		if (row.table == DisasmRow::XX && (op == 0xDD || op == 0xED || op == 0xFD)) {
+			use.reads = ALL;
+			break;
+		}
+		// adc, sbc, rla, rra, daa, ccf, ex af,af', push af and the conditions
+		if ((op >= 0x88 && op < 0xA0) || op == 0xCE || op == 0xDE || op == 0x17 ||
+		    op == 0x1F || op == 0x27 || op == 0x3F || op == 0x08 || op == 0xF5 ||
+		    (op >= 0x20 && op < 0x40 && (op & 7) == 0) ||
+		    (op >= 0xC0 && ((op & 7) == 0 || (op & 7) == 2 || (op & 7) == 4))) {
+			use.reads |= R::FLAGS;
+		}
+		// the 8-bit arithmetic and pop af set all flags
+		if ((op >= 0x80 && op < 0xC0) || (op & 0xC7) == 0xC6 || op == 0xF1) {
+			use.writes |= R::FLAGS;
+		}
+		if (op == 0x12 || op == 0x13 || op == 0x14 || op == 0x15 || op == 0x19 ||
+		    op == 0x1A || op == 0x1B || op == 0x1C || op == 0x1D || op == 0xD5 ||
+		    op == 0xEB || op == 0xD9 || (op >= 0x40 && op < 0xC0 && op != 0x76 && d_e)) {
+			use.reads |= R::DE;
+		}
+		if (op == 0x11 || op == 0xD1) use.writes |= R::DE;
+		break;
+	case DisasmRow::CB:
+	case DisasmRow::XX_CB:
+		// rotates and shifts set all flags, rl and rr use the carry
+		if (op < 0x40) {
+			if (op >= 0x10 && op < 0x20) use.reads |= R::FLAGS;
+			use.writes |= R::FLAGS;
+		}
+		if (row.table == DisasmRow::CB && d_e) use.reads |= R::DE;
+		break;
+	case DisasmRow::ED:
+		if ((op & 0xC7) == 0x42 || (op & 0xC7) == 0x4A) use.reads |= R::FLAGS; // adc/sbc hl
+		if ((op & 0xC7) == 0x44) use.writes |= R::FLAGS;                       // neg
+		// out (c),d  out (c),e  sbc hl,de  adc hl,de  ld (nn),de  ldi  ldd  ldir  lddr
+		if (op == 0x51 || op == 0x59 || op == 0x52 || op == 0x5A || op == 0x53 ||
+		    op == 0xA0 || op == 0xA8 || op == 0xB0 || op == 0xB8) {
+			use.reads |= R::DE;
+		}
+		if (op == 0x5B) use.writes |= R::DE;
+		break;
+	default:
+		use.reads = ALL;
+		break;
+	}
+	return use;
+}
+
+// Whether any of 'regs' can be read after the code at 'addr', before it is
+// overwritten. All paths are followed within the known code. A call, a
+// return or an unknown jump may use anything, and so may a path that is
+// followed too far.
+bool isLive(const uint8_t* memory, const CallGraph& graph, uint16_t addr, uint8_t regs)
+{
+	static const int MAX_STEPS = 256;
+	std::vector<std::pair<uint16_t, uint8_t>> work = {{addr, regs}};
+	std::vector<std::pair<uint16_t, uint8_t>> seen;
+	while (!work.empty()) {
+		auto [a, live] = work.back();
+		work.pop_back();
+		if (std::find(seen.begin(), seen.end(), std::make_pair(a, live)) != seen.end()) continue;
+		if (seen.size() == MAX_STEPS || !graph.isCode(a)) return true;
+		seen.emplace_back(a, live);
+
+		auto use = registerUse(dasmInstruction(memory, a));
+		if (use.reads & live) return true;
+		live &= ~use.writes;
+		if (!live) continue;
+
+		const auto& s = graph.step(a);
+		switch (s.kind) {
+		case CallGraph::Kind::NEXT:
+		case CallGraph::Kind::LOAD_SP:
+			work.emplace_back(uint16_t(a + s.length), live);
+			break;
+		case CallGraph::Kind::JUMP:
+			work.emplace_back(s.target, live);
+			break;
+		case CallGraph::Kind::BRANCH:
+			work.emplace_back(s.target, live);
+			work.emplace_back(uint16_t(a + s.length), live);
+			break;
+		default:
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+void PeepholeAdvisor::analyze(const uint8_t* memory, const CallGraph& graph, const LoopAnalysis* loops)
+{
+	static const RuleIndex index;
+	results.clear();
+
+	// instructions that are jumped to can't be merged with the one before
+	std::vector<bool> target(0x10000, false);
+	for (const auto& r : graph.routines()) {
+		target[r.entry] = true;
+		for (uint16_t addr : r.code) {
+			const auto& s = graph.step(addr);
+			if (s.kind == CallGraph::Kind::JUMP || s.kind == CallGraph::Kind::BRANCH) {
+				target[s.target] = true;
+			}
+		}
+	}
+
+	// the replacement is decoded in place, in a copy of the memory
+	std::vector<uint8_t> scratch(memory, memory + 0x10000 + 3);
+
+	for (int addr = 0; addr < 0x10000; ) {
+		if (!graph.isCode(addr)) {
+			++addr;
+			continue;
+		}
+		int matchEnd = 0;
+		for (int ruleIdx : index.byFirstByte[memory[addr]]) {
+			const auto& rule = index.compiled[ruleIdx];
+
+			// match the bytes
+			uint8_t captures[9];
+			int numCaptures = 0;
+			int count = 0;
+			int pos = addr;
+			bool match = true;
+			for (const auto& t : rule.pattern) {
+				if (pos >= 0x10000) {
+					match = false;
+				} else if (t.type == Token::BYTE) {
+					match = memory[pos++] == t.value;
+				} else if (t.type == Token::ANY) {
+					captures[numCaptures++] = memory[pos++];
+				} else {
+					while (pos < 0x10000 && memory[pos] == t.value && count < 0x100) {
+						++pos;
+						++count;
+					}
+					match = count > 0;
+				}
+				if (!match) break;
+			}
+			if (!match) continue;
+
+			// the bytes must be whole instructions, only the first one
+			// can be jumped to
+			int cycles = 0, cyclesNotTaken = 0;
+			bool latch = false;
+			std::vector<DisasmRow> original;
+			int a = addr;
+			while (a < pos) {
+				if (!graph.isCode(a) || (a != addr && target[a])) break;
+				const auto& s = graph.step(a);
+				cycles += s.cycles;
+				cyclesNotTaken += s.cyclesNotTaken;
+				latch |= loops && loops->isLatch(a);
+				original.push_back(dasmInstruction(memory, a));
+				a += s.length;
+			}
+			if (a != pos) continue;
+
+			// build the replacement
+			std::vector<uint8_t> bytes;
+			for (const auto& t : rule.replacement) {
+				switch (t.type) {
+				case Token::CAPTURE:
+					bytes.push_back(captures[t.value]);
+					break;
+				case Token::COUNT:
+				case Token::NEG_COUNT: {
+					uint16_t word = t.type == Token::COUNT ? count : -count;
+					bytes.push_back(word & 0xFF);
+					bytes.push_back(word >> 8);
+					break;
+				}
+				case Token::RELATIVE: {
+					int dest = captures[0] + 256 * captures[1];
+					int offset = dest - (addr + int(bytes.size()) + 1);
+					if (offset < -128 || offset > 127) match = false;
+					bytes.push_back(uint8_t(offset));
+					break;
+				}
+				default:
+					bytes.push_back(t.value);
+					break;
+				}
+			}
+			if (!match || addr + bytes.size() > 0x10000) continue;
+
+			std::copy(bytes.begin(), bytes.end(), &scratch[addr]);
+			int newCycles = 0, newCyclesNotTaken = 0;
+			std::vector<DisasmRow> replacement;
+			for (int b = addr; b < addr + int(bytes.size()); ) {
+				replacement.push_back(dasmInstruction(scratch.data(), b));
+				newCycles += replacement.back().cycles;
+				newCyclesNotTaken += replacement.back().cyclesNotTaken;
+				b += replacement.back().numBytes;
+			}
+			std::copy(&memory[addr], &memory[addr] + bytes.size(), &scratch[addr]);
+
+			// a branch that closes a loop is usually taken
+			int savedTaken = cycles - newCycles;
+			int savedNotTaken = cyclesNotTaken - newCyclesNotTaken;
+			int savedCycles = latch ? savedTaken : savedNotTaken;
+			int savedOther = latch ? savedNotTaken : savedTaken;
+			int savedBytes = pos - addr - int(bytes.size());
+			if (savedBytes < 0 || savedCycles < 0 || (savedBytes == 0 && savedCycles == 0)) {
+				continue;
+			}
+			uint8_t clobbers = ruleTable[ruleIdx].clobbers;
+			if (clobbers && isLive(memory, graph, uint16_t(pos), clobbers)) continue;
+			results.push_back({uint16_t(addr), ruleIdx, savedBytes, savedCycles, savedOther,
+			                   std::move(original), std::move(replacement)});
+			matchEnd = pos;
+			break;
+		}
+		addr = matchEnd ? matchEnd : addr + graph.step(addr).length;
+	}
+}
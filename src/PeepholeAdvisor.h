@@ -0,0 +1,56 @@
+#ifndef PEEPHOLEADVISOR_H
+#define PEEPHOLEADVISOR_H
+
+#include "Dasm.h"
+#include <vector>
+#include <stdint.h>
+
+class CallGraph;
+class LoopAnalysis;
+
+/**
+ * Finds instruction sequences in the analyzed code that have a cheaper
+ * equivalent. The sequences are described by the rules in the table in
+ * PeepholeAdvisor.cpp, see there for the notation.
+ *
+ * A sequence is only replaced when none of its instructions but the first
+ * is jumped to, and only reported when the replacement is not larger and
+ * not slower on the common path. A conditional jump is assumed not to be
+ * taken, unless it closes a loop. A replacement that clobbers the flags or
+ * DE is only reported when all paths from the sequence overwrite them
+ * before they are read.
+ */
+class PeepholeAdvisor
+{
+public:
+	enum Register : uint8_t { FLAGS = 1, DE = 2 };
+	struct Rule {
+		const char* name;
+		const char* pattern;
+		const char* replacement;
+		const char* note;        // side effects of the replacement, or ""
+		uint8_t clobbers = 0;    // Register bits the original keeps
+	};
+	struct Finding {
+		uint16_t addr;
+		int rule;                // index in rules()
+		int savedBytes;
+		int savedCycles;         // T-states on the common path
+		int savedCyclesOther;    // on the other path, when there are branches
+		std::vector<DisasmRow> original;
+		std::vector<DisasmRow> replacement;
+	};
+
+	[[nodiscard]] static const std::vector<Rule>& rules();
+
+	// 'memory' is the one that 'graph' was built from, 'loops' is optional
+	void analyze(const uint8_t* memory, const CallGraph& graph, const LoopAnalysis* loops);
+
+	// in address order
+	[[nodiscard]] const std::vector<Finding>& findings() const { return results; }
+
+private:
+	std::vector<Finding> results;
+};
+
+#endif // PEEPHOLEADVISOR_H
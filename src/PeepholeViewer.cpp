@@ -0,0 +1,107 @@
+#include "PeepholeViewer.h"
+#include "SymbolTable.h"
+#include "Convert.h"
+#include <QComboBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+PeepholeViewer::PeepholeViewer(QWidget* parent)
+	: QWidget(parent)
+{
+	ruleList = new QComboBox();
+	ruleList->addItem(tr("All rules"), -1);
+	const auto& rules = PeepholeAdvisor::rules();
+	for (int i = 0; i < int(rules.size()); ++i) {
+		ruleList->addItem(rules[i].name, i);
+	}
+
+	findingList = new QTreeWidget();
+	findingList->setColumnCount(6);
+	findingList->setHeaderLabels({tr("Address"), tr("Code"), tr("Replacement"),
+	                              tr("Bytes"), tr("T-states"), tr("Note")});
+	findingList->setRootIsDecorated(false);
+	findingList->setUniformRowHeights(true);
+	findingList->setSortingEnabled(true);
+	findingList->sortByColumn(0, Qt::AscendingOrder);
+	findingList->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+	statusLabel = new QLabel();
+
+	auto* vbox = new QVBoxLayout();
+	vbox->setMargin(0);
+	vbox->addWidget(ruleList);
+	vbox->addWidget(findingList);
+	vbox->addWidget(statusLabel);
+	setLayout(vbox);
+
+	connect(ruleList, qOverload<int>(&QComboBox::currentIndexChanged),
+	        this, &PeepholeViewer::fillList);
+	connect(findingList, &QTreeWidget::itemActivated, this, &PeepholeViewer::findingActivated);
+	fillList();
+}
+
+void PeepholeViewer::setSymbolTable(SymbolTable* st)
+{
+	symTable = st;
+}
+
+void PeepholeViewer::setMemoryLayout(MemoryLayout* ml)
+{
+	memLayout = ml;
+}
+
+void PeepholeViewer::setAdvice(std::shared_ptr<const PeepholeAdvisor> advice_)
+{
+	advice = std::move(advice_);
+	fillList();
+}
+
+void PeepholeViewer::fillList()
+{
+	findingList->clear();
+	if (!advice || !symTable) {
+		statusLabel->setText(tr("Waiting for the code analysis"));
+		return;
+	}
+
+	const auto& symbols = symTable->addressIndex(memLayout);
+	auto text = [&](const std::vector<DisasmRow>& rows) {
+		QStringList instructions;
+		for (DisasmRow row : rows) {
+			if (row.hasAddressOperand()) row.symbol = symbols.find(row.operand);
+			instructions << QString::fromStdString(disasmText(row, symbols)).simplified();
+		}
+		return instructions.join(" / ");
+	};
+
+	int rule = ruleList->currentData().toInt();
+	int bytes = 0, cycles = 0;
+	QList<QTreeWidgetItem*> items;
+	findingList->setSortingEnabled(false);
+	for (const auto& f : advice->findings()) {
+		if (rule >= 0 && f.rule != rule) continue;
+		auto* item = new QTreeWidgetItem({hexValue(f.addr, 4), text(f.original), text(f.replacement),
+		                                  QString(), QString(), PeepholeAdvisor::rules()[f.rule].note});
+		item->setData(0, Qt::UserRole, f.addr);
+		// numbers, to sort on them
+		item->setData(3, Qt::DisplayRole, f.savedBytes);
+		item->setData(4, Qt::DisplayRole, f.savedCycles);
+		if (f.savedCyclesOther != f.savedCycles) {
+			item->setToolTip(4, tr("%1 when the branch goes the other way").arg(f.savedCyclesOther));
+		}
+		items.append(item);
+		bytes += f.savedBytes;
+		cycles += f.savedCycles;
+	}
+	findingList->addTopLevelItems(items);
+	findingList->setSortingEnabled(true);
+	statusLabel->setText(tr("%n finding(s), saving %1 bytes and %2 T-states", "", items.size())
+	                     .arg(bytes).arg(cycles));
+}
+
+void PeepholeViewer::findingActivated(QTreeWidgetItem* item)
+{
+	emit addressSelected(item->data(0, Qt::UserRole).toUInt());
+}
@@ -0,0 +1,42 @@
+#ifndef PEEPHOLEVIEWER_H
+#define PEEPHOLEVIEWER_H
+
+#include "PeepholeAdvisor.h"
+#include <QWidget>
+#include <memory>
+
+class QComboBox;
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+class SymbolTable;
+struct MemoryLayout;
+
+// Lists the cheaper instruction sequences found by the code analysis.
+class PeepholeViewer : public QWidget
+{
+	Q_OBJECT
+public:
+	PeepholeViewer(QWidget* parent = nullptr);
+
+	void setSymbolTable(SymbolTable* st);
+	void setMemoryLayout(MemoryLayout* ml);
+	void setAdvice(std::shared_ptr<const PeepholeAdvisor> advice);
+
+signals:
+	void addressSelected(uint16_t addr);
+
+private:
+	void fillList();
+	void findingActivated(QTreeWidgetItem* item);
+
+	QComboBox* ruleList;
+	QTreeWidget* findingList;
+	QLabel* statusLabel;
+
+	SymbolTable* symTable = nullptr;
+	MemoryLayout* memLayout = nullptr;
+	std::shared_ptr<const PeepholeAdvisor> advice;
+};
+
+#endif // PEEPHOLEVIEWER_H
@@ -0,0 +1,122 @@
+#include "SourceLineIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// data lines are only used for the addresses this close after them
+static const int MAX_DATA_SIZE = 0x100;
+
+static int toInt(std::string_view s)
+{
+	bool negative = !s.empty() && s[0] == '-';
+	int result = 0;
+	for (size_t i = negative; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+		result = 10 * result + (s[i] - '0');
+	}
+	return negative ? -result : result;
+}
+
+static bool isAbsolute(std::string_view path)
+{
+	return (!path.empty() && (path[0] == '/' || path[0] == '\\')) ||
+	       (path.size() > 1 && path[1] == ':');
+}
+
+bool SourceLineIndex::parse(const char* data, size_t size, const std::string& directory)
+{
+	static const std::string_view HEADER = "|SLD.data.version|";
+	if (size < HEADER.size() || std::string_view(data, HEADER.size()) != HEADER) {
+		return false;
+	}
+
+	size_t pos = 0;
+	while (pos < size) {
+		const char* b = data + pos;
+		const auto* nl = static_cast<const char*>(std::memchr(b, '\n', size - pos));
+		const char* e = nl ? nl : data + size;
+		pos = nl ? (nl - data) + 1 : size;
+		if (e != b && e[-1] == '\r') --e;
+		std::string_view line(b, e - b);
+		// the header and comments start with the separator
+		if (line.empty() || line[0] == '|') continue;
+
+		// file|line|definition file|definition line|page|value|type|data
+		std::string_view fields[8];
+		int n = 0;
+		for (size_t start = 0; n < 8; ++n) {
+			size_t end = std::min(line.find('|', start), line.size());
+			fields[n] = line.substr(start, end - start);
+			if (end == line.size()) {
+				++n;
+				break;
+			}
+			start = end + 1;
+		}
+		if (n < 7 || fields[0].empty()) continue;
+		// 'T' for an instruction, 'D' for data
+		bool isData = fields[6].find('D') != std::string_view::npos;
+		if (!isData && fields[6].find('T') == std::string_view::npos) continue;
+		int value = toInt(fields[5]);
+		if (value < 0 || value > 0xFFFF) continue;
+
+		std::string name(fields[0]);
+		if (!isAbsolute(name) && !directory.empty()) name = directory + '/' + name;
+		auto [it, added] = fileIndex.try_emplace(name, uint16_t(files.size()));
+		if (added) files.push_back(std::move(name));
+
+		// the line can be followed by columns, "line:first:last"
+		lines.push_back({uint16_t(value), int16_t(toInt(fields[4])), it->second, isData,
+		                 toInt(fields[1])});
+	}
+
+	// in a page the lines of an address stay in the order of the file
+	std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+		return std::make_pair(a.page, a.address) < std::make_pair(b.page, b.address);
+	});
+	// The lowest page with a line for an address wins, so fill the pages
+	// in order. Every line covers its own address, a data line also the
+	// addresses up to the next line of its page.
+	anyPage.assign(0x10000, -1);
+	for (size_t i = 0; i < lines.size(); ++i) {
+		const Line& l = lines[i];
+		bool samePage = i + 1 < lines.size() && lines[i + 1].page == l.page;
+		int next = samePage ? lines[i + 1].address : 0x10000;
+		// of the lines of one address, find() takes the last one
+		if (next == l.address) continue;
+		int end = l.data ? std::min(next, l.address + MAX_DATA_SIZE) : l.address + 1;
+		for (int addr = l.address; addr < end; ++addr) {
+			if (anyPage[addr] < 0) anyPage[addr] = int32_t(i);
+		}
+	}
+	return true;
+}
+
+void SourceLineIndex::clear()
+{
+	lines.clear();
+	anyPage.clear();
+	files.clear();
+	fileIndex.clear();
+}
+
+const SourceLineIndex::Line* SourceLineIndex::find(int address, int page) const
+{
+	auto nearest = [&](int p) -> const Line* {
+		auto it = std::upper_bound(lines.begin(), lines.end(), std::make_pair(p, address),
+			[](const std::pair<int, int>& key, const Line& l) {
+				return key < std::make_pair(int(l.page), int(l.address));
+			});
+		if (it == lines.begin()) return nullptr;
+		const Line& l = *std::prev(it);
+		if (l.page != p) return nullptr;
+		if (l.address == address) return &l;
+		return (l.data && address - l.address < MAX_DATA_SIZE) ? &l : nullptr;
+	};
+	if (page >= 0) {
+		if (const auto* l = nearest(page)) return l;
+		return nearest(-1);
+	}
+	if (lines.empty() || address < 0 || address > 0xFFFF) return nullptr;
+	int pos = anyPage[address];
+	return pos >= 0 ? &lines[pos] : nullptr;
+}
@@ -0,0 +1,49 @@
+#ifndef SOURCELINEINDEX_H
+#define SOURCELINEINDEX_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Maps addresses to the source lines they were assembled from, read from
+ * the source level debug data (SLD) of sjasmplus. The lines are kept in one
+ * vector sorted on page and address, a lookup in a page is a binary search.
+ * For lookups without a page, the line of every address is merged from all
+ * pages into a table when the data is parsed.
+ */
+class SourceLineIndex
+{
+public:
+	struct Line {
+		uint16_t address;
+		int16_t page;  // the page the line was assembled in, -1 for any
+		uint16_t file; // index in files()
+		bool data;     // a data directive instead of an instruction
+		int line;      // 1 based
+	};
+
+	// Adds the lines in the SLD data, relative file names are taken from
+	// 'directory'. False when the data isn't SLD.
+	bool parse(const char* data, size_t size, const std::string& directory);
+	void clear();
+	[[nodiscard]] bool empty() const { return lines.empty(); }
+
+	// The line of the instruction at 'address', or of the data around it.
+	// 'page' is the page mapped at that address, or -1 when unknown.
+	[[nodiscard]] const Line* find(int address, int page = -1) const;
+
+	[[nodiscard]] const std::string& file(int index) const { return files[index]; }
+
+private:
+	std::vector<Line> lines; // sorted on page, then on address
+	// per address the position in lines of find(address, -1), or -1
+	std::vector<int32_t> anyPage;
+	std::vector<std::string> files;
+	std::unordered_map<std::string, uint16_t> fileIndex;
+};
+
+#endif // SOURCELINEINDEX_H
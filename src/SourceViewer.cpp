@@ -0,0 +1,86 @@
+#include "SourceViewer.h"
+#include "SymbolTable.h"
+#include "Settings.h"
+#include <QFile>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+#include <QVBoxLayout>
+
+SourceViewer::SourceViewer(QWidget* parent)
+	: QWidget(parent)
+{
+	locationLabel = new QLabel();
+
+	sourceText = new QPlainTextEdit();
+	sourceText->setReadOnly(true);
+	sourceText->setLineWrapMode(QPlainTextEdit::NoWrap);
+	sourceText->setFont(Settings::get().font(Settings::CODE_FONT));
+
+	auto* vbox = new QVBoxLayout();
+	vbox->setMargin(0);
+	vbox->addWidget(locationLabel);
+	vbox->addWidget(sourceText);
+	setLayout(vbox);
+}
+
+void SourceViewer::setSymbolTable(SymbolTable* st)
+{
+	symTable = st;
+}
+
+void SourceViewer::setMemoryLayout(MemoryLayout* ml)
+{
+	memLayout = ml;
+}
+
+void SourceViewer::setProgramCounter(uint16_t pc)
+{
+	programCounter = pc;
+	showLine();
+}
+
+void SourceViewer::refresh()
+{
+	shownFile.clear();
+	showLine();
+}
+
+void SourceViewer::showLine()
+{
+	const auto* line = symTable ? symTable->sourceLine(programCounter, memLayout) : nullptr;
+	if (!line) {
+		locationLabel->setText(tr("No source line for %1").arg(
+			QString("%1").arg(programCounter, 4, 16, QChar('0')).toUpper()));
+		sourceText->setExtraSelections({});
+		return;
+	}
+	QString file = QString::fromStdString(symTable->sourceFile(*line));
+	showFile(file);
+	locationLabel->setText(QString("%1:%2").arg(file).arg(line->line));
+
+	QTextBlock block = sourceText->document()->findBlockByNumber(line->line - 1);
+	if (!block.isValid()) {
+		sourceText->setExtraSelections({});
+		return;
+	}
+	QTextEdit::ExtraSelection selection;
+	selection.cursor = QTextCursor(block);
+	selection.format.setBackground(QColor(255, 255, 0));
+	selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+	sourceText->setExtraSelections({selection});
+	sourceText->setTextCursor(selection.cursor);
+	sourceText->centerCursor();
+}
+
+void SourceViewer::showFile(const QString& fileName)
+{
+	if (fileName == shownFile) return;
+	shownFile = fileName;
+	QFile file(fileName);
+	if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		sourceText->setPlainText(QString::fromUtf8(file.readAll()));
+	} else {
+		sourceText->setPlainText(tr("Cannot read %1").arg(fileName));
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef SOURCEVIEWER_H
+#define SOURCEVIEWER_H
+
+#include <QWidget>
+#include <cstdint>
+
+class QLabel;
+class QPlainTextEdit;
+class SymbolTable;
+struct MemoryLayout;
+
+// Shows the source line of the program counter, from the SLD files in the
+// symbol table.
+class SourceViewer : public QWidget
+{
+	Q_OBJECT
+public:
+	SourceViewer(QWidget* parent = nullptr);
+
+	void setSymbolTable(SymbolTable* st);
+	void setMemoryLayout(MemoryLayout* ml);
+
+	void setProgramCounter(uint16_t pc);
+	// reads the source file again
+	void refresh();
+
+private:
+	void showLine();
+	void showFile(const QString& fileName);
+
+	QLabel* locationLabel;
+	QPlainTextEdit* sourceText;
+
+	SymbolTable* symTable = nullptr;
+	MemoryLayout* memLayout = nullptr;
+	uint16_t programCounter = 0;
+	QString shownFile;
+};
+
+#endif // SOURCEVIEWER_H
@@ -0,0 +1,38 @@
+#include "SymbolCompleter.h"
+#include "SymbolTable.h"
+#include <QAbstractItemView>
+#include <QLineEdit>
+#include <QStringListModel>
+
+static const int MAX_COMPLETIONS = 50;
+
+SymbolCompleter::SymbolCompleter(SymbolTable& table, bool includeVars_,
+                                 const MemoryLayout* ml, QObject* parent)
+	: QCompleter(parent), symTable(table), includeVars(includeVars_), memLayout(ml)
+{
+	model = new QStringListModel(this);
+	setModel(model);
+	// the matches are already ranked, not all of them start with the text
+	setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+	setCaseSensitivity(Qt::CaseInsensitive);
+}
+
+void SymbolCompleter::watch(QLineEdit* edit)
+{
+	connect(edit, &QLineEdit::textEdited, this,
+	        [this, edit](const QString& text) { textEdited(edit, text); });
+}
+
+void SymbolCompleter::textEdited(QLineEdit* edit, const QString& text)
+{
+	if (edit->completer() != this) return;
+
+	model->setStringList(text.isEmpty()
+		? QStringList()
+		: symTable.findLabels(text, MAX_COMPLETIONS, includeVars, memLayout));
+	if (model->rowCount() == 0) {
+		popup()->hide();
+	} else {
+		complete();
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef SYMBOLCOMPLETER_H
+#define SYMBOLCOMPLETER_H
+
+#include <QCompleter>
+
+class QLineEdit;
+class QStringListModel;
+class SymbolTable;
+struct MemoryLayout;
+
+/**
+ * Completes labels while typing. The symbol table is searched for the
+ * best matches of the typed text each time it changes, instead of giving
+ * the completer a list of all labels.
+ */
+class SymbolCompleter : public QCompleter
+{
+	Q_OBJECT
+public:
+	SymbolCompleter(SymbolTable& table, bool includeVars = false,
+	                const MemoryLayout* ml = nullptr, QObject* parent = nullptr);
+
+	// complete the text typed in 'edit', while this is its completer
+	void watch(QLineEdit* edit);
+
+private:
+	void textEdited(QLineEdit* edit, const QString& text);
+
+	SymbolTable& symTable;
+	bool includeVars;
+	const MemoryLayout* memLayout;
+	QStringListModel* model;
+};
+
+#endif // SYMBOLCOMPLETER_H
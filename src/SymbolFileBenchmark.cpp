@@ -0,0 +1,145 @@
+#include "SymbolFileBenchmark.h"
+#include "SymbolFileParser.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using Format = SymbolFileParser::Format;
+
+namespace {
+
+// every run is repeated, the fastest one counts
+const int RUNS = 5;
+
+struct Sample {
+	const char* name;
+	Format format;
+	const char* header;
+	// prints label 'i' with 'value' in 'buf', returns the length
+	int (*line)(char* buf, int i, int value);
+};
+
+// 3 columns per line, like the HiTech linker writes them
+const int LINKMAP_COLUMNS = 3;
+
+const Sample samples[] = {
+	{"sjasm", Format::EQU, "",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "Label_%07d: EQU 0x%04X\n", i, v); }},
+	{"tniASM 1.x", Format::PERCENT_EQU, "",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "label_%07d: %%equ %04Xh\n", i, v); }},
+	{"asMSX", Format::ASMSX, "; global and local\n",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "%04Xh LABEL_%07d\n", v, i); }},
+	{"HiTech sym", Format::HTC, "",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "_label%07d %04X text\n", i, v); }},
+	{"HiTech map", Format::LINKMAP, "Machine type is Z80\n\n\t\tSymbol Table\n\n",
+		[](char* buf, int i, int v) {
+			const char* end = (i + 1) % LINKMAP_COLUMNS ? "  " : "\n";
+			return std::sprintf(buf, "%-16s%-8s %04X%s",
+				("_label" + std::to_string(i)).c_str(), "text", v, end);
+		}},
+	{"NoICE", Format::NOICE, "",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "def label_%07d %04Xh\n", i, v); }},
+	{"PASMO", Format::PASMO, "",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "LABEL_%07d\tEQU 0%04XH\n", i, v); }},
+	{"vasm", Format::VASM, "Sections:\n\nSymbols by value:\n",
+		[](char* buf, int i, int v) { return std::sprintf(buf, "0000%04X label_%07d\n", v, i); }},
+};
+
+std::string generate(const Sample& sample, int labels)
+{
+	std::string file = sample.header;
+	char buf[128];
+	for (int i = 0; i < labels; ++i) {
+		file.append(buf, sample.line(buf, i, (i * 7) & 0xFFFF));
+	}
+	if (sample.format == Format::LINKMAP && labels % LINKMAP_COLUMNS) {
+		// end the last line after its last column
+		file.resize(file.size() - 2);
+		file += '\n';
+	}
+	return file;
+}
+
+// the number of symbols, parsed like SymbolTable does with 'threads' chunks
+size_t parse(const std::string& file, Format format, int threads)
+{
+	auto chunks = SymbolFileParser::chunks(file.data(), file.size(), format, threads);
+	if (!chunks) return 0;
+	std::vector<std::vector<SymbolFileParser::Entry>> entries(chunks->size());
+	std::vector<QThread*> workers;
+	for (size_t i = 1; i < chunks->size(); ++i) {
+		workers.push_back(QThread::create([&, i] {
+			entries[i] = SymbolFileParser::parse(file.data(), (*chunks)[i], format);
+		}));
+		workers.back()->start();
+	}
+	if (!chunks->empty()) {
+		entries[0] = SymbolFileParser::parse(file.data(), (*chunks)[0], format);
+	}
+	for (auto* worker : workers) {
+		worker->wait();
+		delete worker;
+	}
+	size_t total = 0;
+	for (const auto& chunk : entries) total += chunk.size();
+	return total;
+}
+
+// the fastest time in ms, 'found' is the number of symbols
+double fastest(const std::string& file, Format format, int threads, size_t& found)
+{
+	double best = 0;
+	for (int run = 0; run < RUNS; ++run) {
+		QElapsedTimer timer;
+		timer.start();
+		found = parse(file, format, threads);
+		double ms = timer.nsecsElapsed() * 1e-6;
+		if (run == 0 || ms < best) best = ms;
+	}
+	return best;
+}
+
+} // namespace
+
+int benchmarkSymbolParsers(const QStringList& args)
+{
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+	int labels = 100000;
+	if (!args.isEmpty()) {
+		bool ok;
+		labels = args[0].toInt(&ok);
+		if (!ok || labels <= 0 || args.size() > 1) {
+			err << "usage: openmsx-debugger --benchmark-parsers [LABELS]\n";
+			return 1;
+		}
+	}
+
+	int threads = QThread::idealThreadCount();
+	out << QString::asprintf("%d labels per file, %d threads, fastest of %d runs\n",
+	                         labels, threads, RUNS);
+	out << QString::asprintf("%-12s %8s %10s %10s %10s\n",
+	                         "format", "MB", "1 thread", "threads", "MB/s");
+	int failures = 0;
+	for (const auto& sample : samples) {
+		std::string file = generate(sample, labels);
+		size_t found1, foundN;
+		double ms1 = fastest(file, sample.format, 1, found1);
+		double msN = fastest(file, sample.format, threads, foundN);
+		double mb = file.size() / 1e6;
+		out << QString::asprintf("%-12s %8.1f %8.1fms %8.1fms %10.0f",
+		                         sample.name, mb, ms1, msN, mb / std::max(msN, 1e-3) * 1e3);
+		// every generated label must be found, whatever the chunks
+		if (found1 != size_t(labels) || foundN != size_t(labels)) {
+			out << QString::asprintf("  FAILED, %zu and %zu labels", found1, foundN);
+			++failures;
+		}
+		out << '\n';
+	}
+	return failures ? 1 : 0;
+}
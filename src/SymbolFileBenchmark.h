@@ -0,0 +1,12 @@
+#ifndef SYMBOLFILEBENCHMARK_H
+#define SYMBOLFILEBENCHMARK_H
+
+#include <QStringList>
+
+// Batch mode, times SymbolFileParser on a generated file of every line
+// based format, with one thread and with the threads SymbolTable uses.
+// 'args' is the number of labels per file, 100000 when empty. Writes the
+// timings to stdout and returns the exit code.
+int benchmarkSymbolParsers(const QStringList& args);
+
+#endif // SYMBOLFILEBENCHMARK_H
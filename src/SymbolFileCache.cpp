@@ -0,0 +1,122 @@
+#include "SymbolFileCache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <cstring>
+
+// class ParsedSymbols
+
+void ParsedSymbols::append(std::string_view name, int value)
+{
+	entries.push_back({uint32_t(names.size()), uint32_t(name.size()), value});
+	names.append(name);
+}
+
+
+// namespace SymbolFileCache
+
+namespace SymbolFileCache {
+
+static const char MAGIC[8] = "OMDSYMS";
+// increase when the layout or the parsers change
+static const uint32_t VERSION = 1;
+
+struct Header {
+	char magic[8];
+	uint32_t version;
+	int32_t format;
+	int64_t fileSize;
+	int64_t fileTime; // ms since the epoch
+	uint32_t numEntries;
+	uint32_t namesSize;
+};
+
+static QString cacheDir()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/symbols";
+}
+
+static QString cachePath(const QFileInfo& file)
+{
+	auto key = QCryptographicHash::hash(file.absoluteFilePath().toUtf8(),
+	                                    QCryptographicHash::Sha1).toHex();
+	return cacheDir() + '/' + QString::fromLatin1(key) + ".cache";
+}
+
+static Header header(const QFileInfo& file, SymbolFileParser::Format format)
+{
+	Header h;
+	memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = VERSION;
+	h.format = int32_t(format);
+	h.fileSize = file.size();
+	h.fileTime = file.lastModified().toMSecsSinceEpoch();
+	h.numEntries = 0;
+	h.namesSize = 0;
+	return h;
+}
+
+std::optional<ParsedSymbols> load(const QFileInfo& file, SymbolFileParser::Format format)
+{
+	if (!file.exists()) return {};
+	QFile cache(cachePath(file));
+	if (!cache.open(QIODevice::ReadOnly)) return {};
+
+	QByteArray contents;
+	qint64 size = cache.size();
+	const auto* data = size ? reinterpret_cast<const char*>(cache.map(0, size)) : nullptr;
+	if (!data) {
+		contents = cache.readAll();
+		data = contents.constData();
+		size = contents.size();
+	}
+	Header h;
+	if (size_t(size) < sizeof(h)) return {};
+	memcpy(&h, data, sizeof(h));
+	auto expected = header(file, format);
+	if (memcmp(h.magic, expected.magic, sizeof(h.magic)) != 0 ||
+	    h.version != expected.version || h.format != expected.format ||
+	    h.fileSize != expected.fileSize || h.fileTime != expected.fileTime) {
+		return {};
+	}
+	auto entriesSize = size_t(h.numEntries) * sizeof(ParsedSymbols::Entry);
+	if (size_t(size) != sizeof(h) + entriesSize + h.namesSize) return {};
+
+	ParsedSymbols result;
+	result.entries.resize(h.numEntries);
+	memcpy(result.entries.data(), data + sizeof(h), entriesSize);
+	result.names.assign(data + sizeof(h) + entriesSize, h.namesSize);
+	for (const auto& entry : result.entries) {
+		if (entry.nameOffset > h.namesSize || entry.nameLength > h.namesSize - entry.nameOffset) {
+			return {};
+		}
+	}
+	return result;
+}
+
+void store(const QFileInfo& file, SymbolFileParser::Format format, ParsedSymbols symbols)
+{
+	auto h = header(file, format);
+	h.numEntries = uint32_t(symbols.entries.size());
+	h.namesSize = uint32_t(symbols.names.size());
+	auto* thread = QThread::create([h, path = cachePath(file), symbols = std::move(symbols)] {
+		QDir().mkpath(cacheDir());
+		// a cache is either complete or not there
+		QSaveFile cache(path);
+		if (!cache.open(QIODevice::WriteOnly)) return;
+		cache.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		cache.write(reinterpret_cast<const char*>(symbols.entries.data()),
+		            symbols.entries.size() * sizeof(ParsedSymbols::Entry));
+		cache.write(symbols.names.data(), symbols.names.size());
+		cache.commit();
+	});
+	QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+	thread->start(QThread::LowPriority);
+}
+
+} // namespace SymbolFileCache
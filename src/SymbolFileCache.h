@@ -0,0 +1,49 @@
+#ifndef SYMBOLFILECACHE_H
+#define SYMBOLFILECACHE_H
+
+#include "SymbolFileParser.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class QFileInfo;
+
+// The symbols of a file in the order of the file, the names in UTF-8 in
+// one buffer.
+struct ParsedSymbols
+{
+	struct Entry {
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		int32_t value;
+	};
+	std::string names;
+	std::vector<Entry> entries;
+
+	void append(std::string_view name, int value);
+	[[nodiscard]] std::string_view name(const Entry& entry) const {
+		return std::string_view(names).substr(entry.nameOffset, entry.nameLength);
+	}
+};
+
+/**
+ * Binary copies of parsed symbol files, so an unchanged file doesn't have
+ * to be parsed again. A cache file is keyed on the path of the symbol file
+ * and holds its size and modification time, it's only used when both still
+ * match. The layout is the one of ParsedSymbols in native byte order, so
+ * it's read with a single copy of the mapped file.
+ */
+namespace SymbolFileCache {
+
+// the cached symbols of 'file' when they are up to date
+std::optional<ParsedSymbols> load(const QFileInfo& file, SymbolFileParser::Format format);
+
+// Writes the cache of 'file' in the background. The size and time of 'file'
+// must be the ones from before it was parsed.
+void store(const QFileInfo& file, SymbolFileParser::Format format, ParsedSymbols symbols);
+
+} // namespace SymbolFileCache
+
+#endif // SYMBOLFILECACHE_H
@@ -0,0 +1,449 @@
+#include "SymbolFileParser.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace SymbolFileParser {
+
+// smaller parts aren't worth a thread
+static const size_t MIN_CHUNK = 0x10000;
+
+namespace {
+
+using Line = std::string_view;
+
+// the line that starts at 'pos', without the line end
+Line lineAt(const char* data, size_t pos, size_t end, size_t& next)
+{
+	const char* b = data + pos;
+	const auto* nl = static_cast<const char*>(std::memchr(b, '\n', end - pos));
+	const char* e = nl ? nl : data + end;
+	next = nl ? (nl - data) + 1 : end;
+	if (e != b && e[-1] == '\r') --e;
+	return Line(b, e - b);
+}
+
+bool startsWith(Line line, std::string_view prefix)
+{
+	return line.substr(0, prefix.size()) == prefix;
+}
+
+char lower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+bool equalsNoCase(Line a, std::string_view b)
+{
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (lower(a[i]) != lower(b[i])) return false;
+	}
+	return true;
+}
+
+// 's' starts with a character that has no case
+size_t findNoCase(Line line, std::string_view s)
+{
+	for (size_t i = line.find(s[0]); i != Line::npos; i = line.find(s[0], i + 1)) {
+		if (equalsNoCase(line.substr(i, s.size()), s)) return i;
+	}
+	return Line::npos;
+}
+
+bool isSpace(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+Line trimmed(Line s)
+{
+	while (!s.empty() && isSpace(s.front())) s.remove_prefix(1);
+	while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+	return s;
+}
+
+int digit(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	c = lower(c);
+	if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+	return 99;
+}
+
+// like QString::toInt(): an optional sign, base 0 takes a 0x prefix as hex
+// and a leading 0 as octal, base 16 allows a 0x prefix
+std::optional<int> toInt(Line s, int base)
+{
+	bool negative = false;
+	if (!s.empty() && (s[0] == '+' || s[0] == '-')) {
+		negative = s[0] == '-';
+		s.remove_prefix(1);
+	}
+	bool hexPrefix = s.size() > 2 && s[0] == '0' && lower(s[1]) == 'x';
+	if (base == 0) {
+		base = hexPrefix ? 16 : (s.size() > 1 && s[0] == '0') ? 8 : 10;
+	}
+	if (base == 16 && hexPrefix) s.remove_prefix(2);
+	if (s.empty()) return {};
+	long long result = 0;
+	for (char c : s) {
+		int d = digit(c);
+		if (d >= base) return {};
+		result = result * base + d;
+		if (result > INT_MAX + 1LL) return {};
+	}
+	if (negative) result = -result;
+	if (result > INT_MAX) return {};
+	return int(result);
+}
+
+// Accepts:
+//  - 0123h, 1234h, 1234H  (hex)
+//  - 0x1234               (hex)
+//  - 1234                 (dec)
+//  - 0123                 (oct)
+// The string may (optionally) end with a '; comment' part (with or without
+// whitespace around the ';' character).
+std::optional<int> parseValue(Line s)
+{
+	s = trimmed(s.substr(0, s.find(';')));
+	if (!s.empty() && lower(s.back()) == 'h') {
+		s.remove_suffix(1);
+		return toInt(s, 16);
+	}
+	return toInt(s, 0);
+}
+
+bool isHex(Line s)
+{
+	return std::all_of(s.begin(), s.end(), [](char c) { return digit(c) < 16; });
+}
+
+// the hex digits of HiTech files, without the 0x
+std::optional<int> parseHex(Line s)
+{
+	s = s.substr(0, s.find(';'));
+	while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+	if (!s.empty() && lower(s.back()) == 'h') s.remove_suffix(1);
+	if (s.empty() || !isHex(s)) return {};
+	return toInt(s, 16);
+}
+
+// split on 'sep', only when there are exactly 'n' parts
+template<size_t N>
+bool split(Line line, char sep, Line (&parts)[N])
+{
+	for (size_t i = 0; i < N - 1; ++i) {
+		size_t pos = line.find(sep);
+		if (pos == Line::npos) return false;
+		parts[i] = line.substr(0, pos);
+		line.remove_prefix(pos + 1);
+	}
+	if (line.find(sep) != Line::npos) return false;
+	parts[N - 1] = line;
+	return true;
+}
+
+// split on runs of tabs or runs of spaces, only when there are exactly 'n'
+// parts; a run of tabs right after a run of spaces gives an empty part
+template<size_t N>
+bool splitBlanks(Line line, Line (&parts)[N])
+{
+	size_t n = 0;
+	size_t start = 0;
+	for (size_t i = 0; i < line.size(); ) {
+		char c = line[i];
+		if (c != ' ' && c != '\t') {
+			++i;
+			continue;
+		}
+		if (n == N - 1) return false;
+		parts[n++] = line.substr(start, i - start);
+		while (i < line.size() && line[i] == c) ++i;
+		start = i;
+	}
+	if (n != N - 1) return false;
+	parts[n] = line.substr(start);
+	return true;
+}
+
+// the first 'n' characters as hex, 0 when they aren't
+int hexOrZero(Line s, size_t n = Line::npos)
+{
+	return toInt(s.substr(0, n), 16).value_or(0);
+}
+
+bool parseEqu(Line line, std::string_view equ, Entry& entry)
+{
+	size_t pos = findNoCase(line, equ);
+	if (pos == Line::npos) return false;
+	Line value = line.substr(pos + equ.size());
+	if (findNoCase(value, equ) != Line::npos) return false;
+	auto v = parseValue(value);
+	if (!v) return false;
+	entry = {line.data(), int(pos), *v};
+	return true;
+}
+
+bool parseASMSX(Line line, Entry& entry)
+{
+	auto at = [&](size_t i) { return i < line.size() ? line[i] : '\0'; };
+	if (at(0) == ';') return false;
+	bool dollar = at(0) == '$';
+	bool page = !dollar && at(4) != 'h' && at(5) != 'h';
+	if (page && at(8) != 'h') return false;
+	Line parts[2];
+	size_t space = line.find(' ');
+	if (space == Line::npos) return false;
+	parts[0] = line.substr(0, space);
+	parts[1] = line.substr(space + 1);
+	parts[1] = parts[1].substr(0, parts[1].find(' '));
+	int value;
+	if (dollar) {
+		value = hexOrZero(parts[0].substr(parts[0].size() - std::min<size_t>(4, parts[0].size())));
+	} else if (!page) {
+		size_t h = parts[0].find('h');
+		value = (h == Line::npos || h < 4) ? 0 : hexOrZero(parts[0].substr(h - 4, 4));
+	} else {
+		// MegaROM page:address
+		size_t colon = parts[0].find(':');
+		if (colon == Line::npos) return false;
+		value = hexOrZero(parts[0].substr(colon + 1), 4);
+	}
+	parts[1] = trimmed(parts[1]);
+	entry = {parts[1].data(), int(parts[1].size()), value};
+	return true;
+}
+
+// " XXXX  " followed by something else than a space or a digit
+bool linkMapColumn(Line line, size_t pos)
+{
+	if (pos + 7 > line.size()) return false;
+	if (line[pos] != ' ' || line[pos + 5] != ' ' || line[pos + 6] != ' ') return false;
+	if (!isHex(line.substr(pos + 1, 4))) return false;
+	char next = pos + 7 < line.size() ? line[pos + 7] : 'x';
+	return next != ' ' && (next < '0' || next > '9');
+}
+
+size_t findLinkMapColumn(Line line, size_t from)
+{
+	for (size_t pos = from; pos + 7 <= line.size(); ++pos) {
+		if (linkMapColumn(line, pos)) return pos;
+	}
+	return Line::npos;
+}
+
+// name, optional psect, address, matches "^([^ ]+) +[^ ]* +([0-9A-Fa-f]{4})  $"
+bool parseLinkMapColumn(Line part, Entry& entry)
+{
+	size_t n = part.size();
+	if (n < 8 || part[n - 1] != ' ' || part[n - 2] != ' ' || part[n - 7] != ' ') return false;
+	Line address = part.substr(n - 6, 4);
+	if (!isHex(address)) return false;
+	Line rest = part.substr(0, n - 6);
+	size_t nameEnd = rest.find(' ');
+	if (nameEnd == 0 || nameEnd == Line::npos) return false;
+	size_t wordStart = rest.find_first_not_of(' ', nameEnd);
+	if (wordStart != Line::npos) {
+		size_t wordEnd = rest.find(' ', wordStart);
+		if (wordEnd == Line::npos || rest.find_first_not_of(' ', wordEnd) != Line::npos) return false;
+	} else if (rest.size() - nameEnd < 2) {
+		return false;
+	}
+	entry = {part.data(), int(nameEnd), hexOrZero(address)};
+	return true;
+}
+
+// HiTech uses multiple columns of non-fixed width and a column for psect
+// may be blank so the address may be in the first or second match.
+void parseLinkMap(Line line, std::string& padded, std::vector<Entry>& result)
+{
+	if (line.empty()) return;
+	// every column ends with two spaces, the last one too
+	padded.assign(line.data(), line.size());
+	padded += "  ";
+	Line full(padded);
+	size_t len = full.size();
+	size_t width = 0;
+	bool ok = false;
+	size_t pos = 0;
+	for (int tries = 0; tries < 2 && !ok; ++tries) {
+		pos = findLinkMapColumn(full, pos);
+		if (pos == Line::npos) break;
+		width = pos + 7;
+		if (len % width == 0) {
+			ok = true;
+			for (size_t p = pos + width; p < len && ok; p += width) {
+				ok = linkMapColumn(full, p);
+			}
+		}
+		pos = width - 1;
+	}
+	if (!ok) return;
+
+	for (size_t p = 0; p < len; p += width) {
+		Entry entry;
+		if (parseLinkMapColumn(full.substr(p, width), entry)) {
+			// point into the data, not the padded copy
+			entry.name = line.data() + (entry.name - padded.data());
+			result.push_back(entry);
+		}
+	}
+}
+
+bool parseLine(Line line, Format format, Entry& entry)
+{
+	switch (format) {
+	case Format::EQU:
+		return parseEqu(line, ": equ ", entry);
+	case Format::PERCENT_EQU:
+		return parseEqu(line, ": %equ ", entry);
+	case Format::ASMSX:
+		return parseASMSX(line, entry);
+	case Format::HTC: {
+		Line l[3];
+		if (!split(line, ' ', l)) return false;
+		auto value = parseHex(l[1]);
+		if (!value) return false;
+		entry = {l[0].data(), int(l[0].size()), *value};
+		return true;
+	}
+	case Format::NOICE: {
+		Line l[3];
+		if (!split(line, ' ', l) || !equalsNoCase(l[0], "def")) return false;
+		auto value = parseValue(l[2]);
+		if (!value) return false;
+		entry = {l[1].data(), int(l[1].size()), *value};
+		return true;
+	}
+	case Format::PASMO: {
+		Line l[3];
+		if (!splitBlanks(line, l)) return false;
+		entry = {l[0].data(), int(l[0].size()), hexOrZero(l[2], 5)};
+		return true;
+	}
+	case Format::VASM: {
+		Line l[2];
+		if (!splitBlanks(line, l)) return false;
+		entry = {l[1].data(), int(l[1].size()), hexOrZero(l[0])};
+		return true;
+	}
+	case Format::LINKMAP:
+		break;
+	}
+	return false;
+}
+
+// the position of the first line from 'pos' that matches
+template<typename Pred>
+size_t findLine(const char* data, size_t pos, size_t size, Pred pred)
+{
+	while (pos < size) {
+		size_t next;
+		if (pred(lineAt(data, pos, size, next))) return pos;
+		pos = next;
+	}
+	return size;
+}
+
+// cut a part at line ends
+void cut(const char* data, Range part, int maxChunks, std::vector<Range>& result)
+{
+	size_t size = part.end - part.begin;
+	size_t n = std::clamp<size_t>(size / MIN_CHUNK, 1, std::max(maxChunks, 1));
+	size_t begin = part.begin;
+	for (size_t i = 1; i <= n && begin < part.end; ++i) {
+		size_t end = std::max(part.begin + size * i / n, begin);
+		if (i < n) {
+			const auto* nl = static_cast<const char*>(std::memchr(data + end, '\n', part.end - end));
+			end = nl ? (nl - data) + 1 : part.end;
+		} else {
+			end = part.end;
+		}
+		if (end > begin) result.push_back({begin, end});
+		begin = end;
+	}
+}
+
+} // namespace
+
+std::optional<std::vector<Range>> chunks(const char* data, size_t size, Format format, int maxChunks)
+{
+	std::vector<Range> parts;
+	switch (format) {
+	case Format::VASM: {
+		// the symbols are listed twice, take the list by value
+		size_t start = findLine(data, 0, size, [](Line l) { return startsWith(l, "Symbols by value:"); });
+		parts.push_back({start, size});
+		break;
+	}
+	case Format::LINKMAP: {
+		size_t pos = findLine(data, 0, size, [](Line l) { return startsWith(l, "Machine type"); });
+		if (pos == size) return {};
+		size_t next;
+		lineAt(data, pos, size, next);
+		pos = findLine(data, next, size, [](Line l) { return l.find("Symbol Table") != Line::npos; });
+		if (pos == size) return {};
+		lineAt(data, pos, size, next);
+		parts.push_back({next, size});
+		break;
+	}
+	case Format::ASMSX: {
+		// only the 'global and local' part, it ends with the 'other' part
+		// only the comment lines matter
+		auto nextComment = [&](size_t pos) {
+			while (pos < size) {
+				const auto* semi = static_cast<const char*>(std::memchr(data + pos, ';', size - pos));
+				if (!semi) break;
+				pos = semi - data;
+				if (pos == 0 || data[pos - 1] == '\n') return pos;
+				++pos;
+			}
+			return size;
+		};
+		size_t begin = size;
+		size_t next;
+		for (size_t pos = nextComment(0); pos < size; pos = nextComment(next)) {
+			Line line = lineAt(data, pos, size, next);
+			if (startsWith(line, "; global and local")) {
+				if (begin == size) begin = next;
+			} else if (startsWith(line, "; other")) {
+				if (begin != size) parts.push_back({begin, pos});
+				begin = size;
+			}
+		}
+		if (begin != size) parts.push_back({begin, size});
+		break;
+	}
+	default:
+		parts.push_back({0, size});
+		break;
+	}
+
+	std::vector<Range> result;
+	for (const auto& part : parts) cut(data, part, maxChunks, result);
+	return result;
+}
+
+std::vector<Entry> parse(const char* data, Range range, Format format)
+{
+	std::vector<Entry> result;
+	std::string buffer;
+	for (size_t pos = range.begin; pos < range.end; ) {
+		size_t next;
+		Line line = lineAt(data, pos, range.end, next);
+		pos = next;
+		if (format == Format::LINKMAP) {
+			parseLinkMap(line, buffer, result);
+			continue;
+		}
+		Entry entry;
+		if (parseLine(line, format, entry)) result.push_back(entry);
+	}
+	return result;
+}
+
+} // namespace SymbolFileParser
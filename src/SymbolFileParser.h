@@ -0,0 +1,46 @@
+#ifndef SYMBOLFILEPARSER_H
+#define SYMBOLFILEPARSER_H
+
+#include <optional>
+#include <vector>
+#include <stddef.h>
+
+/**
+ * Scanners for the line based symbol file formats. They work on the raw
+ * bytes of the file, so a file that is mapped in memory can be cut in
+ * chunks of whole lines that are parsed at the same time.
+ */
+namespace SymbolFileParser {
+
+enum class Format {
+	EQU,         // name: equ value (tniASM 0.x, sjasm)
+	PERCENT_EQU, // name: %equ value (tniASM 1.x)
+	ASMSX,
+	HTC,
+	LINKMAP,
+	NOICE,
+	PASMO,
+	VASM
+};
+
+struct Range {
+	size_t begin;
+	size_t end;
+};
+
+struct Entry {
+	const char* name; // in the parsed data, UTF-8
+	int length;
+	int value;
+};
+
+// The parts of the file with symbols, in lines, cut in at most 'maxChunks'
+// chunks per part. No value when the file lacks the header of its format.
+std::optional<std::vector<Range>> chunks(const char* data, size_t size, Format format, int maxChunks);
+
+// the symbols in the lines of 'data' between 'begin' and 'end'
+std::vector<Entry> parse(const char* data, Range range, Format format);
+
+} // namespace SymbolFileParser
+
+#endif // SYMBOLFILEPARSER_H
@@ -2,10 +2,13 @@
 #include "SymbolTable.h"
 #include "Settings.h"
 #include "Convert.h"
+#include "CodeAnalyzer.h"
 #include <QComboBox>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QHeaderView>
+#include <QRegExp>
+#include <algorithm>
 
 SymbolManager::SymbolManager(SymbolTable& symtable, QWidget* parent)
 	: QDialog(parent), symTable(symtable)
@@ -43,6 +46,14 @@ SymbolManager::SymbolManager(SymbolTable& symtable, QWidget* parent)
 	connect(treeLabels, &QTreeWidget::itemChanged,          this, &SymbolManager::labelChanged);
 	connect(btnAddSymbol,    &QPushButton::clicked, this, &SymbolManager::addLabel);
 	connect(btnRemoveSymbol, &QPushButton::clicked, this, &SymbolManager::removeLabel);
+	connect(btnSelectSymbols, &QPushButton::clicked, this, &SymbolManager::selectLabels);
+	connect(txtSelectName, &QLineEdit::returnPressed, this, &SymbolManager::selectLabels);
+	connect(btnSetBreakpoints, &QPushButton::clicked, this, [this]{
+		emit setBreakpointsRequested(selectedSymbols());
+	});
+	connect(btnRemoveBreakpoints, &QPushButton::clicked, this, [this]{
+		emit removeBreakpointsRequested(selectedSymbols());
+	});
 	connect(radJump,  &QRadioButton::toggled, this, &SymbolManager::changeType);
 	connect(radVar,   &QRadioButton::toggled, this, &SymbolManager::changeType);
 	connect(radValue, &QRadioButton::toggled, this, &SymbolManager::changeType);
@@ -85,6 +96,8 @@ SymbolManager::SymbolManager(SymbolTable& symtable, QWidget* parent)
 	groupSegments->setEnabled(false);
 	btnRemoveFile->setEnabled(false);
 	btnRemoveSymbol->setEnabled(false);
+	btnSetBreakpoints->setEnabled(false);
+	btnRemoveBreakpoints->setEnabled(false);
 
 	initFileList();
 	initSymbolList();
@@ -105,6 +118,16 @@ void SymbolManager::refresh()
 	initSymbolList();
 }
 
+void SymbolManager::setCallGraph(std::shared_ptr<const CallGraph> graph)
+{
+	callGraph = std::move(graph);
+	beginTreeLabelsUpdate();
+	for (int i = 0; i < treeLabels->topLevelItemCount(); ++i) {
+		updateItemStack(treeLabels->topLevelItem(i));
+	}
+	endTreeLabelsUpdate();
+}
+
 /*
  * File list support functions
  */
@@ -127,6 +150,7 @@ void SymbolManager::initFileList()
 		createComboBox(i);
 		item->setText(LAST_REFRESH, symTable.symbolFileRefresh(i).toString(fmt));
 	}
+	initSelectFiles();
 }
 
 static const char* destinationLabels[] = {
@@ -158,7 +182,7 @@ void SymbolManager::addFile()
 	// create dialog
 	auto* d = new QFileDialog(this);
 	QStringList types;
-	types << "All supported files (*.omds *.sym *.map *.noi *.symbol *.publics *.sys)"
+	types << "All supported files (*.omds *.sym *.map *.noi *.symbol *.publics *.sys *.sld)"
 		  << "OpenMSX Debugger session files (*.omds)"
 	      << "tniASM 0.x symbol files (*.sym)"
 	      << "tniASM 1.x symbol files (*.sym)"
@@ -167,7 +191,8 @@ void SymbolManager::addFile()
 	      << "HiTech C link map files (*.map)"
 	      << "NoICE command files (*.noi)"
 	      << "pasmo symbol files (*.symbol *.publics *.sys)"
-	      << "vasm symbol files (*.sym)";
+	      << "vasm symbol files (*.sym)"
+	      << "sjasmplus source level debug files (*.sld)";
 	d->setNameFilters(types);
 	d->setAcceptMode(QFileDialog::AcceptOpen);
 	d->setFileMode(QFileDialog::ExistingFile);
@@ -197,6 +222,8 @@ void SymbolManager::addFile()
 			read = symTable.readFile(n, SymbolTable::PASMO_FILE);
 		} else if (f.startsWith("vasm")) {
 			read = symTable.readFile(n, SymbolTable::VASM_FILE);
+		} else if (f.startsWith("sjasmplus")) {
+			read = symTable.readFile(n, SymbolTable::SLD_FILE);
 		} else {
 			read = symTable.readFile(n);
 		}
@@ -296,6 +323,7 @@ void SymbolManager::initSymbolList()
 		updateItemSlots(item);
 		updateItemSegments(item);
 		updateItemRegisters(item);
+		updateItemStack(item);
 	}
 	endTreeLabelsUpdate();
 }
@@ -323,7 +351,7 @@ void SymbolManager::closeEditor()
 void SymbolManager::addLabel()
 {
 	// create an empty symbol
-	auto* sym = symTable.add(std::make_unique<Symbol>(tr("New symbol"), 0));
+	auto* sym = symTable.add(tr("New symbol"), 0);
 
 	beginTreeLabelsUpdate();
 	auto* item = new QTreeWidgetItem(treeLabels);
@@ -334,6 +362,7 @@ void SymbolManager::addLabel()
 	updateItemSlots(item);
 	updateItemSegments(item);
 	updateItemRegisters(item);
+	updateItemStack(item);
 	endTreeLabelsUpdate();
 	closeEditor();
 	treeLabels->setFocus();
@@ -436,6 +465,8 @@ void SymbolManager::labelSelectionChanged()
 		wipeSelectedItem();
 		// disable everything
 		btnRemoveSymbol->setEnabled(false);
+		btnSetBreakpoints->setEnabled(false);
+		btnRemoveBreakpoints->setEnabled(false);
 		groupSlots->setEnabled(false);
 		groupSegments->setEnabled(false);
 		groupType->setEnabled(false);
@@ -477,6 +508,8 @@ void SymbolManager::labelSelectionChanged()
 	}
 
 	btnRemoveSymbol->setEnabled(removeButActive);
+	btnSetBreakpoints->setEnabled(true);
+	btnRemoveBreakpoints->setEnabled(true);
 	groupSlots->setEnabled(true);
 	groupType->setEnabled(true);
 	groupRegs8->setEnabled(anyEight);
@@ -527,6 +560,56 @@ void SymbolManager::labelSelectionChanged()
 	endTreeLabelsUpdate();
 }
 
+void SymbolManager::initSelectFiles()
+{
+	QString current = cmbSelectFile->currentText();
+	cmbSelectFile->clear();
+	cmbSelectFile->addItem(tr("All files"));
+	cmbSelectFile->addItem(tr("No file"));
+	for (int i = 0; i < symTable.symbolFilesSize(); ++i) {
+		cmbSelectFile->addItem(QFileInfo(symTable.symbolFile(i)).fileName(), i);
+	}
+	cmbSelectFile->setCurrentIndex(std::max(0, cmbSelectFile->findText(current)));
+}
+
+// Selects the labels that match the name pattern, file and type, so a whole
+// module can get breakpoints at once.
+void SymbolManager::selectLabels()
+{
+	QString name = txtSelectName->text().trimmed();
+	QRegExp pattern(name, Qt::CaseInsensitive, QRegExp::Wildcard);
+	int fileChoice = cmbSelectFile->currentIndex();
+	const QString* file = fileChoice >= 2
+	                    ? &symTable.symbolFile(cmbSelectFile->currentData().toInt()) : nullptr;
+	int typeChoice = cmbSelectType->currentIndex();
+
+	// one selection change instead of one per item
+	auto* model = treeLabels->model();
+	QItemSelection selection;
+	for (int row = 0; row < treeLabels->topLevelItemCount(); ++row) {
+		auto* item = treeLabels->topLevelItem(row);
+		auto* sym = reinterpret_cast<Symbol*>(item->data(0, Qt::UserRole).value<quintptr>());
+		if (!name.isEmpty() && !pattern.exactMatch(sym->text())) continue;
+		if (fileChoice == 1 && sym->source()) continue;
+		if (file && (!sym->source() || *sym->source() != *file)) continue;
+		if (typeChoice > 0 && sym->type() != Symbol::SymbolType(typeChoice - 1)) continue;
+		selection.select(model->index(row, 0), model->index(row, model->columnCount() - 1));
+	}
+	treeLabels->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
+	if (!selection.isEmpty()) {
+		treeLabels->scrollToItem(treeLabels->selectedItems().first());
+	}
+}
+
+QList<Symbol*> SymbolManager::selectedSymbols() const
+{
+	QList<Symbol*> symbols;
+	for (auto* sel : treeLabels->selectedItems()) {
+		symbols << reinterpret_cast<Symbol*>(sel->data(0, Qt::UserRole).value<quintptr>());
+	}
+	return symbols;
+}
+
 void SymbolManager::changeSlot(int id, int state)
 {
 	if (treeLabelsUpdateCount) return;
@@ -748,6 +831,20 @@ void SymbolManager::updateItemRegisters(QTreeWidgetItem* item)
 	item->setText(5, regText);
 }
 
+void SymbolManager::updateItemStack(QTreeWidgetItem* item)
+{
+	auto* sym = reinterpret_cast<Symbol*>(item->data(0, Qt::UserRole).value<quintptr>());
+
+	// only jump labels at the start of an analyzed routine
+	const CallGraph::Routine* routine = nullptr;
+	if (callGraph && sym->type() == Symbol::JUMPLABEL && sym->value() >= 0 && sym->value() <= 0xFFFF) {
+		routine = callGraph->routine(sym->value());
+	}
+	item->setText(7, routine ? CodeAnalyzer::stackUse(*routine) : QString());
+	item->setForeground(7, routine && CodeAnalyzer::isSuspect(*routine)
+	                       ? QColor(192, 0, 0) : item->foreground(2));
+}
+
 
 // load of functions that shouldn't really be necessary
 void SymbolManager::changeSlot00(int state)
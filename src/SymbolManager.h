@@ -2,7 +2,10 @@
 #define SYMBOLMANAGER_OPENMSX_H
 
 #include "ui_SymbolManager.h"
+#include <memory>
 
+class CallGraph;
+class Symbol;
 class SymbolTable;
 class QTreeWidgetItem;
 
@@ -13,9 +16,14 @@ public:
 	SymbolManager(SymbolTable& symtable, QWidget* parent = nullptr);
 
 	void refresh();
+	// show the stack use of the routines at the symbols
+	void setCallGraph(std::shared_ptr<const CallGraph> graph);
 
 signals:
 	void symbolTableChanged();
+	// set or remove breakpoints on the addresses of these symbols
+	void setBreakpointsRequested(const QList<Symbol*>& symbols);
+	void removeBreakpointsRequested(const QList<Symbol*>& symbols);
 
 private:
 	void closeEvent(QCloseEvent* e) override;
@@ -33,6 +41,7 @@ private:
 	void updateItemSlots(QTreeWidgetItem* item);
 	void updateItemSegments(QTreeWidgetItem* item);
 	void updateItemRegisters(QTreeWidgetItem* item);
+	void updateItemStack(QTreeWidgetItem* item);
 
 	void beginTreeLabelsUpdate();
 	void endTreeLabelsUpdate();
@@ -47,6 +56,9 @@ private:
 	void labelEdit(QTreeWidgetItem* item, int column);
 	void labelChanged(QTreeWidgetItem* item, int column);
 	void labelSelectionChanged();
+	void initSelectFiles();
+	void selectLabels();
+	QList<Symbol*> selectedSymbols() const;
 	void changeType(bool checked);
 	void changeSlot(int id, int state);
 	void changeSlot00(int state);
@@ -88,6 +100,7 @@ private:
 
 private:
 	SymbolTable& symTable;
+	std::shared_ptr<const CallGraph> callGraph;
 	int treeLabelsUpdateCount;
 	QCheckBox* chkSlots[16];
 	QCheckBox* chkRegs[18];
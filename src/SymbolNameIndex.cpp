@@ -0,0 +1,197 @@
+#include "SymbolNameIndex.h"
+#include "SymbolTable.h"
+#include <QString>
+#include <algorithm>
+#include <tuple>
+
+// in front of a name, so that the start of a name has trigrams of its own
+static const char START = '\x01';
+// compact when more entries than this were erased, and more than live ones
+static const size_t MIN_ERASED = 1024;
+static const size_t MIN_BUCKETS = 64;
+
+std::string SymbolNameIndex::fold(std::string_view name)
+{
+	// most names are ASCII, those don't need a QString
+	if (std::all_of(name.begin(), name.end(), [](char c) { return uint8_t(c) < 0x80; })) {
+		std::string result(name);
+		for (auto& c : result) {
+			if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+		}
+		return result;
+	}
+	return QString::fromUtf8(name.data(), int(name.size())).toCaseFolded().toStdString();
+}
+
+uint32_t SymbolNameIndex::hash(const std::string& folded)
+{
+	return uint32_t(std::hash<std::string>()(folded));
+}
+
+std::vector<uint32_t> SymbolNameIndex::trigrams(const std::string& folded)
+{
+	std::vector<uint32_t> result;
+	std::string s = START + folded;
+	for (size_t i = 0; i + 3 <= s.size(); ++i) {
+		result.push_back((uint8_t(s[i]) << 16) | (uint8_t(s[i + 1]) << 8) | uint8_t(s[i + 2]));
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+void SymbolNameIndex::addBucket(uint32_t entry)
+{
+	size_t mask = buckets.size() - 1;
+	size_t i = entries[entry].hash & mask;
+	while (buckets[i]) i = (i + 1) & mask;
+	buckets[i] = entry + 1;
+}
+
+void SymbolNameIndex::rehash(size_t size)
+{
+	buckets.assign(size, 0);
+	for (uint32_t entry = 0; entry < entries.size(); ++entry) {
+		if (entries[entry].symbol) addBucket(entry);
+	}
+}
+
+void SymbolNameIndex::index(uint32_t entry, const std::string& folded)
+{
+	// at most half full, erased entries included
+	if (2 * entries.size() > buckets.size()) {
+		rehash(std::max(MIN_BUCKETS, 2 * buckets.size()));
+	} else {
+		addBucket(entry);
+	}
+	for (uint32_t trigram : trigrams(folded)) {
+		byTrigram[trigram].push_back(entry);
+	}
+}
+
+void SymbolNameIndex::insert(Symbol* symbol)
+{
+	erase(symbol);
+	std::string folded = fold(symbol->name());
+	auto entry = uint32_t(entries.size());
+	entries.push_back({symbol, hash(folded)});
+	if (symbol->symId >= entryOf.size()) entryOf.resize(symbol->symId + 1, NONE);
+	entryOf[symbol->symId] = entry;
+	index(entry, folded);
+}
+
+void SymbolNameIndex::erase(Symbol* symbol)
+{
+	if (symbol->symId >= entryOf.size() || entryOf[symbol->symId] == NONE) return;
+	entries[entryOf[symbol->symId]].symbol = nullptr;
+	entryOf[symbol->symId] = NONE;
+	++numErased;
+	if (numErased > MIN_ERASED && numErased > entries.size() - numErased) compact();
+}
+
+void SymbolNameIndex::compact()
+{
+	std::vector<Symbol*> live;
+	live.reserve(entries.size() - numErased);
+	for (const auto& e : entries) {
+		if (e.symbol) live.push_back(e.symbol);
+	}
+	clear();
+	for (Symbol* symbol : live) insert(symbol);
+}
+
+void SymbolNameIndex::clear()
+{
+	entries.clear();
+	numErased = 0;
+	entryOf.clear();
+	buckets.clear();
+	byTrigram.clear();
+}
+
+std::vector<Symbol*> SymbolNameIndex::find(std::string_view name) const
+{
+	std::vector<Symbol*> result;
+	if (buckets.empty()) return result;
+	std::string folded = fold(name);
+	uint32_t h = hash(folded);
+	size_t mask = buckets.size() - 1;
+	for (size_t i = h & mask; buckets[i]; i = (i + 1) & mask) {
+		const auto& e = entries[buckets[i] - 1];
+		if (e.symbol && e.hash == h && fold(e.symbol->name()) == folded) {
+			result.push_back(e.symbol);
+		}
+	}
+	return result;
+}
+
+std::vector<Symbol*> SymbolNameIndex::search(std::string_view text, size_t maxResults,
+	const std::function<bool(const Symbol*)>& accept) const
+{
+	if (text.empty() || maxResults == 0) return {};
+	std::string folded = fold(text);
+
+	enum Rank { EQUAL, PREFIX, CONTAINS, SIMILAR };
+	struct Match {
+		Rank rank;
+		int shared; // trigrams in common with the text
+		Symbol* symbol;
+		std::string name; // folded
+	};
+	std::vector<Match> matches;
+	auto consider = [&](Symbol* symbol, std::string name, int shared, bool similar) {
+		Rank rank = name == folded                             ? EQUAL
+		          : name.compare(0, folded.size(), folded) == 0 ? PREFIX
+		          : name.find(folded) != std::string::npos     ? CONTAINS
+		          : SIMILAR;
+		if (rank == SIMILAR && !similar) return;
+		if (!accept(symbol)) return;
+		matches.push_back({rank, shared, symbol, std::move(name)});
+	};
+
+	auto wanted = trigrams(folded);
+	if (wanted.empty()) {
+		// a single byte, only names that start with it
+		for (const auto& e : entries) {
+			if (!e.symbol) continue;
+			auto first = e.symbol->name().substr(0, 1);
+			if (uint8_t(first[0]) < 0x80 && fold(first) != folded) continue;
+			std::string name = fold(e.symbol->name());
+			if (name.compare(0, folded.size(), folded) == 0) {
+				consider(e.symbol, std::move(name), 0, false);
+			}
+		}
+	} else {
+		std::vector<uint8_t> shared(entries.size(), 0);
+		for (uint32_t trigram : wanted) {
+			auto it = byTrigram.find(trigram);
+			if (it == byTrigram.end()) continue;
+			for (uint32_t entry : it->second) {
+				if (shared[entry] < 255) ++shared[entry];
+			}
+		}
+		// a name that contains the text somewhere else than at the
+		// start lacks the first trigram, allow one typo on top of that
+		int size = int(wanted.size());
+		int needed = std::max(1, size - 1 - (size - 1) / 3);
+		for (uint32_t entry = 0; entry < entries.size(); ++entry) {
+			const auto& e = entries[entry];
+			if (e.symbol && shared[entry] >= needed) {
+				consider(e.symbol, fold(e.symbol->name()), shared[entry], true);
+			}
+		}
+	}
+
+	auto better = [&](const Match& a, const Match& b) {
+		int sa = -a.shared, sb = -b.shared;
+		size_t la = a.name.size(), lb = b.name.size();
+		return std::tie(a.rank, sa, la, a.name) < std::tie(b.rank, sb, lb, b.name);
+	};
+	size_t n = std::min(maxResults, matches.size());
+	std::partial_sort(matches.begin(), matches.begin() + n, matches.end(), better);
+
+	std::vector<Symbol*> result;
+	result.reserve(n);
+	for (size_t i = 0; i < n; ++i) result.push_back(matches[i].symbol);
+	return result;
+}
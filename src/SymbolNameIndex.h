@@ -0,0 +1,67 @@
+#ifndef SYMBOLNAMEINDEX_H
+#define SYMBOLNAMEINDEX_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+class Symbol;
+
+/**
+ * Finds symbols by name, without regard to case. The names aren't copied,
+ * they are read from the symbol table and folded when needed, so for each
+ * symbol the index only keeps an entry, its hash bucket and its trigrams.
+ *
+ * Exact lookups go through a hash table. For completion every name is also
+ * indexed on its trigrams (three byte sequences, the first one starts
+ * with a marker so a prefix has trigrams too). A search ranks the names
+ * that equal the text first, then the ones that start with it, then the
+ * ones that contain it, and finally the ones that share most of its
+ * trigrams, which catches small typos.
+ */
+class SymbolNameIndex
+{
+public:
+	// index the symbol under its current name
+	void insert(Symbol* symbol);
+	void erase(Symbol* symbol);
+	void clear();
+
+	// the symbols with this name, in UTF-8
+	[[nodiscard]] std::vector<Symbol*> find(std::string_view name) const;
+
+	// the best matches for 'text' that pass 'accept', best first
+	[[nodiscard]] std::vector<Symbol*> search(std::string_view text, size_t maxResults,
+		const std::function<bool(const Symbol*)>& accept) const;
+
+	// the case folded form of a UTF-8 name
+	[[nodiscard]] static std::string fold(std::string_view name);
+
+private:
+	struct Entry {
+		Symbol* symbol; // nullptr once erased
+		uint32_t hash;  // of the folded name
+	};
+	static constexpr uint32_t NONE = UINT32_MAX;
+	[[nodiscard]] static uint32_t hash(const std::string& folded);
+	[[nodiscard]] static std::vector<uint32_t> trigrams(const std::string& folded);
+	void index(uint32_t entry, const std::string& folded);
+	void addBucket(uint32_t entry);
+	void rehash(size_t size);
+	void compact();
+
+	// Erased entries stay in the buckets and the trigram lists until there
+	// are more of them than live ones, removing them from long lists one
+	// at a time would make unloading a file quadratic.
+	std::vector<Entry> entries;
+	size_t numErased = 0;
+	std::vector<uint32_t> entryOf; // per symbol id, NONE when not indexed
+	// open addressing on the hash, entry + 1 or 0 when empty
+	std::vector<uint32_t> buckets;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> byTrigram;
+};
+
+#endif // SYMBOLNAMEINDEX_H
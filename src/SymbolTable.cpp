@@ -1,110 +1,325 @@
 #include "SymbolTable.h"
 #include "Settings.h"
 #include "DebuggerData.h"
+#include "SymbolFileCache.h"
+#include "SymbolFileParser.h"
 #include <QFile>
 #include <QTextStream>
 #include <QStringList>
-#include <QRegExp>
+#include <QThread>
 #include <QFileInfo>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QMap>
+#include <QMultiHash>
 #include <algorithm>
 #include <cassert>
-#include <memory>
 #include <optional>
 
 // class SymbolTable
 
+// compact the names when more than this and more than half is unused
+static const size_t MIN_UNUSED_NAME_BYTES = 0x10000;
+
 SymbolTable::SymbolTable()
 {
 	connect(&fileWatcher, &QFileSystemWatcher::fileChanged,
 	        this, &SymbolTable::fileChanged);
 }
 
-Symbol* SymbolTable::add(std::unique_ptr<Symbol> symbol)
+Symbol* SymbolTable::allocate(const QString* source, int value)
 {
-	auto* p = symbol.get();
-	symbols.push_back(std::move(symbol));
-	p->table = this;
-	mapSymbol(p);
-	return p;
+	Symbol* symbol;
+	if (freeIds.empty()) {
+		symbol = &store.emplace_back();
+		symbol->symId = uint32_t(store.size() - 1);
+	} else {
+		symbol = &store[freeIds.back()];
+		freeIds.pop_back();
+	}
+	symbol->table = this;
+	symbol->symSource = source;
+	symbol->nameLength = 0;
+	symbol->symValue = value;
+	symbol->symRegisters = (value & 0xFF00) ? Symbol::REG_ALL16 : Symbol::REG_ALL;
+	symbol->symSlots = 0xffff;
+	symbol->symStatus = Symbol::ACTIVE;
+	symbol->symType = Symbol::JUMPLABEL;
+	++numSymbols;
+	return symbol;
 }
 
-std::unique_ptr<Symbol> SymbolTable::removeAt(size_t index)
+// The slot can be reused once the symbol is unmapped, or dropReleased()
+// took it out of the orders.
+void SymbolTable::release(Symbol* symbol)
 {
-	assert(index < symbols.size());
-	auto symbol = std::move(symbols[index]);
-	symbols.erase(symbols.begin() + index); // TODO optimize: swap with back(), then pop_back()
-	unmapSymbol(symbol.get());
-	return symbol;
+	for (auto& index : layoutIndexes) {
+		if (index.valid) index.symbols.erase(symbol, symbol->value());
+	}
+	if (nameIndexValid) nameIndex.erase(symbol);
+	unusedNameBytes += symbol->nameLength;
+	symbol->table = nullptr;
+	freeIds.push_back(id(symbol));
+	--numSymbols;
 }
 
-std::unique_ptr<Symbol> SymbolTable::remove(Symbol* symbol)
+uint32_t SymbolTable::id(const Symbol* symbol) const
 {
-	auto it = std::find_if(symbols.begin(), symbols.end(),
-	                       [&](auto& e) { return e.get() == symbol; });
-	if (it == symbols.end()) return {};
+	return symbol->symId;
+}
+
+template<typename F> void SymbolTable::forEachSymbol(F f)
+{
+	for (auto& symbol : store) {
+		if (symbol.table) f(&symbol);
+	}
+}
 
-	return removeAt(std::distance(symbols.begin(), it));
+void SymbolTable::setName(Symbol* symbol, std::string_view name)
+{
+	if (unusedNameBytes > MIN_UNUSED_NAME_BYTES && unusedNameBytes > names.size() / 2) {
+		compactNames();
+	}
+	unusedNameBytes += symbol->nameLength;
+	symbol->nameOffset = uint32_t(names.size());
+	symbol->nameLength = uint32_t(name.size());
+	names.append(name);
+}
+
+void SymbolTable::setName(Symbol* symbol, const QString& name)
+{
+	QByteArray utf8 = name.toUtf8();
+	setName(symbol, std::string_view(utf8.constData(), utf8.size()));
+}
+
+void SymbolTable::compactNames()
+{
+	std::string compacted;
+	compacted.reserve(names.size() - unusedNameBytes);
+	forEachSymbol([&](Symbol* symbol) {
+		auto offset = uint32_t(compacted.size());
+		compacted.append(names, symbol->nameOffset, symbol->nameLength);
+		symbol->nameOffset = offset;
+	});
+	names = std::move(compacted);
+	unusedNameBytes = 0;
+}
+
+Symbol* SymbolTable::add(const QString& name, int value, const QString* source)
+{
+	auto* p = allocate(source, value);
+	setName(p, name);
+	mapSymbol(p);
+	// symbols are mostly added in bulk, rebuilding once is cheaper
+	invalidateIndexes();
+	if (nameIndexValid) nameIndex.insert(p);
+	return p;
+}
+
+void SymbolTable::remove(Symbol* symbol)
+{
+	if (!symbol || symbol->table != this) return;
+	unmapSymbol(symbol, symbol->value(), symbol->type());
+	release(symbol);
 }
 
 void SymbolTable::clear()
 {
-	addressSymbols.clear();
-	valueSymbols.clear();
-	symbols.clear();
+	addressOrder.clear();
+	valueOrder.clear();
+	addressSorted = valueSorted = 0;
+	currentAddress = 0;
+	store.clear();
+	freeIds.clear();
+	numSymbols = 0;
+	names.clear();
+	unusedNameBytes = 0;
+	invalidateIndexes();
+	nameIndex.clear();
+	nameIndexValid = false;
 }
 
 int SymbolTable::size() const
 {
-	return symbols.size();
+	return numSymbols;
+}
+
+// Sorts the additions into the orders. A single new symbol costs a merge,
+// loading a file a single sort.
+void SymbolTable::sortOrders() const
+{
+	auto sort = [&](std::vector<uint32_t>& order, size_t& sorted) {
+		if (sorted == order.size()) return;
+		auto less = [&](uint32_t a, uint32_t b) {
+			int va = store[a].symValue, vb = store[b].symValue;
+			return va != vb ? va < vb : a > b;
+		};
+		auto middle = order.begin() + sorted;
+		std::sort(middle, order.end(), less);
+		std::inplace_merge(order.begin(), middle, order.end(), less);
+		sorted = order.size();
+	};
+	sort(addressOrder, addressSorted);
+	sort(valueOrder, valueSorted);
+}
+
+// removes the released symbols from the orders
+void SymbolTable::dropReleased()
+{
+	sortOrders();
+	for (auto* order : {&addressOrder, &valueOrder}) {
+		order->erase(std::remove_if(order->begin(), order->end(),
+			[&](uint32_t i) { return store[i].table == nullptr; }), order->end());
+	}
+	addressSorted = addressOrder.size();
+	valueSorted = valueOrder.size();
 }
 
 void SymbolTable::mapSymbol(Symbol* symbol)
 {
+	uint32_t i = id(symbol);
 	if (symbol->type() != Symbol::VALUE) {
-		addressSymbols.insert(symbol->value(), symbol);
+		addressOrder.push_back(i);
 	}
 	if (symbol->type() != Symbol::JUMPLABEL) {
-		valueSymbols.insert(symbol->value(), symbol);
+		valueOrder.push_back(i);
 	}
 }
 
-void SymbolTable::unmapSymbol(Symbol* symbol)
+// 'value' and 'type' are the ones the symbol was mapped with
+void SymbolTable::unmapSymbol(Symbol* symbol, int value, Symbol::SymbolType type)
 {
-	QMutableMapIterator<int, Symbol*> i(addressSymbols);
-	while (i.hasNext()) {
-		i.next();
-		if (i.value() == symbol) i.remove();
+	uint32_t i = id(symbol);
+	auto erase = [&](std::vector<uint32_t>& order, size_t& sorted) {
+		// not sorted in yet, most likely it was just added
+		auto tail = std::find(order.rbegin(), order.rend() - sorted, i);
+		if (tail != order.rend() - sorted) {
+			order.erase(std::next(tail).base());
+			return;
+		}
+		// the symbol itself may have a new value already
+		auto end = order.begin() + sorted;
+		auto it = std::lower_bound(order.begin(), end, i, [&](uint32_t a, uint32_t b) {
+			int va = a == i ? value : store[a].symValue;
+			int vb = b == i ? value : store[b].symValue;
+			return va != vb ? va < vb : a > b;
+		});
+		if (it != end && *it == i) {
+			order.erase(it);
+			--sorted;
+		}
+	};
+	if (type != Symbol::VALUE) {
+		erase(addressOrder, addressSorted);
 	}
-	QMutableHashIterator<int, Symbol*> j(valueSymbols);
-	while (j.hasNext()) {
-		j.next();
-		if (j.value() == symbol) j.remove();
+	if (type != Symbol::JUMPLABEL) {
+		erase(valueOrder, valueSorted);
 	}
 }
 
-void SymbolTable::symbolTypeChanged(Symbol* symbol)
+void SymbolTable::symbolTypeChanged(Symbol* symbol, Symbol::SymbolType oldType)
 {
-	unmapSymbol(symbol);
+	unmapSymbol(symbol, symbol->value(), oldType);
 	mapSymbol(symbol);
+	updateIndex(symbol, symbol->value());
 }
 
-void SymbolTable::symbolValueChanged(Symbol* symbol)
+void SymbolTable::symbolValueChanged(Symbol* symbol, int oldValue)
 {
-	unmapSymbol(symbol);
+	unmapSymbol(symbol, oldValue, symbol->type());
 	mapSymbol(symbol);
+	updateIndex(symbol, oldValue);
+}
+
+void SymbolTable::symbolTextChanged(Symbol* symbol)
+{
+	// the address indexes read the name from the table, the name index
+	// hashes it and indexes its trigrams
+	if (nameIndexValid) nameIndex.insert(symbol);
+}
+
+void SymbolTable::symbolSlotsChanged(Symbol* symbol)
+{
+	updateIndex(symbol, symbol->value());
+}
+
+static std::array<int8_t, 4> layoutSlots(const MemoryLayout* ml)
+{
+	std::array<int8_t, 4> result;
+	for (int page = 0; page < 4; ++page) {
+		if (!ml) {
+			result[page] = -1;
+			continue;
+		}
+		int ps = ml->primarySlot[page] & 3;
+		int ss = ml->isSubslotted[ps] ? (ml->secondarySlot[page] & 3) : 0;
+		result[page] = 4 * ps + ss;
+	}
+	return result;
+}
+
+bool SymbolTable::isIndexed(const Symbol* symbol, const std::array<int8_t, 4>& pageSlots)
+{
+	if (symbol->type() == Symbol::VALUE) return false;
+	if (symbol->value() < 0 || symbol->value() > 0xFFFF) return false;
+	int slot = pageSlots[symbol->value() >> 14];
+	return slot < 0 || (symbol->validSlots() & (1 << slot));
+}
+
+void SymbolTable::invalidateIndexes()
+{
+	for (auto& index : layoutIndexes) {
+		index.valid = false;
+		index.symbols.clear();
+	}
+}
+
+void SymbolTable::updateIndex(Symbol* symbol, int oldValue)
+{
+	for (auto& index : layoutIndexes) {
+		if (!index.valid) continue;
+		index.symbols.erase(symbol, oldValue);
+		if (isIndexed(symbol, index.pageSlots)) index.symbols.insert(symbol);
+	}
+}
+
+const AddressSymbolIndex& SymbolTable::addressIndex(const MemoryLayout* ml)
+{
+	auto layout = layoutSlots(ml);
+	LayoutIndex* index = nullptr;
+	for (auto& i : layoutIndexes) {
+		if (i.valid && i.pageSlots == layout) {
+			index = &i;
+			break;
+		}
+	}
+	if (!index) {
+		// reuse the one that wasn't used the longest
+		index = &*std::min_element(layoutIndexes.begin(), layoutIndexes.end(),
+			[](const LayoutIndex& a, const LayoutIndex& b) {
+				return std::make_pair(a.valid, a.lastUse) < std::make_pair(b.valid, b.lastUse);
+			});
+		index->pageSlots = layout;
+		index->symbols.clear();
+		// the order is already sorted on address
+		sortOrders();
+		for (uint32_t i : addressOrder) {
+			if (isIndexed(&store[i], layout)) index->symbols.append(&store[i]);
+		}
+		index->valid = true;
+	}
+	index->lastUse = ++indexUses;
+	return index->symbols;
 }
 
 Symbol* SymbolTable::findFirstAddressSymbol(int addr, MemoryLayout* ml)
 {
-	for (currentAddress = addressSymbols.begin();
-	     currentAddress != addressSymbols.end(); ++currentAddress) {
-		if ((*currentAddress)->value() >= addr) {
-			if ((*currentAddress)->isSlotValid(ml)) {
-				return *currentAddress;
-			}
+	sortOrders();
+	currentAddress = std::lower_bound(addressOrder.begin(), addressOrder.end(), addr,
+		[&](uint32_t i, int a) { return store[i].symValue < a; }) - addressOrder.begin();
+	for (; currentAddress < addressOrder.size(); ++currentAddress) {
+		if (store[addressOrder[currentAddress]].isSlotValid(ml)) {
+			return &store[addressOrder[currentAddress]];
 		}
 	}
 	return nullptr;
@@ -112,26 +327,38 @@ Symbol* SymbolTable::findFirstAddressSymbol(int addr, MemoryLayout* ml)
 
 Symbol* SymbolTable::getCurrentAddressSymbol()
 {
-	return currentAddress != addressSymbols.end() ? *currentAddress : nullptr;
+	return currentAddress < addressOrder.size() ? &store[addressOrder[currentAddress]] : nullptr;
 }
 
 Symbol* SymbolTable::findNextAddressSymbol(MemoryLayout* ml)
 {
-	for (++currentAddress; currentAddress != addressSymbols.end();
-	     ++currentAddress) {
-		if ((*currentAddress)->isSlotValid(ml)) {
-			return *currentAddress;
+	for (++currentAddress; currentAddress < addressOrder.size(); ++currentAddress) {
+		if (store[addressOrder[currentAddress]].isSlotValid(ml)) {
+			return &store[addressOrder[currentAddress]];
 		}
 	}
 	return nullptr;
 }
 
+// the ids in 'order' of the symbols with this value
+static std::pair<std::vector<uint32_t>::const_iterator, std::vector<uint32_t>::const_iterator>
+	equalValues(const std::vector<uint32_t>& order, const std::deque<Symbol>& store, int val)
+{
+	auto first = std::lower_bound(order.begin(), order.end(), val,
+		[&](uint32_t i, int v) { return store[i].value() < v; });
+	auto last = std::upper_bound(first, order.end(), val,
+		[&](int v, uint32_t i) { return v < store[i].value(); });
+	return {first, last};
+}
+
 Symbol* SymbolTable::getValueSymbol(int val, Symbol::Register reg, MemoryLayout* ml)
 {
-	for (auto it = valueSymbols.find(val); it != valueSymbols.end() && it.key() == val; ++it) {
-		if ((it.value()->validRegisters() & reg) &&
-		    it.value()->isSlotValid(ml)) {
-			return it.value();
+	sortOrders();
+	auto [first, last] = equalValues(valueOrder, store, val);
+	for (auto it = first; it != last; ++it) {
+		auto& symbol = store[*it];
+		if ((symbol.validRegisters() & reg) && symbol.isSlotValid(ml)) {
+			return &symbol;
 		}
 	}
 	return nullptr;
@@ -139,38 +366,63 @@ Symbol* SymbolTable::getValueSymbol(int val, Symbol::Register reg, MemoryLayout*
 
 Symbol* SymbolTable::getAddressSymbol(int addr, MemoryLayout* ml)
 {
-	for (auto it = addressSymbols.find(addr); it != addressSymbols.end() && it.key() == addr; ++it) {
-		if (it.value()->isSlotValid(ml)) {
-			return it.value();
-		}
-	}
-	return nullptr;
+	// the index of the layout has the valid symbols only
+	const auto& index = addressIndex(ml);
+	int pos = index.find(addr);
+	return pos != AddressSymbolIndex::NOT_FOUND ? index.symbol(pos) : nullptr;
 }
 
 Symbol* SymbolTable::getAddressSymbol(const QString& label, bool case_sensitive)
 {
-	for (auto it = addressSymbols.begin(); it != addressSymbols.end(); ++it) {
-		if (it.value()->text().compare(label, Qt::CaseSensitive)==0)
-			return it.value();
-		if (!case_sensitive && it.value()->text().compare(label, Qt::CaseInsensitive)==0)
-			return it.value();
+	// the one with the lowest address, like the first one in the address order
+	Symbol* result = nullptr;
+	for (Symbol* symbol : nameLookup().find(label.toStdString())) {
+		if (symbol->type() == Symbol::VALUE) continue;
+		if (case_sensitive && symbol->text() != label) continue;
+		if (!result || symbol->value() < result->value()) result = symbol;
 	}
-	return nullptr;
+	return result;
 }
 
-QStringList SymbolTable::labelList(bool include_vars, const MemoryLayout* ml) const
+QStringList SymbolTable::labelList(bool include_vars, const MemoryLayout* ml)
 {
+	// the index of the layout has the valid symbols only
+	const auto& index = addressIndex(ml);
 	QStringList labels;
-	for (auto it = addressSymbols.begin(); it != addressSymbols.end(); ++it) {
-		if (it.value()->type() == Symbol::JUMPLABEL || (include_vars && it.value()->type() == Symbol::VARIABLELABEL)) {
-			if (ml == nullptr || it.value()->isSlotValid(ml)) {
-				labels << it.value()->text();
-			}
+	for (int pos = 0; pos < index.size(); ++pos) {
+		const auto* symbol = index.symbol(pos);
+		if (symbol->type() == Symbol::JUMPLABEL || (include_vars && symbol->type() == Symbol::VARIABLELABEL)) {
+			labels << symbol->text();
 		}
 	}
 	return labels;
 }
 
+QStringList SymbolTable::findLabels(const QString& text, int maxResults,
+                                    bool include_vars, const MemoryLayout* ml)
+{
+	auto found = nameLookup().search(text.toStdString(), maxResults, [&](const Symbol* symbol) {
+		return (symbol->type() == Symbol::JUMPLABEL ||
+		        (include_vars && symbol->type() == Symbol::VARIABLELABEL)) &&
+		       (ml == nullptr || symbol->isSlotValid(ml));
+	});
+	QStringList labels;
+	for (const auto* symbol : found) labels << symbol->text();
+	return labels;
+}
+
+const SymbolNameIndex& SymbolTable::nameLookup()
+{
+	if (!nameIndexValid) {
+		nameIndex.clear();
+		forEachSymbol([&](Symbol* symbol) {
+			nameIndex.insert(symbol);
+		});
+		nameIndexValid = true;
+	}
+	return nameIndex;
+}
+
 int SymbolTable::symbolFilesSize() const
 {
 	return symbolFiles.size();
@@ -200,6 +452,9 @@ bool SymbolTable::readFile(const QString& filename, FileType type)
 		} else if (fname.endsWith(".map")) {
 			// HiTech link map file
 			type = LINKMAP_FILE;
+		} else if (fname.endsWith(".sld")) {
+			// sjasmplus source level debug data
+			type = SLD_FILE;
 		} else if (fname.endsWith(".sym")) {
 			// auto detect which sym file
 			QFile file(filename);
@@ -253,6 +508,8 @@ bool SymbolTable::readFile(const QString& filename, FileType type)
 		return readPASMOFile(filename);
 	case VASM_FILE:
 		return readVASMFile(filename);
+	case SLD_FILE:
+		return readSLDFile(filename);
 	default:
 		return false;
 	}
@@ -268,49 +525,99 @@ void SymbolTable::appendFile(const QString& file, FileType type)
 	fileWatcher.addPath(file);
 }
 
-// Universal value parsing routine. Accepts:
-//  - 0123h, 1234h, 1234H  (hex)
-//  - 0x1234               (hex)
-//  - 1234                 (dec)
-//  - 0123                 (oct)
-// The string may (optionally) end with a '; comment' part (with or without
-// whitespace around the ';' character).
-static std::optional<int> parseValue(const QString& str)
-{
-	QStringList l = str.split(";"); // ignore stuff after ';'
-	QString s = l.at(0).trimmed();
-	bool success;
-	int result;
-	if (s.endsWith('h', Qt::CaseInsensitive)) {
-		s.chop(1);
-		result = s.toInt(&success, 16);
-	} else {
-		result = s.toInt(&success, 0); // any base (e.g. 0x..)
+// the format of the files that are parsed by SymbolFileParser
+static std::optional<SymbolFileParser::Format> parserFormat(SymbolTable::FileType type)
+{
+	using Format = SymbolFileParser::Format;
+	switch (type) {
+	case SymbolTable::TNIASM0_FILE: return Format::EQU;
+	case SymbolTable::TNIASM1_FILE: return Format::PERCENT_EQU;
+	case SymbolTable::SJASM_FILE:   return Format::EQU;
+	case SymbolTable::ASMSX_FILE:   return Format::ASMSX;
+	case SymbolTable::LINKMAP_FILE: return Format::LINKMAP;
+	case SymbolTable::HTC_FILE:     return Format::HTC;
+	case SymbolTable::NOICE_FILE:   return Format::NOICE;
+	case SymbolTable::PASMO_FILE:   return Format::PASMO;
+	case SymbolTable::VASM_FILE:    return Format::VASM;
+	default:                        return {};
 	}
-	if (success) return result;
-	return {};
 }
 
-bool SymbolTable::readSymbolFile(
-	const QString& filename, FileType type, const QString& equ)
+// The names and values in a symbol file, in the order of the file. No value
+// when the file can't be read. They come from the cache when the file didn't
+// change since it was last parsed.
+static std::optional<ParsedSymbols> parseSymbolFile(
+	const QString& filename, SymbolFileParser::Format format)
 {
+	// the size and time from before parsing go in the cache
+	QFileInfo info(filename);
+	if (auto cached = SymbolFileCache::load(info, format)) {
+		return cached;
+	}
+
 	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return false;
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
 	}
 
-	appendFile(filename, type);
-	const auto* source = &symbolFiles.back().fileName;
+	// parse the file where it's mapped, not every file can be mapped
+	QByteArray contents;
+	qint64 size = file.size();
+	const auto* data = size ? reinterpret_cast<const char*>(file.map(0, size)) : "";
+	if (!data) {
+		contents = file.readAll();
+		data = contents.constData();
+		size = contents.size();
+	}
+
+	// the chunks of lines are parsed at the same time
+	auto chunks = SymbolFileParser::chunks(data, size, format, QThread::idealThreadCount());
+	if (!chunks) return {};
+	std::vector<std::vector<SymbolFileParser::Entry>> entries(chunks->size());
+	std::vector<QThread*> threads;
+	for (size_t i = 1; i < chunks->size(); ++i) {
+		threads.push_back(QThread::create([&, i] {
+			entries[i] = SymbolFileParser::parse(data, (*chunks)[i], format);
+		}));
+		threads.back()->start();
+	}
+	if (!chunks->empty()) {
+		entries[0] = SymbolFileParser::parse(data, (*chunks)[0], format);
+	}
+	for (auto* thread : threads) {
+		thread->wait();
+		delete thread;
+	}
 
-	QTextStream in(&file);
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		QStringList l = line.split(equ, Qt::SplitBehaviorFlags::KeepEmptyParts, Qt::CaseInsensitive);
-		if (l.size() != 2) continue;
-		if (auto value = parseValue(l.at(1))) {
-			add(std::make_unique<Symbol>(l.at(0), *value, source));
+	size_t total = 0;
+	for (const auto& chunk : entries) total += chunk.size();
+	ParsedSymbols result;
+	result.entries.reserve(total);
+	for (const auto& chunk : entries) {
+		for (const auto& entry : chunk) {
+			result.append(std::string_view(entry.name, entry.length), entry.value);
 		}
 	}
+	SymbolFileCache::store(info, format, result);
+	return result;
+}
+
+bool SymbolTable::readSymbolFile(const QString& filename, FileType type)
+{
+	auto parsed = parseSymbolFile(filename, *parserFormat(type));
+	if (!parsed) return false;
+
+	appendFile(filename, type);
+	const auto* source = &symbolFiles.back().fileName;
+	// the name index is built again when it's needed
+	nameIndex.clear();
+	nameIndexValid = false;
+	invalidateIndexes();
+	for (const auto& entry : parsed->entries) {
+		auto* sym = allocate(source, entry.value);
+		setName(sym, parsed->name(entry));
+		mapSymbol(sym);
+	}
 	return true;
 }
 bool SymbolTable::readOMDSFile(const QString& filename)
@@ -327,215 +634,99 @@ bool SymbolTable::readOMDSFile(const QString& filename)
 }
 bool SymbolTable::readTNIASM0File(const QString& filename)
 {
-	return readSymbolFile(filename, TNIASM0_FILE, ": equ ");
+	return readSymbolFile(filename, TNIASM0_FILE);
 }
 bool SymbolTable::readTNIASM1File(const QString& filename)
 {
-	return readSymbolFile(filename, TNIASM1_FILE, ": %equ ");
+	return readSymbolFile(filename, TNIASM1_FILE);
 }
 bool SymbolTable::readSJASMFile(const QString& filename)
 {
-	return readSymbolFile(filename, SJASM_FILE, ": equ ");
+	return readSymbolFile(filename, SJASM_FILE);
 }
-
 bool SymbolTable::readASMSXFile(const QString& filename)
 {
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return false;
-	}
-
-	appendFile(filename, ASMSX_FILE);
-	const auto* source = &symbolFiles.back().fileName;
-
-	QTextStream in(&file);
-	int filePart = 0;
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		if (line[0] == ';') {
-			if (line.startsWith("; global and local")) {
-				filePart = 1;
-			} else if (line.startsWith("; other")) {
-				filePart = 2;
-			}
-		} else {
-			if ((line[0] == '$') || (line[4] == 'h') ||
-			    (line[5] == 'h') || (line[8] == 'h')) {
-				if (filePart == 1) {
-					QStringList l = line.split(" ");
-					std::unique_ptr<Symbol> sym;
-					if (line[0] == '$') {
-						add(std::make_unique<Symbol>(l.at(1).trimmed(), l.at(0).right(4).toInt(nullptr, 16), source));
-					} else if ((line[4] == 'h') || (line[5] == 'h')) {
-						add(std::make_unique<Symbol>(l.at(1).trimmed(), l.at(0).mid(l.at(0).indexOf('h') - 4, 4).toInt(nullptr, 16), source));
-					} else {
-						QStringList n = l.at(0).split(":"); // n.at(0) = MegaROM page
-						add(std::make_unique<Symbol>(l.at(1).trimmed(), n.at(1).left(4).toInt(nullptr, 16), source));
-					}
-				} else if (filePart == 2) {
-					//
-				}
-			}
-		}
-	}
-	return true;
+	return readSymbolFile(filename, ASMSX_FILE);
 }
-
 bool SymbolTable::readPASMOFile(const QString& filename)
 {
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return false;
-	}
-	appendFile(filename, PASMO_FILE);
-	const auto* source = &symbolFiles.back().fileName;
-
-	QTextStream in(&file);
-	while (!in.atEnd()) {
-		QString line;
-		QStringList l;
-		line = in.readLine();
-		l = line.split(QRegExp("(\t+)|( +)"));
-		if (l.size() == 3) {
-			add(std::make_unique<Symbol>(l.at(0), l.at(2).left(5).toInt(nullptr, 16), source));
-		}
-	}
-	return true;
+	return readSymbolFile(filename, PASMO_FILE);
+}
+bool SymbolTable::readVASMFile(const QString& filename)
+{
+	return readSymbolFile(filename, VASM_FILE);
+}
+bool SymbolTable::readHTCFile(const QString& filename)
+{
+	return readSymbolFile(filename, HTC_FILE);
+}
+bool SymbolTable::readNoICEFile(const QString& filename)
+{
+	return readSymbolFile(filename, NOICE_FILE);
+}
+bool SymbolTable::readLinkMapFile(const QString& filename)
+{
+	return readSymbolFile(filename, LINKMAP_FILE);
 }
 
-bool SymbolTable::readVASMFile(const QString& filename) {
+// adds the lines of an SLD file to 'index'
+static bool readSourceLineFile(const QString& filename, SourceLineIndex& index)
+{
 	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+	if (!file.open(QIODevice::ReadOnly)) {
 		return false;
 	}
-	appendFile(filename, VASM_FILE);
-	const auto* source = &symbolFiles.back().fileName;
-
-	bool skipline = true;
-
-	QTextStream in(&file);
-	while (!in.atEnd()) {
-		QString line;
-		QStringList l;
-		line = in.readLine();
-		if (line.startsWith("Symbols by value:"))
-			skipline = false;
-		if (skipline) 
-			continue;
-		l = line.split(QRegExp("(\t+)|( +)"));
-		if (l.size() == 2) {
-			add(std::make_unique<Symbol>(l.at(1), l.at(0).toInt(nullptr, 16), source));
-		}
+	QByteArray contents;
+	qint64 size = file.size();
+	const auto* data = size ? reinterpret_cast<const char*>(file.map(0, size)) : "";
+	if (!data) {
+		contents = file.readAll();
+		data = contents.constData();
+		size = contents.size();
 	}
-	return true;
+	auto directory = QFileInfo(filename).absolutePath().toStdString();
+	return index.parse(data, size, directory);
 }
 
-bool SymbolTable::readHTCFile(const QString& filename)
+bool SymbolTable::readSLDFile(const QString& filename)
 {
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return false;
-	}
-
-	appendFile(filename, HTC_FILE);
-	const auto* source = &symbolFiles.back().fileName;
-
-	QTextStream in(&file);
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		QStringList l = line.split(' ');
-		if (l.size() != 3) continue;
-		if (auto value = parseValue("0x" + l.at(1))) {
-			add(std::make_unique<Symbol>(l.at(0), *value, source));
-		}
-	}
+	if (!readSourceLineFile(filename, sourceLines)) return false;
+	appendFile(filename, SLD_FILE);
+	emit sourceLinesChanged();
 	return true;
 }
 
-bool SymbolTable::readNoICEFile(const QString& filename)
+// reads the lines of all SLD files again
+void SymbolTable::readSourceLines()
 {
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return false;
+	sourceLines.clear();
+	for (const auto& file : symbolFiles) {
+		if (file.fileType == SLD_FILE) readSourceLineFile(file.fileName, sourceLines);
 	}
+	emit sourceLinesChanged();
+}
 
-	appendFile(filename, NOICE_FILE);
-	const auto* source = &symbolFiles.back().fileName;
-
-	QTextStream in(&file);
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		QStringList l = line.split(" ", Qt::SplitBehaviorFlags::KeepEmptyParts, Qt::CaseInsensitive);
-		if (l.size() != 3) continue;
-		if (l.at(0).toLower() != "def") continue;
-		if (auto value = parseValue(l.at(2))) {
-			add(std::make_unique<Symbol>(l.at(1), *value, source));
+const SourceLineIndex::Line* SymbolTable::sourceLine(int address, const MemoryLayout* ml) const
+{
+	if (sourceLines.empty()) return nullptr;
+	// the mapper segment, or the ROM block, in that page
+	int page = -1;
+	if (ml) {
+		int p = (address >> 14) & 3;
+		int ps = ml->primarySlot[p] & 3;
+		int ss = ml->isSubslotted[ps] ? (ml->secondarySlot[p] & 3) : 0;
+		if (ml->mapperSize[ps][ss] > 0) {
+			page = ml->mapperSegment[p];
+		} else {
+			page = std::max(-1, ml->romBlock[((address >> 13) & 7)]);
 		}
 	}
-	return true;
+	return sourceLines.find(address, page);
 }
 
-bool SymbolTable::readLinkMapFile(const QString& filename)
+const std::string& SymbolTable::sourceFile(const SourceLineIndex::Line& line) const
 {
-	const QString magic("Machine type");
-	const QString tableStart("Symbol Table");
-
-	QRegExp rx(" [0-9A-Fa-f]{4}  (?![ 0-9])");
-	QRegExp rp("^([^ ]+) +[^ ]* +([0-9A-Fa-f]{4})  $");
-
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return false;
-	}
-	appendFile(filename, LINKMAP_FILE);
-	const auto* source = &symbolFiles.back().fileName;
-
-	QTextStream in(&file);
-	if (in.atEnd()) return false;
-	while (true) {
-		if (in.atEnd()) return false;
-		if (in.readLine().startsWith(magic)) break;
-	}
-	while (true) {
-		if (in.atEnd()) return false;
-		if (in.readLine().contains(tableStart)) break;
-	}
-
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		Q_ASSERT(!line.endsWith("\r"));
-		if (line.isEmpty()) continue;
-
-		line += "  ";
-		int len = line.length();
-		int l;
-		int pos = 0;
-		bool ok = false;
-		// HiTech uses multiple columns of non-fixed width and
-		// a column for psect may be blank so the address may in
-		// the first or second match.
-		for (int tries = 0; (tries < 2) && !ok; ++tries) {
-			pos = rx.indexIn(line, pos);
-			l = pos + rx.matchedLength();
-			if ((l > 0) && (len % l) == 0) {
-				ok = true;
-				for (int posn = pos + l; (posn < len) && ok; posn += l) {
-					ok = (posn == rx.indexIn(line, posn));
-				}
-			}
-			pos = l - 1;
-		}
-		if (!ok) continue;
-
-		for (pos = 0; pos < len; pos += l) {
-			QString part = line.mid(pos, l);
-			if (rp.indexIn(part) == 0) {
-				QStringList l = rp.capturedTexts();
-				add(std::make_unique<Symbol>(l.at(1), l.last().toInt(nullptr, 16), source));
-			}
-		}
-	}
-	return true;
+	return sourceLines.file(line.file);
 }
 
 void SymbolTable::fileChanged(const QString& path)
@@ -548,51 +739,115 @@ void SymbolTable::fileChanged(const QString& path)
 
 void SymbolTable::reloadFiles()
 {
-	for (int i = 0; i < symbolFiles.size(); ++i) {
+	SymbolChanges changes;
+	bool linesChanged = false;
+	for (auto& file : symbolFiles) {
 		// check if file is newer
-		QFileInfo fi = QFileInfo(symbolFiles[i].fileName);
-		if (fi.lastModified() <= symbolFiles[i].refreshTime) continue;
-
-		// file info
-		QString name = symbolFiles[i].fileName;
-		FileType type = symbolFiles[i].fileType;
-		// symbol file is newer
-		QMap<QString, Symbol> symCopy;
-		// copy all symbols originating from this file
-		for (const auto& s : symbols) {
-			if (s->source() == &symbolFiles[i].fileName) {
-				symCopy.insert(s->text(), Symbol(*s));
+		QFileInfo fi = QFileInfo(file.fileName);
+		if (fi.lastModified() <= file.refreshTime) continue;
+		if (file.fileType == SLD_FILE) {
+			file.refreshTime = QDateTime::currentDateTime();
+			linesChanged = true;
+			continue;
+		}
+
+		// keep the symbols when the file can't be read, e.g. while the
+		// assembler is writing it
+		auto parsed = parseSymbolFile(file.fileName, *parserFormat(file.fileType));
+		if (!parsed) continue;
+		file.refreshTime = QDateTime::currentDateTime();
+		reloadSymbols(&file.fileName, *parsed, changes);
+	}
+	if (linesChanged) readSourceLines();
+	if (!changes.isEmpty()) {
+		std::sort(changes.values.begin(), changes.values.end());
+		changes.values.erase(std::unique(changes.values.begin(), changes.values.end()),
+		                     changes.values.end());
+		emit symbolsReloaded(changes);
+	}
+}
+
+// Applies the differences between the symbols of a file and the new contents
+// of that file. Symbols are matched on name, so their settings are kept.
+void SymbolTable::reloadSymbols(const QString* source,
+	const ParsedSymbols& parsed, SymbolChanges& changes)
+{
+	QMultiHash<QString, Symbol*> previous;
+	forEachSymbol([&](Symbol* s) {
+		if (s->source() == source) previous.insert(s->text(), s);
+	});
+	// Changing the orders and indexes one symbol at a time only pays off
+	// for a few, after that they are sorted and rebuilt once.
+	static const int MAX_INDEX_UPDATES = 64;
+	int numChanges = changes.added.size() + changes.removed.size() + changes.changed.size();
+	bool bulk = false;
+	auto changed = [&] {
+		if (++numChanges > MAX_INDEX_UPDATES && !bulk) {
+			invalidateIndexes();
+			bulk = true;
+		}
+	};
+
+	for (const auto& entry : parsed.entries) {
+		auto name = QString::fromUtf8(parsed.name(entry).data(), int(entry.nameLength));
+		int value = entry.value;
+		// prefer a symbol with the same value when the name is used twice
+		auto match = previous.find(name);
+		for (auto it = match; it != previous.end() && it.key() == name; ++it) {
+			if ((*it)->value() == value) {
+				match = it;
+				break;
 			}
 		}
-		// remove existing file
-		unloadFile(name);
-		// read the new file
-		readFile(name, type);
-		// find old symbols in newly loaded file
-		QString* newFile = &symbolFiles.back().fileName;
-		for (auto& s : symbols) {
-			if (s->source() != newFile) continue;
-
-			// find symbol in old list
-			auto sit = symCopy.find(s->text());
-			if (sit == symCopy.end()) continue;
-
-			// symbol existed before, copy settings
-			s->setValidSlots(sit->validSlots());
-			s->setValidRegisters(sit->validRegisters());
-			s->setType(sit->type());
-			s->setStatus((sit->status() == Symbol::LOST) ? Symbol::ACTIVE : sit->status());
-			symCopy.erase(sit);
+		if (match == previous.end()) {
+			changed();
+			changes.added << name;
+			changes.values.push_back(value);
+			auto* sym = allocate(source, value);
+			setName(sym, name);
+			mapSymbol(sym);
+			updateIndex(sym, value);
+			if (nameIndexValid) nameIndex.insert(sym);
+			continue;
+		}
+		Symbol* sym = *match;
+		previous.erase(match);
+		if (sym->status() == Symbol::LOST) {
+			sym->setStatus(Symbol::ACTIVE);
+			changes.added << name;
+			changes.values.push_back(value);
 		}
-		if (Settings::get().preserveLostSymbols()) {
-			// all symbols left in map are lost
-			for (auto sit = symCopy.begin(); sit != symCopy.end(); ++sit) {
-				auto* sym = add(std::make_unique<Symbol>(sit.value()));
-				sym->setStatus(Symbol::LOST);
-				sym->setSource(newFile);
+		if (sym->value() != value) {
+			changed();
+			changes.changed << name;
+			changes.values.push_back(sym->value());
+			changes.values.push_back(value);
+			if (bulk) {
+				sym->symValue = value;
+				addressSorted = valueSorted = 0;
+			} else {
+				sym->setValue(value);
 			}
 		}
 	}
+
+	// what's left was removed from the file
+	bool removed = false;
+	bool preserve = Settings::get().preserveLostSymbols();
+	for (auto* sym : previous) {
+		if (sym->status() == Symbol::LOST) continue;
+		changed();
+		changes.removed << sym->text();
+		changes.values.push_back(sym->value());
+		if (preserve) {
+			sym->setStatus(Symbol::LOST);
+		} else {
+			release(sym);
+			removed = true;
+		}
+	}
+	// no symbols were allocated since, so no slot was reused yet
+	if (removed) dropReleased();
 }
 
 void SymbolTable::unloadFile(const QString& file, bool keepSymbols)
@@ -607,36 +862,30 @@ void SymbolTable::unloadFile(const QString& file, bool keepSymbols)
 	if (index >= 0) {
 		QString* name = &symbolFiles[index].fileName;
 
-		if (!keepSymbols) {
-			// remove symbols from address map
-			QMutableMapIterator<int, Symbol*> mi(addressSymbols);
-			while (mi.hasNext()) {
-				mi.next();
-				if (mi.value()->source() == name) mi.remove();
-			}
-			// remove symbols from value hash
-			QMutableHashIterator<int, Symbol*> hi(valueSymbols);
-			while (hi.hasNext()) {
-				hi.next();
-				if (hi.value()->source() == name) hi.remove();
+		// rebuilding the indexes once is cheaper than removing the
+		// symbols one at a time
+		invalidateIndexes();
+		nameIndex.clear();
+		nameIndexValid = false;
+		bool removed = false;
+		forEachSymbol([&](Symbol* sym) {
+			if (sym->source() != name) {
+				return; // keep symbols from different source
 			}
-		}
-		// remove symbols from value hash
-		symbols.erase(std::remove_if(symbols.begin(), symbols.end(),
-			[&](auto& sym) {
-				if (sym->source() != name) {
-					return false; // keep symbols from different source
-				}
-				if (!keepSymbols) {
-					return true; // remove
-				}
+			if (!keepSymbols) {
+				release(sym);
+				removed = true;
+			} else {
 				// keep but clear source
 				sym->setSource(nullptr);
-				return false; // keep
-			}), symbols.end());
+			}
+		});
+		if (removed) dropReleased();
 		// remove record
+		bool sld = symbolFiles[index].fileType == SLD_FILE;
 		fileWatcher.removePath(symbolFiles[index].fileName);
 		symbolFiles.removeAt(index);
+		if (sld) readSourceLines();
 	}
 }
 
@@ -665,6 +914,9 @@ void SymbolTable::saveSymbols(QXmlStreamWriter& xml)
 		case LINKMAP_FILE:
 			xml.writeAttribute("type","linkmap");
 			break;
+		case SLD_FILE:
+			xml.writeAttribute("type","sld");
+			break;
 		default:
 			break;
 		}
@@ -674,8 +926,8 @@ void SymbolTable::saveSymbols(QXmlStreamWriter& xml)
 		xml.writeEndElement();
 	}
 	// write symbols
-	for (const auto& sym : symbols) {
-	     	xml.writeStartElement("Symbol");
+	forEachSymbol([&](const Symbol* sym) {
+		xml.writeStartElement("Symbol");
 		// status
 		if (sym->status() == Symbol::HIDDEN) {
 			xml.writeAttribute("status", "hidden");
@@ -701,7 +953,7 @@ void SymbolTable::saveSymbols(QXmlStreamWriter& xml)
 		}
 		// complete
 		xml.writeEndElement();
-	}
+	});
 }
 
 void SymbolTable::loadSymbols(QXmlStreamReader& xml)
@@ -727,15 +979,19 @@ void SymbolTable::loadSymbols(QXmlStreamReader& xml)
 					type = ASMSX_FILE;
 				} else if (ftype == "linkmap") {
 					type = LINKMAP_FILE;
+				} else if (ftype == "sld") {
+					type = SLD_FILE;
 				}
 				// append file
 				appendFile(fname, type);
 				// change time
 				symbolFiles.back().refreshTime.setTime_t(rtime.toUInt());
+				// the lines aren't in the session
+				if (type == SLD_FILE) readSourceLines();
 
 			} else if (xml.name() == "Symbol") {
 				// add empty symbol
-				sym = add(std::make_unique<Symbol>("", 0));
+				sym = add("", 0);
 				// get status attribute
 				QString stat = xml.attributes().value("status").toString().toLower();
 				if (stat == "hidden") {
@@ -783,33 +1039,111 @@ void SymbolTable::loadSymbols(QXmlStreamReader& xml)
 }
 
 
+// class AddressSymbolIndex
+
+int AddressSymbolIndex::lowerBound(int addr) const
+{
+	return std::lower_bound(addresses.begin(), addresses.end(), addr) - addresses.begin();
+}
+
+int AddressSymbolIndex::find(int addr) const
+{
+	int pos = lowerBound(addr);
+	return (pos < size() && addresses[pos] == addr) ? pos : NOT_FOUND;
+}
+
+void AddressSymbolIndex::clear()
+{
+	addresses.clear();
+	symbols.clear();
+	names.clear();
+}
+
+void AddressSymbolIndex::append(Symbol* symbol)
+{
+	addresses.push_back(symbol->value());
+	symbols.push_back(symbol);
+}
+
+void AddressSymbolIndex::add(uint16_t address, std::string name)
+{
+	assert(addresses.empty() || addresses.back() <= address);
+	addresses.push_back(address);
+	names.push_back(std::move(name));
+	symbols.push_back(nullptr);
+}
+
+void AddressSymbolIndex::insert(Symbol* symbol)
+{
+	// in front of any existing symbols at the same address, like QMultiMap
+	int pos = lowerBound(symbol->value());
+	addresses.insert(addresses.begin() + pos, symbol->value());
+	symbols.insert(symbols.begin() + pos, symbol);
+}
+
+void AddressSymbolIndex::erase(Symbol* symbol, int value)
+{
+	for (int pos = lowerBound(value); pos < size() && addresses[pos] == value; ++pos) {
+		if (symbols[pos] == symbol) {
+			addresses.erase(addresses.begin() + pos);
+			symbols.erase(symbols.begin() + pos);
+			return;
+		}
+	}
+}
+
+
+// struct SymbolChanges
+
+bool SymbolChanges::contains(const QString& name) const
+{
+	return added.contains(name) || removed.contains(name) || changed.contains(name);
+}
+
+bool SymbolChanges::affects(int first, int last) const
+{
+	auto it = std::lower_bound(values.begin(), values.end(), first);
+	return it != values.end() && *it <= last;
+}
+
+
 // class Symbol
 
-Symbol::Symbol(QString str, int addr, const QString* source)
-	: symText(std::move(str)), symValue(addr), symSource(source)
+QString Symbol::text() const
 {
-	symRegisters = (addr & 0xFF00) ? REG_ALL16 : REG_ALL;
+	auto n = name();
+	return QString::fromUtf8(n.data(), int(n.size()));
 }
 
-Symbol::Symbol(const Symbol& symbol)
+std::string_view Symbol::name() const
 {
-	table = nullptr;
-	symStatus    = symbol.symStatus;
-	symText      = symbol.symText;
-	symValue     = symbol.symValue;
-	symSlots     = symbol.symSlots;
-	//symSegments  = symbol.symSegments;
-	symRegisters = symbol.symRegisters;
-	symSource    = symbol.symSource;
-	symType      = symbol.symType;
+	if (!table) return {};
+	return std::string_view(table->names).substr(nameOffset, nameLength);
 }
 
 void Symbol::setValue(int addr)
 {
 	if (addr == symValue) return;
 
+	int oldValue = symValue;
 	symValue = addr;
-	if (table) table->symbolValueChanged(this);
+	if (table) table->symbolValueChanged(this, oldValue);
+}
+
+void Symbol::setText(const QString& str)
+{
+	if (!table || str == text()) return;
+
+	table->setName(this, str);
+	table->symbolTextChanged(this);
+}
+
+void Symbol::setValidSlots(uint16_t val)
+{
+	if (val == symSlots) return;
+
+	symSlots = val;
+	if (table) table->symbolSlotsChanged(this);
 }
 
 void Symbol::setValidRegisters(int regs)
@@ -824,8 +1158,9 @@ void Symbol::setType(SymbolType t)
 {
 	if (symType == t) return;
 
+	auto oldType = type();
 	symType = t;
-	if (table) table->symbolTypeChanged(this);
+	if (table) table->symbolTypeChanged(this, oldType);
 }
 
 bool Symbol::isSlotValid(const MemoryLayout* ml) const
@@ -834,7 +1169,7 @@ bool Symbol::isSlotValid(const MemoryLayout* ml) const
 	int page = symValue >> 14;
 	int ps = ml->primarySlot[page] & 3;
 	int ss = 0;
-	if (ml->isSubslotted[page]) ss = ml->secondarySlot[page] & 3;
+	if (ml->isSubslotted[ps]) ss = ml->secondarySlot[page] & 3;
 	if (symSlots & (1 << (4 * ps + ss))) {
 		return true;
 		//if (symSegments.empty()) return true;
@@ -1,27 +1,34 @@
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
 
+#include "SourceLineIndex.h"
+#include "SymbolNameIndex.h"
 #include <QString>
+#include <QStringList>
 #include <QList>
-#include <QMultiMap>
-#include <QMultiHash>
 #include <QDateTime>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QFileSystemWatcher>
+#include <array>
 #include <cstdint>
-#include <memory>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 struct MemoryLayout;
+struct ParsedSymbols;
 class SymbolTable;
 
+// Symbols only exist inside a SymbolTable, which also stores their names.
 class Symbol
 {
 public:
-	Symbol(QString str, int addr, const QString* source = nullptr);
-	Symbol(const Symbol& symbol);
-	Symbol& operator=(const Symbol&) = default;
+	Symbol() = default;
+	Symbol(const Symbol&) = delete;
+	Symbol& operator=(const Symbol&) = delete;
 
 	// ACTIVE status is for regular symbols. HIDDEN is for symbols
 	// that are in the list but not shown anywhere. LOST is a special
@@ -42,36 +49,96 @@ public:
 	                REG_ALL16 = REG_BC | REG_DE | REG_HL | REG_IX | REG_IY,
 	                REG_ALL = REG_ALL8 | REG_ALL16 };
 
-	[[nodiscard]] const QString& text() const { return symText; }
-	void setText(const QString& str) { symText = str; }
+	[[nodiscard]] QString text() const;
+	// the name in UTF-8, until the next change of the table
+	[[nodiscard]] std::string_view name() const;
+	void setText(const QString& str);
 	[[nodiscard]] int value() const { return symValue; }
 	void setValue(int addr);
 	[[nodiscard]] uint16_t validSlots() const { return symSlots; }
-	void setValidSlots(uint16_t val) { symSlots = val; }
+	void setValidSlots(uint16_t val);
 	[[nodiscard]] int validRegisters() const { return symRegisters; }
 	void setValidRegisters(int regs);
 	[[nodiscard]] const QString* source() const { return symSource; }
 	void setSource(const QString* name) { symSource = name; }
-	[[nodiscard]] SymbolStatus status() const { return symStatus; }
+	[[nodiscard]] SymbolStatus status() const { return SymbolStatus(symStatus); }
 	void setStatus(SymbolStatus s) { symStatus = s; }
-	[[nodiscard]] SymbolType type() const { return symType; }
+	[[nodiscard]] SymbolType type() const { return SymbolType(symType); }
 	void setType(SymbolType t);
 
 	bool isSlotValid(const MemoryLayout* ml = nullptr) const;
 
 private:
-	SymbolTable* table = nullptr;
-
-	QString symText;
-	int symValue;
+	SymbolTable* table = nullptr; // nullptr while the slot is free
+	const QString* symSource = nullptr;
+	uint32_t symId = 0; // position in the table
+	uint32_t nameOffset = 0; // in the names of the table
+	uint32_t nameLength = 0;
+	int symValue = 0;
+	int symRegisters = REG_ALL;
 	uint16_t symSlots = 0xffff;
 	//QList<uint8_t> symSegments;
-	int symRegisters;
-	const QString* symSource = nullptr;
-	SymbolStatus symStatus = ACTIVE;
-	SymbolType symType = JUMPLABEL;
+	uint8_t symStatus = ACTIVE;
+	uint8_t symType = JUMPLABEL;
 
 	friend class SymbolTable;
+	friend class SymbolNameIndex;
+};
+
+
+// Flat view of the address symbols that are valid in one memory layout,
+// sorted on address. The names are the UTF-8 ones of the symbol table, so
+// the disassembler can resolve operands without touching any QString.
+class AddressSymbolIndex
+{
+public:
+	static constexpr int NOT_FOUND = -1;
+
+	[[nodiscard]] int size() const { return int(addresses.size()); }
+	[[nodiscard]] uint16_t address(int pos) const { return addresses[pos]; }
+	// valid until the next change of the symbol table
+	[[nodiscard]] std::string_view name(int pos) const {
+		return symbols[pos] ? symbols[pos]->name() : std::string_view(names[pos]);
+	}
+	[[nodiscard]] Symbol* symbol(int pos) const { return symbols[pos]; }
+
+	// position of the first symbol with an address of at least 'addr'
+	[[nodiscard]] int lowerBound(int addr) const;
+	// position of the first symbol at address 'addr', or NOT_FOUND
+	[[nodiscard]] int find(int addr) const;
+
+	// Append a symbol that doesn't belong to a symbol table, to build a
+	// derived index. Symbols must be added in address order.
+	void add(uint16_t address, std::string name);
+
+private:
+	void clear();
+	void append(Symbol* symbol);
+	void insert(Symbol* symbol);
+	// 'value' is the address the symbol was indexed at
+	void erase(Symbol* symbol, int value);
+
+	std::vector<uint16_t> addresses;
+	std::vector<Symbol*> symbols;
+	std::vector<std::string> names; // only for the symbols added with add()
+
+	friend class SymbolTable;
+};
+
+
+// The symbols that a reload of the symbol files added, removed or gave
+// another value.
+struct SymbolChanges
+{
+	QStringList added;
+	QStringList removed;
+	QStringList changed;
+	std::vector<int> values; // old and new values of all of them, sorted
+
+	[[nodiscard]] bool isEmpty() const { return values.empty(); }
+	[[nodiscard]] bool contains(const QString& name) const;
+	// any of the values is in [first, last]
+	[[nodiscard]] bool affects(int first, int last) const;
 };
 
 
@@ -90,14 +157,14 @@ public:
 		HTC_FILE,
 		NOICE_FILE,
 		PASMO_FILE,
-		VASM_FILE
+		VASM_FILE,
+		SLD_FILE
 	};
 
 	SymbolTable();
 
-	Symbol* add(std::unique_ptr<Symbol> symbol);
-	std::unique_ptr<Symbol> removeAt(size_t index);
-	std::unique_ptr<Symbol> remove(Symbol *symbol);
+	Symbol* add(const QString& name, int value, const QString* source = nullptr);
+	void remove(Symbol* symbol);
 	void clear();
 	[[nodiscard]] int size() const;
 
@@ -113,10 +180,24 @@ public:
 	[[nodiscard]] Symbol* getAddressSymbol(int val, MemoryLayout* ml = nullptr);
 	[[nodiscard]] Symbol* getAddressSymbol(const QString& label, bool case_sensitive = false);
 
-	[[nodiscard]] QStringList labelList(bool include_vars = false, const MemoryLayout* ml = nullptr) const;
+	[[nodiscard]] QStringList labelList(bool include_vars = false, const MemoryLayout* ml = nullptr);
+	// the labels that match 'text' best, for completion
+	[[nodiscard]] QStringList findLabels(const QString& text, int maxResults,
+	                                     bool include_vars = false, const MemoryLayout* ml = nullptr);
 
-	void symbolTypeChanged(Symbol* symbol);
-	void symbolValueChanged(Symbol* symbol);
+	// Sorted index of the address symbols valid in the given layout, it
+	// is rebuilt when the slot selection changed since the previous call.
+	[[nodiscard]] const AddressSymbolIndex& addressIndex(const MemoryLayout* ml = nullptr);
+
+	// The source line of the code at 'address', from the SLD files. The
+	// mapper segment in the layout selects the page.
+	[[nodiscard]] const SourceLineIndex::Line* sourceLine(int address, const MemoryLayout* ml = nullptr) const;
+	[[nodiscard]] const std::string& sourceFile(const SourceLineIndex::Line& line) const;
+
+	void symbolTypeChanged(Symbol* symbol, Symbol::SymbolType oldType);
+	void symbolValueChanged(Symbol* symbol, int oldValue);
+	void symbolTextChanged(Symbol* symbol);
+	void symbolSlotsChanged(Symbol* symbol);
 
 	[[nodiscard]] int symbolFilesSize() const;
 	[[nodiscard]] const QString& symbolFile(int index) const;
@@ -128,11 +209,15 @@ public:
 
 signals:
 	void symbolFileChanged();
+	// emitted once by reloadFiles() when it changed any symbols
+	void symbolsReloaded(const SymbolChanges& changes);
+	void sourceLinesChanged();
 
 private:
 	void appendFile(const QString& file, FileType type);
-	bool readSymbolFile(
-		const QString& filename, FileType type, const QString& equ);
+	bool readSymbolFile(const QString& filename, FileType type);
+	void reloadSymbols(const QString* source,
+		const ParsedSymbols& parsed, SymbolChanges& changes);
 	bool readOMDSFile(const QString& filename);
 	bool readTNIASM0File(const QString& filename);
 	bool readTNIASM1File(const QString& filename);
@@ -143,17 +228,67 @@ private:
 	bool readLinkMapFile(const QString& filename);
 	bool readPASMOFile(const QString& filename);
 	bool readVASMFile(const QString& filename);
+	bool readSLDFile(const QString& filename);
+	void readSourceLines();
 
+	Symbol* allocate(const QString* source, int value);
+	void release(Symbol* symbol);
+	void setName(Symbol* symbol, const QString& name);
+	void setName(Symbol* symbol, std::string_view name);
+	void compactNames();
+	[[nodiscard]] uint32_t id(const Symbol* symbol) const;
+	template<typename F> void forEachSymbol(F f);
+
+	void sortOrders() const;
+	void dropReleased();
 	void mapSymbol(Symbol* symbol);
-	void unmapSymbol(Symbol* symbol);
+	void unmapSymbol(Symbol* symbol, int value, Symbol::SymbolType type);
+	[[nodiscard]] static bool isIndexed(const Symbol* symbol, const std::array<int8_t, 4>& pageSlots);
+	void invalidateIndexes();
+	[[nodiscard]] const SymbolNameIndex& nameLookup();
+	void updateIndex(Symbol* symbol, int oldValue);
 
 	void fileChanged(const QString & path);
 
 private:
-	std::vector<std::unique_ptr<Symbol>> symbols;
-	QMultiMap<int, Symbol*> addressSymbols;
-	QMultiHash<int, Symbol*> valueSymbols;
-	QMultiMap<int, Symbol*>::iterator currentAddress;
+	// All symbols, a symbol's id is its position. Symbols don't move,
+	// the slots of removed ones are reused.
+	std::deque<Symbol> store;
+	std::vector<uint32_t> freeIds;
+	int numSymbols = 0;
+	// the names of all symbols, in UTF-8, renamed and removed symbols leave
+	// unused bytes until the names are compacted
+	std::string names;
+	size_t unusedNameBytes = 0;
+
+	// The ids of the symbols that aren't values, and of the ones that
+	// aren't jump labels, sorted on value and then on descending id, so
+	// symbols that were loaded later come first. Additions are appended
+	// and sorted in on the next lookup.
+	mutable std::vector<uint32_t> addressOrder;
+	mutable std::vector<uint32_t> valueOrder;
+	mutable size_t addressSorted = 0;
+	mutable size_t valueSorted = 0;
+	size_t currentAddress = 0; // position in addressOrder
+
+	// The address indexes of the last few layouts that were asked for, so
+	// switching between e.g. the current layout and no layout doesn't
+	// rebuild them. They are kept up to date with single changes.
+	struct LayoutIndex {
+		// slot (4 * ps + ss) per page the index was built for, -1 when unfiltered
+		std::array<int8_t, 4> pageSlots = {-1, -1, -1, -1};
+		bool valid = false;
+		unsigned lastUse = 0;
+		AddressSymbolIndex symbols;
+	};
+	static constexpr int NUM_LAYOUT_INDEXES = 4;
+	std::array<LayoutIndex, NUM_LAYOUT_INDEXES> layoutIndexes;
+	unsigned indexUses = 0;
+	// built on the first lookup by name, then kept up to date
+	SymbolNameIndex nameIndex;
+	bool nameIndexValid = false;
+	// the lines of all SLD files
+	SourceLineIndex sourceLines;
 
 	struct SymbolFileRecord {
 		QString fileName;
@@ -162,6 +297,8 @@ private:
 	};
 	QList<SymbolFileRecord> symbolFiles;
 	QFileSystemWatcher fileWatcher;
+
+	friend class Symbol;
 };
 
 #endif // SYMBOLTABLE_H
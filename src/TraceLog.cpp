@@ -0,0 +1,137 @@
+#include "TraceLog.h"
+#include "DebuggerData.h"
+#include "Convert.h"
+#include <QStringList>
+#include <iterator>
+#include <vector>
+
+TraceLog::TraceLog(QObject* parent)
+	: QAbstractTableModel(parent)
+{
+}
+
+void TraceLog::setBreakpoints(const Breakpoints* bps)
+{
+	breakpoints = bps;
+}
+
+QString TraceLog::tracepointName(int tag)
+{
+	auto it = names.find(tag);
+	if (it != names.end()) return *it;
+
+	for (int i = 0; breakpoints && i < breakpoints->breakpointCount(); ++i) {
+		const auto& bp = breakpoints->getBreakpoint(i);
+		if (bp.traceTag != tag || bp.trace.isEmpty()) continue;
+		QString name = bp.id;
+		if (bp.range) {
+			name += ' ' + hexValue(bp.range->start, 4);
+			if (bp.range->end) name += ':' + hexValue(*bp.range->end, 4);
+		}
+		// kept after the tracepoint is removed
+		names.insert(tag, name);
+		return name;
+	}
+	return QString("#%1").arg(tag);
+}
+
+QHash<int, unsigned> TraceLog::addFetched(const QString& reply)
+{
+	// the total number of records, the hit counts and then one record
+	// '<sequence> <time> <tag> <values>' per line
+	QStringList lines = reply.split('\n');
+	QHash<int, unsigned> hits;
+	if (lines.size() < 2) return hits;
+
+	bool ok;
+	uint64_t count = lines[0].trimmed().toULongLong(&ok);
+	if (!ok) return hits;
+	QStringList counts = lines[1].split(' ', Qt::SplitBehaviorFlags::SkipEmptyParts);
+	for (int i = 0; i + 1 < counts.size(); i += 2) {
+		hits.insert(counts[i].toInt(), counts[i + 1].toUInt());
+	}
+	if (count < next) {
+		// openMSX was restarted, fetch from the start next time
+		next = 0;
+		return hits;
+	}
+
+	std::vector<Record> fetched;
+	fetched.reserve(lines.size() - 2);
+	uint64_t lostBefore = lost;
+	for (int i = 2; i < lines.size(); ++i) {
+		QStringList fields = lines[i].split(' ');
+		if (fields.size() < 3) continue;
+		uint64_t sequence = fields[0].toULongLong(&ok);
+		if (!ok || sequence < next) continue;
+		// the ring buffer overwrote the ones in between
+		lost += sequence - next;
+		next = sequence + 1;
+		fetched.push_back({fields[1].toDouble(), tracepointName(fields[2].toInt()),
+		                   lines[i].section(' ', 3)});
+	}
+	if (lost != lostBefore) emit lostRecordsChanged(lost);
+	if (fetched.empty()) return hits;
+
+	// drop the oldest ones, then add the new ones
+	if (fetched.size() > size_t(MAX_RECORDS)) {
+		fetched.erase(fetched.begin(), fetched.end() - MAX_RECORDS);
+	}
+	size_t total = records.size() + fetched.size();
+	int drop = total > size_t(MAX_RECORDS) ? int(total - MAX_RECORDS) : 0;
+	if (drop > 0) {
+		beginRemoveRows({}, 0, drop - 1);
+		records.erase(records.begin(), records.begin() + drop);
+		endRemoveRows();
+	}
+	int first = int(records.size());
+	beginInsertRows({}, first, first + int(fetched.size()) - 1);
+	records.insert(records.end(), std::make_move_iterator(fetched.begin()),
+	               std::make_move_iterator(fetched.end()));
+	endInsertRows();
+	return hits;
+}
+
+void TraceLog::clear()
+{
+	beginResetModel();
+	records.clear();
+	endResetModel();
+	if (lost) {
+		lost = 0;
+		emit lostRecordsChanged(lost);
+	}
+}
+
+int TraceLog::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : int(records.size());
+}
+
+int TraceLog::columnCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : NUM_COLUMNS;
+}
+
+QVariant TraceLog::data(const QModelIndex& index, int role) const
+{
+	if (role != Qt::DisplayRole || !index.isValid()) return {};
+	const auto& record = records[index.row()];
+	switch (index.column()) {
+		case TIME:       return QString::number(record.time, 'f', 6);
+		case TRACEPOINT: return record.tracepoint;
+		case VALUES:     return record.values;
+		default:         return {};
+	}
+}
+
+QVariant TraceLog::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (role != Qt::DisplayRole || orientation != Qt::Horizontal) return {};
+	switch (section) {
+		case TIME:       return tr("Time");
+		case TRACEPOINT: return tr("Tracepoint");
+		case VALUES:     return tr("Values");
+		default:         return {};
+	}
+}
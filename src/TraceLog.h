@@ -0,0 +1,64 @@
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QString>
+#include <cstdint>
+#include <deque>
+
+class Breakpoints;
+
+/**
+ * The records that the tracepoints logged, fetched in bulk from the ring
+ * buffer that openMSX keeps (see debug_trace_fetch). Only the most recent
+ * MAX_RECORDS are kept. As a table model, views only ask for the rows that
+ * are visible.
+ */
+class TraceLog : public QAbstractTableModel
+{
+	Q_OBJECT
+public:
+	static constexpr int MAX_RECORDS = 100000;
+	enum Column { TIME, TRACEPOINT, VALUES, NUM_COLUMNS };
+
+	TraceLog(QObject* parent = nullptr);
+
+	// to name the tracepoint of a record
+	void setBreakpoints(const Breakpoints* bps);
+
+	// the sequence number to fetch from next
+	[[nodiscard]] uint64_t nextSequence() const { return next; }
+	// records that were overwritten in openMSX before they were fetched
+	[[nodiscard]] uint64_t lostRecords() const { return lost; }
+
+	// Adds the records in a reply of debug_trace_fetch, returns the hit
+	// counts per trace tag.
+	QHash<int, unsigned> addFetched(const QString& reply);
+	void clear();
+
+	int rowCount(const QModelIndex& parent = {}) const override;
+	int columnCount(const QModelIndex& parent = {}) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation,
+	                    int role = Qt::DisplayRole) const override;
+
+signals:
+	void lostRecordsChanged(uint64_t lost);
+
+private:
+	struct Record {
+		double time; // emulated time in seconds
+		QString tracepoint;
+		QString values;
+	};
+	QString tracepointName(int tag);
+
+	std::deque<Record> records;
+	QHash<int, QString> names; // per trace tag, shared by the records
+	const Breakpoints* breakpoints = nullptr;
+	uint64_t next = 0;
+	uint64_t lost = 0;
+};
+
+#endif // TRACELOG_H
@@ -0,0 +1,57 @@
+#include "TraceViewer.h"
+#include "TraceLog.h"
+#include "Settings.h"
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QTableView>
+#include <QVBoxLayout>
+
+TraceViewer::TraceViewer(TraceLog& log, QWidget* parent)
+	: QWidget(parent), traceLog(log)
+{
+	statusLabel = new QLabel();
+	auto* clearButton = new QPushButton(tr("Clear"));
+
+	table = new QTableView();
+	table->setModel(&traceLog);
+	table->setFont(Settings::get().font(Settings::CODE_FONT));
+	table->setSelectionBehavior(QAbstractItemView::SelectRows);
+	table->setWordWrap(false);
+	// fixed row heights, so scrolling doesn't measure every row
+	table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	table->verticalHeader()->setDefaultSectionSize(table->fontMetrics().height() + 2);
+	table->verticalHeader()->hide();
+	table->horizontalHeader()->setStretchLastSection(true);
+
+	auto* hbox = new QHBoxLayout();
+	hbox->addWidget(statusLabel, 1);
+	hbox->addWidget(clearButton);
+	auto* vbox = new QVBoxLayout();
+	vbox->setMargin(0);
+	vbox->addLayout(hbox);
+	vbox->addWidget(table);
+	setLayout(vbox);
+
+	connect(clearButton, &QPushButton::clicked, &traceLog, &TraceLog::clear);
+	connect(&traceLog, &TraceLog::lostRecordsChanged, this, &TraceViewer::showLost);
+	connect(&traceLog, &TraceLog::rowsInserted, this, &TraceViewer::recordsAdded);
+	connect(table->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+		follow = value == table->verticalScrollBar()->maximum();
+	});
+	showLost(traceLog.lostRecords());
+	table->scrollToBottom();
+}
+
+void TraceViewer::showLost(uint64_t lost)
+{
+	statusLabel->setText(lost ? tr("%1 records were overwritten before they were fetched").arg(lost)
+	                          : QString());
+}
+
+void TraceViewer::recordsAdded()
+{
+	if (follow) table->scrollToBottom();
+}
@@ -0,0 +1,29 @@
+#ifndef TRACEVIEWER_H
+#define TRACEVIEWER_H
+
+#include <QWidget>
+#include <cstdint>
+
+class QLabel;
+class QTableView;
+class TraceLog;
+
+// Shows the records of the tracepoints, follows the newest ones while the
+// view is scrolled to the end.
+class TraceViewer : public QWidget
+{
+	Q_OBJECT
+public:
+	TraceViewer(TraceLog& log, QWidget* parent = nullptr);
+
+private:
+	void showLost(uint64_t lost);
+	void recordsAdded();
+
+	TraceLog& traceLog;
+	QLabel* statusLabel;
+	QTableView* table;
+	bool follow = true;
+};
+
+#endif // TRACEVIEWER_H
@@ -0,0 +1,230 @@
+#include "VramTiming.h"
+#include "CallGraph.h"
+#include <algorithm>
+
+static const uint8_t VRAM_PORT = 0x98;
+// a called routine takes at least the time of a return
+static const int RET_CYCLES = 11;
+// no access seen yet
+static const int NONE = 0x10000;
+
+namespace {
+
+enum class Io : uint8_t { NONE, PORT_98, PORT_C, REPEAT_C };
+
+struct IoInfo {
+	Io io = Io::NONE;
+	// what happens to C
+	enum Change : uint8_t { KEEP, SET, INC, DEC, UNKNOWN } change = KEEP;
+	uint8_t value = 0;
+};
+
+IoInfo decodeIo(const uint8_t* memory, uint16_t pc)
+{
+	IoInfo info;
+	uint8_t op = memory[pc];
+	uint8_t op2 = memory[uint16_t(pc + 1)];
+	switch (op) {
+	case 0xD3: // out (n),a
+	case 0xDB: // in a,(n)
+		if (op2 == VRAM_PORT) info.io = Io::PORT_98;
+		break;
+	case 0x01: // ld bc,nn
+	case 0x0E: // ld c,n
+		info.change = IoInfo::SET;
+		info.value = op2;
+		break;
+	case 0x0C:
+		info.change = IoInfo::INC;
+		break;
+	case 0x0D:
+		info.change = IoInfo::DEC;
+		break;
+	case 0x03: // inc bc
+	case 0x0B: // dec bc
+	case 0xC1: // pop bc
+	case 0xD9: // exx
+		info.change = IoInfo::UNKNOWN;
+		break;
+	case 0xCB:
+		// shifts and bit changes of c
+		if ((op2 & 7) == 1 && (op2 < 0x40 || op2 >= 0x80)) info.change = IoInfo::UNKNOWN;
+		break;
+	case 0xDD:
+	case 0xFD:
+		switch (op2) {
+		case 0x01: case 0x03: case 0x0B: case 0x0C: case 0x0D: case 0x0E:
+		case 0xC1: case 0xD9:
+			// the prefix doesn't change what these do to C
+			info.change = IoInfo::UNKNOWN;
+			break;
+		case 0xCB: {
+			// undocumented shifts and bit changes that also store in c
+			uint8_t op4 = memory[uint16_t(pc + 3)];
+			if ((op4 & 7) == 1 && (op4 < 0x40 || op4 >= 0x80)) info.change = IoInfo::UNKNOWN;
+			break;
+		}
+		default:
+			// ld c,r  ld c,ixh  ld c,ixl  ld c,(ix+d)
+			if ((op2 & 0xF8) == 0x48 && op2 != 0x49) info.change = IoInfo::UNKNOWN;
+			break;
+		}
+		break;
+	case 0xED:
+		if ((op2 & 0xC6) == 0x40) { // in r,(c)  out (c),r
+			info.io = Io::PORT_C;
+			if (op2 == 0x48) info.change = IoInfo::UNKNOWN;
+		} else if (op2 == 0x4B) { // ld bc,(nn)
+			info.change = IoInfo::UNKNOWN;
+		} else if ((op2 & 0xE6) == 0xA0) { // ldi  cpi  ldd  cpd  ldir  cpir  lddr  cpdr
+			info.change = IoInfo::UNKNOWN;
+		} else if ((op2 & 0xF6) == 0xA2) { // ini  outi  ind  outd
+			info.io = Io::PORT_C;
+		} else if ((op2 & 0xF6) == 0xB2) { // inir  otir  indr  otdr
+			info.io = Io::REPEAT_C;
+		}
+		break;
+	default:
+		if ((op & 0xF8) == 0x48 && op != 0x49) info.change = IoInfo::UNKNOWN; // ld c,r
+		break;
+	}
+	return info;
+}
+
+} // namespace
+
+void VramTiming::analyze(const uint8_t* memory, const CallGraph& graph)
+{
+	results.clear();
+	total = 0;
+
+	std::vector<IoInfo> io(0x10000);
+	std::vector<int> best(0x10000, MAX_CYCLES + 1);
+	std::vector<uint16_t> bestFrom(0x10000);
+	std::vector<bool> isAccess(0x10000, false);
+	auto record = [&](uint16_t addr, uint16_t from, int cycles) {
+		if (cycles < best[addr]) {
+			best[addr] = cycles;
+			bestFrom[addr] = from;
+		}
+	};
+
+	// per address, for the routine that is being analyzed
+	struct State {
+		int cycles;    // since the last access, or NONE
+		uint16_t from; // the last access
+		int c;         // value of C, or -1
+	};
+	std::vector<int> routineOf(0x10000, -1);
+	std::vector<int> seen(0x10000, -1);
+	std::vector<State> state(0x10000);
+	std::vector<uint16_t> work;
+
+	const auto& routines = graph.routines();
+	for (int idx = 0; idx < int(routines.size()); ++idx) {
+		const auto& r = routines[idx];
+		for (uint16_t addr : r.code) {
+			routineOf[addr] = idx;
+			io[addr] = decodeIo(memory, addr);
+		}
+
+		auto propagate = [&](uint16_t to, State s) {
+			if (routineOf[to] != idx) return; // tail call
+			if (seen[to] != idx) {
+				seen[to] = idx;
+				state[to] = s;
+				work.push_back(to);
+				return;
+			}
+			State& old = state[to];
+			bool changed = false;
+			if (s.cycles < old.cycles) {
+				old.cycles = s.cycles;
+				old.from = s.from;
+				changed = true;
+			}
+			if (old.c != s.c && old.c != -1) {
+				old.c = -1;
+				changed = true;
+			}
+			if (changed) work.push_back(to);
+		};
+
+		propagate(r.entry, {NONE, 0, -1});
+		while (!work.empty()) {
+			uint16_t pc = work.back();
+			work.pop_back();
+			State in = state[pc];
+			const auto& step = graph.step(pc);
+			const auto& info = io[pc];
+
+			bool access = info.io == Io::PORT_98 ||
+			              (info.io != Io::NONE && in.c == VRAM_PORT);
+			State out = in;
+			if (access) {
+				isAccess[pc] = true;
+				if (in.cycles != NONE) {
+					record(pc, in.from, in.cycles + step.cyclesNotTaken);
+				}
+				if (info.io == Io::REPEAT_C) {
+					record(pc, pc, step.cycles);
+				}
+				// the access is at the end of the instruction
+				out.cycles = 0;
+				out.from = pc;
+			}
+			switch (info.change) {
+			case IoInfo::SET:     out.c = info.value; break;
+			case IoInfo::INC:     if (out.c >= 0) out.c = (out.c + 1) & 0xFF; break;
+			case IoInfo::DEC:     if (out.c >= 0) out.c = (out.c - 1) & 0xFF; break;
+			case IoInfo::UNKNOWN: out.c = -1; break;
+			case IoInfo::KEEP:    break;
+			}
+
+			auto follow = [&](uint16_t to, int cycles) {
+				State s = out;
+				if (!access && s.cycles != NONE) {
+					s.cycles = std::min(s.cycles + cycles, MAX_CYCLES + 1);
+				}
+				propagate(to, s);
+			};
+			uint16_t next = pc + step.length;
+			using Kind = CallGraph::Kind;
+			switch (step.kind) {
+			case Kind::NEXT:
+			case Kind::LOAD_SP:
+				follow(next, step.cyclesNotTaken);
+				break;
+			case Kind::RET_CC:
+				follow(next, step.cyclesNotTaken);
+				break;
+			case Kind::JUMP:
+				follow(step.target, step.cycles);
+				break;
+			case Kind::BRANCH:
+				follow(step.target, step.cycles);
+				follow(next, step.cyclesNotTaken);
+				break;
+			case Kind::CALL:
+				// the called routine may change C, a conditional call
+				// is the fastest when it's not taken
+				out.c = -1;
+				follow(next, step.cycles == step.cyclesNotTaken ? step.cycles + RET_CYCLES
+				                                                : step.cyclesNotTaken);
+				break;
+			case Kind::RET:
+			case Kind::INDIRECT:
+				break;
+			}
+		}
+	}
+
+	for (int addr = 0; addr < 0x10000; ++addr) {
+		if (!isAccess[addr]) continue;
+		++total;
+		if (best[addr] <= MAX_CYCLES) {
+			results.push_back({uint16_t(addr), bestFrom[addr], best[addr],
+			                   dasmInstruction(memory, uint16_t(addr))});
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef VRAMTIMING_H
+#define VRAMTIMING_H
+
+#include "Dasm.h"
+#include <vector>
+#include <stdint.h>
+
+class CallGraph;
+
+/**
+ * The shortest time between two accesses of the VRAM through the VDP data
+ * port #98 in the analyzed code. The VDP of an MSX1 drops accesses that
+ * follow each other too quickly during the active display, so accesses
+ * that are closer than the interval of the VDP are worth a look.
+ *
+ * Within every routine the T-states since the last access are followed
+ * along all paths, the shortest one is kept. out (#98),a and in a,(#98)
+ * are accesses, and so are out (c),r, in r,(c) and the block I/O
+ * instructions when C is known to hold #98. A call counts as the call and
+ * a return, accesses in the called routine are not seen. When the
+ * routine is entered the time since the last access is unknown.
+ */
+class VramTiming
+{
+public:
+	struct Access {
+		uint16_t addr;
+		uint16_t previous; // the access before, the same one for otir, inir, ...
+		int cycles;        // T-states since the previous access
+		DisasmRow instruction;
+	};
+	// times above this are not kept
+	static constexpr int MAX_CYCLES = 255;
+
+	// 'memory' is the one that 'graph' was built from
+	void analyze(const uint8_t* memory, const CallGraph& graph);
+
+	// the accesses that follow another within MAX_CYCLES, in address order
+	[[nodiscard]] const std::vector<Access>& accesses() const { return results; }
+	// all accesses found, also the ones without a previous access
+	[[nodiscard]] int numAccesses() const { return total; }
+
+private:
+	std::vector<Access> results;
+	int total = 0;
+};
+
+#endif // VRAMTIMING_H
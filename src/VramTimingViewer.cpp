@@ -0,0 +1,136 @@
+#include "VramTimingViewer.h"
+#include "SymbolTable.h"
+#include "Convert.h"
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+// the shortest safe time between VRAM accesses during the active display,
+// in T-states of a 3.58MHz Z80 including the M1 wait states of the MSX
+struct VdpInterval {
+	const char* name;
+	int cycles;
+};
+static const VdpInterval vdpIntervals[] = {
+	{"TMS9918/TMS9928 (MSX1)", 29},
+	{"V9938 (MSX2)", 15},
+	{"V9958 (MSX2+)", 15},
+};
+
+VramTimingViewer::VramTimingViewer(QWidget* parent)
+	: QWidget(parent)
+{
+	vdpList = new QComboBox();
+	for (const auto& vdp : vdpIntervals) {
+		vdpList->addItem(vdp.name, vdp.cycles);
+	}
+	vdpList->addItem(tr("Other"), 0);
+
+	intervalSpin = new QSpinBox();
+	intervalSpin->setRange(1, VramTiming::MAX_CYCLES);
+	intervalSpin->setSuffix(tr(" T"));
+	intervalSpin->setToolTip(tr("Shortest safe time between two VRAM accesses"));
+
+	accessList = new QTreeWidget();
+	accessList->setColumnCount(4);
+	accessList->setHeaderLabels({tr("Address"), tr("Instruction"), tr("After"), tr("T-states")});
+	accessList->setRootIsDecorated(false);
+	accessList->setUniformRowHeights(true);
+	accessList->setSortingEnabled(true);
+	accessList->sortByColumn(0, Qt::AscendingOrder);
+	accessList->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+	statusLabel = new QLabel();
+
+	auto* vdpBox = new QHBoxLayout();
+	vdpBox->addWidget(vdpList, 1);
+	vdpBox->addWidget(intervalSpin);
+
+	auto* vbox = new QVBoxLayout();
+	vbox->setMargin(0);
+	vbox->addLayout(vdpBox);
+	vbox->addWidget(accessList);
+	vbox->addWidget(statusLabel);
+	setLayout(vbox);
+
+	connect(vdpList, qOverload<int>(&QComboBox::currentIndexChanged),
+	        this, &VramTimingViewer::vdpChanged);
+	connect(intervalSpin, qOverload<int>(&QSpinBox::valueChanged),
+	        this, &VramTimingViewer::fillList);
+	connect(accessList, &QTreeWidget::itemActivated, this, &VramTimingViewer::accessActivated);
+	vdpChanged(0);
+}
+
+void VramTimingViewer::setSymbolTable(SymbolTable* st)
+{
+	symTable = st;
+}
+
+void VramTimingViewer::setMemoryLayout(MemoryLayout* ml)
+{
+	memLayout = ml;
+}
+
+void VramTimingViewer::setTiming(std::shared_ptr<const VramTiming> timing_)
+{
+	timing = std::move(timing_);
+	fillList();
+}
+
+void VramTimingViewer::vdpChanged(int index)
+{
+	int cycles = vdpList->itemData(index).toInt();
+	intervalSpin->setEnabled(cycles == 0);
+	if (cycles) {
+		intervalSpin->setValue(cycles);
+	}
+	fillList();
+}
+
+void VramTimingViewer::fillList()
+{
+	accessList->clear();
+	if (!timing || !symTable) {
+		statusLabel->setText(tr("Waiting for the code analysis"));
+		return;
+	}
+
+	const auto& symbols = symTable->addressIndex(memLayout);
+	auto address = [&](uint16_t addr) {
+		int s = symbols.find(addr);
+		if (s < 0) return hexValue(addr, 4);
+		auto name = symbols.name(s);
+		return QString::fromUtf8(name.data(), int(name.size()));
+	};
+
+	int interval = intervalSpin->value();
+	QList<QTreeWidgetItem*> items;
+	accessList->setSortingEnabled(false);
+	for (const auto& a : timing->accesses()) {
+		if (a.cycles >= interval) continue;
+		DisasmRow row = a.instruction;
+		if (row.hasAddressOperand()) row.symbol = symbols.find(row.operand);
+		auto* item = new QTreeWidgetItem({hexValue(a.addr, 4),
+		                                  QString::fromStdString(disasmText(row, symbols)).simplified(),
+		                                  a.previous == a.addr ? tr("itself") : address(a.previous)});
+		item->setData(0, Qt::UserRole, a.addr);
+		item->setData(2, Qt::UserRole, a.previous);
+		item->setData(3, Qt::DisplayRole, a.cycles);
+		items.append(item);
+	}
+	accessList->addTopLevelItems(items);
+	accessList->setSortingEnabled(true);
+	statusLabel->setText(tr("%1 of %n VRAM access(es) within %2 T-states of the previous one",
+	                        "", timing->numAccesses())
+	                     .arg(items.size()).arg(interval));
+}
+
+void VramTimingViewer::accessActivated(QTreeWidgetItem* item, int column)
+{
+	// the column of the previous access goes there
+	emit addressSelected(item->data(column == 2 ? 2 : 0, Qt::UserRole).toUInt());
+}
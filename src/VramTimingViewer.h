@@ -0,0 +1,46 @@
+#ifndef VRAMTIMINGVIEWER_H
+#define VRAMTIMINGVIEWER_H
+
+#include "VramTiming.h"
+#include <QWidget>
+#include <memory>
+
+class QComboBox;
+class QLabel;
+class QSpinBox;
+class QTreeWidget;
+class QTreeWidgetItem;
+class SymbolTable;
+struct MemoryLayout;
+
+// Lists the VRAM accesses in the analyzed code that follow each other
+// faster than the selected VDP can handle during the active display.
+class VramTimingViewer : public QWidget
+{
+	Q_OBJECT
+public:
+	VramTimingViewer(QWidget* parent = nullptr);
+
+	void setSymbolTable(SymbolTable* st);
+	void setMemoryLayout(MemoryLayout* ml);
+	void setTiming(std::shared_ptr<const VramTiming> timing);
+
+signals:
+	void addressSelected(uint16_t addr);
+
+private:
+	void vdpChanged(int index);
+	void fillList();
+	void accessActivated(QTreeWidgetItem* item, int column);
+
+	QComboBox* vdpList;
+	QSpinBox* intervalSpin;
+	QTreeWidget* accessList;
+	QLabel* statusLabel;
+
+	SymbolTable* symTable = nullptr;
+	MemoryLayout* memLayout = nullptr;
+	std::shared_ptr<const VramTiming> timing;
+};
+
+#endif // VRAMTIMINGVIEWER_H
@@ -0,0 +1,109 @@
+#include "WriteLog.h"
+#include <algorithm>
+#include <cstring>
+
+static int hexDigit(QChar c)
+{
+	ushort u = c.unicode();
+	if (u >= '0' && u <= '9') return u - '0';
+	if (u >= 'A' && u <= 'F') return u - 'A' + 10;
+	if (u >= 'a' && u <= 'f') return u - 'a' + 10;
+	return -1;
+}
+
+void WriteLog::addFetched(const QString& reply)
+{
+	// '<first sequence> <total count>' and then the records from the
+	// first sequence on, in hex, as made by 'binary format qssc'
+	int newline = reply.indexOf('\n');
+	QString header = reply.left(newline);
+	int space = header.indexOf(' ');
+	if (space < 0) return;
+	bool ok1, ok2;
+	uint64_t from = header.left(space).toULongLong(&ok1);
+	uint64_t count = header.mid(space + 1).toULongLong(&ok2);
+	if (!ok1 || !ok2) return;
+	if (count < next) {
+		// openMSX was restarted, start over
+		clear();
+		return;
+	}
+	// from is past next when openMSX dropped records before they were fetched
+	next = from;
+
+	uint8_t bytes[RECORD_SIZE];
+	int size = 0;
+	int high = -1;
+	for (int i = newline + 1; newline >= 0 && i < reply.size(); ++i) {
+		int digit = hexDigit(reply[i]);
+		if (digit < 0) continue;
+		if (high < 0) {
+			high = digit;
+			continue;
+		}
+		bytes[size++] = uint8_t(high << 4 | digit);
+		high = -1;
+		if (size < RECORD_SIZE) continue;
+		size = 0;
+
+		// all fields are little endian
+		uint64_t bits = 0;
+		for (int b = 7; b >= 0; --b) bits = bits << 8 | bytes[b];
+		Write write;
+		std::memcpy(&write.time, &bits, sizeof(write.time));
+		write.pc = uint16_t(bytes[8] | bytes[9] << 8);
+		write.address = uint16_t(bytes[10] | bytes[11] << 8);
+		write.value = bytes[12];
+		append(write);
+		++next;
+	}
+}
+
+void WriteLog::append(const Write& write)
+{
+	uint64_t sequence = first + records.size();
+	records.push_back({write, lastByAddress[write.address], lastByPC[write.pc]});
+	lastByAddress[write.address] = sequence;
+	lastByPC[write.pc] = sequence;
+
+	if (records.size() > MAX_RECORDS) {
+		// links to dropped records end at record()
+		records.pop_front();
+		++first;
+	}
+}
+
+void WriteLog::clear()
+{
+	records.clear();
+	first = 0;
+	next = 0;
+	std::fill(lastByAddress.begin(), lastByAddress.end(), NONE);
+	std::fill(lastByPC.begin(), lastByPC.end(), NONE);
+}
+
+const WriteLog::Record* WriteLog::record(uint64_t sequence) const
+{
+	if (sequence == NONE || sequence < first) return nullptr;
+	return &records[sequence - first];
+}
+
+template<typename Link>
+std::vector<WriteLog::Write> WriteLog::follow(uint64_t sequence, Link link, int maxWrites) const
+{
+	std::vector<Write> result;
+	for (const auto* r = record(sequence); r && int(result.size()) < maxWrites; r = record(r->*link)) {
+		result.push_back(r->write);
+	}
+	return result;
+}
+
+std::vector<WriteLog::Write> WriteLog::writesTo(uint16_t address, int maxWrites) const
+{
+	return follow(lastByAddress[address], &Record::prevAddress, maxWrites);
+}
+
+std::vector<WriteLog::Write> WriteLog::writesBy(uint16_t pc, int maxWrites) const
+{
+	return follow(lastByPC[pc], &Record::prevPC, maxWrites);
+}
@@ -0,0 +1,64 @@
+#ifndef WRITELOG_H
+#define WRITELOG_H
+
+#include <QString>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * The memory writes that the recording watchpoints logged, fetched in bulk
+ * from the ring buffer that openMSX keeps (see debug_write_log_fetch).
+ * Every record is linked to the previous write to the same address and
+ * the previous write by the same instruction, so the last writers of a byte
+ * or the writes of an instruction are found without searching. Only the
+ * most recent MAX_RECORDS are kept.
+ */
+class WriteLog
+{
+public:
+	static constexpr size_t MAX_RECORDS = 1 << 20;
+
+	struct Write {
+		double time; // emulated time in seconds
+		uint16_t pc;
+		uint16_t address;
+		uint8_t value;
+	};
+
+	// the sequence number to fetch from next
+	[[nodiscard]] uint64_t nextSequence() const { return next; }
+	[[nodiscard]] bool isEmpty() const { return records.empty(); }
+
+	// Adds the records in a reply of debug_write_log_fetch.
+	void addFetched(const QString& reply);
+	void clear();
+
+	// the most recent writes to 'address' and by the instruction at 'pc',
+	// newest first
+	[[nodiscard]] std::vector<Write> writesTo(uint16_t address, int maxWrites) const;
+	[[nodiscard]] std::vector<Write> writesBy(uint16_t pc, int maxWrites) const;
+
+private:
+	static constexpr uint64_t NONE = ~uint64_t(0);
+	static constexpr int RECORD_SIZE = 13; // time, pc, address, value
+
+	struct Record {
+		Write write;
+		uint64_t prevAddress; // sequence of the previous write to the address
+		uint64_t prevPC;      // sequence of the previous write by the pc
+	};
+	[[nodiscard]] const Record* record(uint64_t sequence) const;
+	void append(const Write& write);
+	template<typename Link>
+	std::vector<Write> follow(uint64_t sequence, Link link, int maxWrites) const;
+
+	std::deque<Record> records;
+	uint64_t first = 0; // sequence of records.front()
+	uint64_t next = 0;
+	// per address and per pc, the sequence of the last write, or NONE
+	std::vector<uint64_t> lastByAddress = std::vector<uint64_t>(0x10000, NONE);
+	std::vector<uint64_t> lastByPC = std::vector<uint64_t>(0x10000, NONE);
+};
+
+#endif // WRITELOG_H
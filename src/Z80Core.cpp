@@ -0,0 +1,811 @@
+#include "Z80Core.h"
+#include "DasmTables.h"
+
+namespace {
+
+// S, Z, Y and X flags of a result, and the same with the parity flag
+struct FlagTables {
+	uint8_t sz53[256];
+	uint8_t sz53p[256];
+
+	FlagTables()
+	{
+		for (int i = 0; i < 256; ++i) {
+			sz53[i] = (i & (Z80Core::SF | Z80Core::YF | Z80Core::XF)) | (i ? 0 : Z80Core::ZF);
+			int bits = 0;
+			for (int b = 0; b < 8; ++b) bits += (i >> b) & 1;
+			sz53p[i] = sz53[i] | ((bits & 1) ? 0 : Z80Core::PF);
+		}
+	}
+};
+const FlagTables tables;
+
+}
+
+Z80Core::Z80Core(uint8_t* memory)
+	: mem(memory)
+{
+	regs.af = regs.sp = 0xFFFF;
+}
+
+uint8_t Z80Core::fetchOpcode()
+{
+	regs.r = (regs.r & 0x80) | ((regs.r + 1) & 0x7F);
+	return fetch();
+}
+
+uint16_t Z80Core::fetch16()
+{
+	uint16_t v = mem[regs.pc] | (mem[uint16_t(regs.pc + 1)] << 8);
+	regs.pc += 2;
+	return v;
+}
+
+uint16_t Z80Core::read16(uint16_t addr) const
+{
+	return mem[addr] | (mem[uint16_t(addr + 1)] << 8);
+}
+
+void Z80Core::write(uint16_t addr, uint8_t value)
+{
+	if (!writeFilter || writeFilter(addr, value)) {
+		mem[addr] = value;
+	}
+}
+
+void Z80Core::write16(uint16_t addr, uint16_t value)
+{
+	write(addr, value & 0xFF);
+	write(addr + 1, value >> 8);
+}
+
+void Z80Core::push(uint16_t value)
+{
+	regs.sp -= 2;
+	write16(regs.sp, value);
+}
+
+uint16_t Z80Core::pop()
+{
+	uint16_t v = read16(regs.sp);
+	regs.sp += 2;
+	return v;
+}
+
+uint8_t Z80Core::in(uint16_t port)
+{
+	return readPort ? readPort(port) : 0xFF;
+}
+
+void Z80Core::out(uint16_t port, uint8_t value)
+{
+	if (writePort) writePort(port, value);
+}
+
+uint8_t Z80Core::reg8(int r, uint16_t& xy) const
+{
+	switch (r) {
+	case 0: return regs.bc >> 8;
+	case 1: return regs.bc & 0xFF;
+	case 2: return regs.de >> 8;
+	case 3: return regs.de & 0xFF;
+	case 4: return xy >> 8;
+	case 5: return xy & 0xFF;
+	case 6: return read(regs.hl);
+	default: return A();
+	}
+}
+
+void Z80Core::setReg8(int r, uint16_t& xy, uint8_t v)
+{
+	switch (r) {
+	case 0: regs.bc = (regs.bc & 0x00FF) | (v << 8); break;
+	case 1: regs.bc = (regs.bc & 0xFF00) | v; break;
+	case 2: regs.de = (regs.de & 0x00FF) | (v << 8); break;
+	case 3: regs.de = (regs.de & 0xFF00) | v; break;
+	case 4: xy = (xy & 0x00FF) | (v << 8); break;
+	case 5: xy = (xy & 0xFF00) | v; break;
+	case 6: write(regs.hl, v); break;
+	default: setA(v); break;
+	}
+}
+
+uint16_t& Z80Core::reg16(int p, uint16_t& xy)
+{
+	switch (p) {
+	case 0: return regs.bc;
+	case 1: return regs.de;
+	case 2: return xy;
+	default: return regs.sp;
+	}
+}
+
+bool Z80Core::condition(int cc) const
+{
+	static const uint8_t masks[4] = {ZF, CF, PF, SF};
+	bool set = F() & masks[cc >> 1];
+	return (cc & 1) ? set : !set;
+}
+
+void Z80Core::add8(uint8_t v, uint8_t carry)
+{
+	uint8_t a = A();
+	unsigned res = a + v + carry;
+	uint8_t r = res & 0xFF;
+	setF(tables.sz53[r] | ((res >> 8) & CF) | ((a ^ v ^ r) & HF) |
+	     ((((a ^ ~v) & (a ^ r)) >> 5) & PF));
+	setA(r);
+}
+
+void Z80Core::sub8(uint8_t v, uint8_t carry)
+{
+	uint8_t a = A();
+	unsigned res = a - v - carry;
+	uint8_t r = res & 0xFF;
+	setF(tables.sz53[r] | ((res >> 8) & CF) | NF | ((a ^ v ^ r) & HF) |
+	     ((((a ^ v) & (a ^ r)) >> 5) & PF));
+	setA(r);
+}
+
+void Z80Core::cp8(uint8_t v)
+{
+	// like sub, but X and Y come from the operand
+	uint8_t a = A();
+	sub8(v, 0);
+	setA(a);
+	setF((F() & ~(YF | XF)) | (v & (YF | XF)));
+}
+
+void Z80Core::alu(int op, uint8_t v)
+{
+	switch (op) {
+	case 0: add8(v, 0); break;
+	case 1: add8(v, F() & CF); break;
+	case 2: sub8(v, 0); break;
+	case 3: sub8(v, F() & CF); break;
+	case 4: setA(A() & v); setF(tables.sz53p[A()] | HF); break;
+	case 5: setA(A() ^ v); setF(tables.sz53p[A()]); break;
+	case 6: setA(A() | v); setF(tables.sz53p[A()]); break;
+	default: cp8(v); break;
+	}
+}
+
+uint8_t Z80Core::inc8(uint8_t v)
+{
+	uint8_t r = v + 1;
+	setF((F() & CF) | tables.sz53[r] | ((r & 0x0F) ? 0 : HF) | (r == 0x80 ? PF : 0));
+	return r;
+}
+
+uint8_t Z80Core::dec8(uint8_t v)
+{
+	uint8_t r = v - 1;
+	setF((F() & CF) | NF | tables.sz53[r] | ((v & 0x0F) ? 0 : HF) | (v == 0x80 ? PF : 0));
+	return r;
+}
+
+void Z80Core::add16(uint16_t& dest, uint16_t v)
+{
+	unsigned res = dest + v;
+	regs.memptr = dest + 1;
+	setF((F() & (SF | ZF | PF)) | ((res >> 16) & CF) |
+	     (((dest ^ v ^ res) >> 8) & HF) | ((res >> 8) & (YF | XF)));
+	dest = res & 0xFFFF;
+}
+
+void Z80Core::adc16(uint16_t v)
+{
+	uint16_t hl = regs.hl;
+	unsigned res = hl + v + (F() & CF);
+	regs.memptr = hl + 1;
+	setF(((res >> 16) & CF) | (((hl ^ v ^ res) >> 8) & HF) |
+	     ((((hl ^ ~v) & (hl ^ res)) >> 13) & PF) |
+	     ((res >> 8) & (SF | YF | XF)) | ((res & 0xFFFF) ? 0 : ZF));
+	regs.hl = res & 0xFFFF;
+}
+
+void Z80Core::sbc16(uint16_t v)
+{
+	uint16_t hl = regs.hl;
+	unsigned res = hl - v - (F() & CF);
+	regs.memptr = hl + 1;
+	setF(((res >> 16) & CF) | NF | (((hl ^ v ^ res) >> 8) & HF) |
+	     ((((hl ^ v) & (hl ^ res)) >> 13) & PF) |
+	     ((res >> 8) & (SF | YF | XF)) | ((res & 0xFFFF) ? 0 : ZF));
+	regs.hl = res & 0xFFFF;
+}
+
+uint8_t Z80Core::rotate(int op, uint8_t v)
+{
+	uint8_t r, c;
+	switch (op) {
+	case 0: c = v >> 7; r = (v << 1) | c; break;                // rlc
+	case 1: c = v & 1;  r = (v >> 1) | (c << 7); break;         // rrc
+	case 2: c = v >> 7; r = (v << 1) | (F() & CF); break;       // rl
+	case 3: c = v & 1;  r = (v >> 1) | ((F() & CF) << 7); break; // rr
+	case 4: c = v >> 7; r = v << 1; break;                      // sla
+	case 5: c = v & 1;  r = (v >> 1) | (v & 0x80); break;       // sra
+	case 6: c = v >> 7; r = (v << 1) | 1; break;                // sll
+	default: c = v & 1; r = v >> 1; break;                      // srl
+	}
+	setF(tables.sz53p[r] | c);
+	return r;
+}
+
+void Z80Core::bit(int b, uint8_t v, uint8_t xyFlags)
+{
+	uint8_t res = v & (1 << b);
+	setF((F() & CF) | HF | (res ? 0 : (ZF | PF)) | (res & SF) | (xyFlags & (YF | XF)));
+}
+
+int Z80Core::step()
+{
+	taken = false;
+	if (halted) {
+		// executes nops until an interrupt
+		fetchOpcode();
+		--regs.pc;
+		return timing_main[0x76].taken;
+	}
+
+	uint8_t op = fetchOpcode();
+	switch (op) {
+	case 0xCB:
+		return executeCB(fetchOpcode());
+	case 0xED:
+		return executeED(fetchOpcode());
+	case 0xDD:
+	case 0xFD: {
+		uint16_t& xy = op == 0xDD ? regs.ix : regs.iy;
+		uint8_t next = mem[regs.pc];
+		if (next == 0xDD || next == 0xFD || next == 0xED) {
+			// the prefix has no effect
+			return timing_main[0x00].taken;
+		}
+		if (next == 0xCB) {
+			fetchOpcode();
+			return executeIndexedCB(xy);
+		}
+		fetchOpcode();
+		return executeMain(next, xy, true);
+	}
+	default:
+		return executeMain(op, regs.hl, false);
+	}
+}
+
+int Z80Core::executeMain(uint8_t op, uint16_t& xy, bool indexed)
+{
+	int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+	int p = y >> 1, q = y & 1;
+
+	// address of (hl), or (ix+d) which also fetches the displacement
+	auto memAddress = [&]() -> uint16_t {
+		if (!indexed) return regs.hl;
+		uint16_t addr = xy + int8_t(fetch());
+		regs.memptr = addr;
+		return addr;
+	};
+
+	switch (x) {
+	case 0:
+		switch (z) {
+		case 0:
+			switch (y) {
+			case 0: // nop
+				break;
+			case 1: { // ex af,af'
+				uint16_t t = regs.af; regs.af = regs.af2; regs.af2 = t;
+				break;
+			}
+			case 2: { // djnz
+				int8_t d = fetch();
+				regs.bc -= 0x100;
+				if (regs.bc >> 8) {
+					regs.pc += d;
+					regs.memptr = regs.pc;
+					taken = true;
+				}
+				break;
+			}
+			default: { // jr, jr cc
+				int8_t d = fetch();
+				if (y == 3 || condition(y - 4)) {
+					regs.pc += d;
+					regs.memptr = regs.pc;
+					taken = true;
+				}
+				break;
+			}
+			}
+			break;
+		case 1:
+			if (q == 0) {
+				reg16(p, xy) = fetch16();
+			} else {
+				add16(xy, reg16(p, xy));
+			}
+			break;
+		case 2:
+			switch (y) {
+			case 0: // ld (bc),a
+				write(regs.bc, A());
+				regs.memptr = (A() << 8) | ((regs.bc + 1) & 0xFF);
+				break;
+			case 1: // ld a,(bc)
+				setA(read(regs.bc));
+				regs.memptr = regs.bc + 1;
+				break;
+			case 2: // ld (de),a
+				write(regs.de, A());
+				regs.memptr = (A() << 8) | ((regs.de + 1) & 0xFF);
+				break;
+			case 3: // ld a,(de)
+				setA(read(regs.de));
+				regs.memptr = regs.de + 1;
+				break;
+			case 4: { // ld (nn),hl
+				uint16_t addr = fetch16();
+				write16(addr, xy);
+				regs.memptr = addr + 1;
+				break;
+			}
+			case 5: { // ld hl,(nn)
+				uint16_t addr = fetch16();
+				xy = read16(addr);
+				regs.memptr = addr + 1;
+				break;
+			}
+			case 6: { // ld (nn),a
+				uint16_t addr = fetch16();
+				write(addr, A());
+				regs.memptr = (A() << 8) | ((addr + 1) & 0xFF);
+				break;
+			}
+			default: { // ld a,(nn)
+				uint16_t addr = fetch16();
+				setA(read(addr));
+				regs.memptr = addr + 1;
+				break;
+			}
+			}
+			break;
+		case 3:
+			if (q == 0) {
+				++reg16(p, xy);
+			} else {
+				--reg16(p, xy);
+			}
+			break;
+		case 4:
+		case 5:
+			if (y == 6) {
+				uint16_t addr = memAddress();
+				write(addr, z == 4 ? inc8(read(addr)) : dec8(read(addr)));
+			} else {
+				uint8_t v = reg8(y, xy);
+				setReg8(y, xy, z == 4 ? inc8(v) : dec8(v));
+			}
+			break;
+		case 6:
+			if (y == 6) {
+				uint16_t addr = memAddress();
+				write(addr, fetch());
+			} else {
+				setReg8(y, xy, fetch());
+			}
+			break;
+		default: {
+			uint8_t a = A(), f = F();
+			switch (y) {
+			case 0: // rlca
+				a = (a << 1) | (a >> 7);
+				setF((f & (SF | ZF | PF)) | (a & (YF | XF | CF)));
+				break;
+			case 1: { // rrca
+				uint8_t c = a & 1;
+				a = (a >> 1) | (a << 7);
+				setF((f & (SF | ZF | PF)) | (a & (YF | XF)) | c);
+				break;
+			}
+			case 2: { // rla
+				uint8_t c = a >> 7;
+				a = (a << 1) | (f & CF);
+				setF((f & (SF | ZF | PF)) | (a & (YF | XF)) | c);
+				break;
+			}
+			case 3: { // rra
+				uint8_t c = a & 1;
+				a = (a >> 1) | ((f & CF) << 7);
+				setF((f & (SF | ZF | PF)) | (a & (YF | XF)) | c);
+				break;
+			}
+			case 4: { // daa
+				uint8_t diff = 0, c = 0;
+				if ((f & HF) || (a & 0x0F) > 9) diff = 0x06;
+				if ((f & CF) || a > 0x99) {
+					diff |= 0x60;
+					c = CF;
+				}
+				uint8_t r = (f & NF) ? a - diff : a + diff;
+				setF(tables.sz53p[r] | c | (f & NF) | ((a ^ r) & HF));
+				a = r;
+				break;
+			}
+			case 5: // cpl
+				a = ~a;
+				setF((f & (SF | ZF | PF | CF)) | HF | NF | (a & (YF | XF)));
+				break;
+			case 6: // scf
+				setF((f & (SF | ZF | PF)) | CF | (a & (YF | XF)));
+				break;
+			default: // ccf
+				setF(((f & (SF | ZF | PF | CF)) | ((f & CF) ? HF : 0) | (a & (YF | XF))) ^ CF);
+				break;
+			}
+			setA(a);
+			break;
+		}
+		}
+		break;
+
+	case 1:
+		if (op == 0x76) {
+			halted = true;
+			--regs.pc;
+		} else if (y == 6) {
+			// ld (ix+d),r uses the real h and l
+			uint16_t addr = memAddress();
+			write(addr, reg8(z, regs.hl));
+		} else if (z == 6) {
+			uint16_t addr = memAddress();
+			setReg8(y, regs.hl, read(addr));
+		} else {
+			setReg8(y, xy, reg8(z, xy));
+		}
+		break;
+
+	case 2:
+		if (z == 6) {
+			alu(y, read(memAddress()));
+		} else {
+			alu(y, reg8(z, xy));
+		}
+		break;
+
+	default:
+		switch (z) {
+		case 0: // ret cc
+			if (condition(y)) {
+				regs.pc = regs.memptr = pop();
+				taken = true;
+			}
+			break;
+		case 1:
+			if (q == 0) {
+				if (p == 3) {
+					regs.af = pop();
+				} else {
+					reg16(p, xy) = pop();
+				}
+			} else {
+				switch (p) {
+				case 0: // ret
+					regs.pc = regs.memptr = pop();
+					break;
+				case 1: { // exx
+					uint16_t t;
+					t = regs.bc; regs.bc = regs.bc2; regs.bc2 = t;
+					t = regs.de; regs.de = regs.de2; regs.de2 = t;
+					t = regs.hl; regs.hl = regs.hl2; regs.hl2 = t;
+					break;
+				}
+				case 2: // jp (hl)
+					regs.pc = xy;
+					break;
+				default: // ld sp,hl
+					regs.sp = xy;
+					break;
+				}
+			}
+			break;
+		case 2: { // jp cc,nn
+			uint16_t addr = fetch16();
+			regs.memptr = addr;
+			if (condition(y)) regs.pc = addr;
+			break;
+		}
+		case 3:
+			switch (y) {
+			case 0: // jp nn
+				regs.pc = regs.memptr = fetch16();
+				break;
+			case 2: { // out (n),a
+				uint8_t n = fetch();
+				out((A() << 8) | n, A());
+				regs.memptr = (A() << 8) | ((n + 1) & 0xFF);
+				break;
+			}
+			case 3: { // in a,(n)
+				uint16_t port = (A() << 8) | fetch();
+				setA(in(port));
+				regs.memptr = port + 1;
+				break;
+			}
+			case 4: { // ex (sp),hl
+				uint16_t v = read16(regs.sp);
+				write16(regs.sp, xy);
+				xy = regs.memptr = v;
+				break;
+			}
+			case 5: { // ex de,hl, never indexed
+				uint16_t t = regs.de; regs.de = regs.hl; regs.hl = t;
+				break;
+			}
+			case 6: // di
+				regs.iff1 = regs.iff2 = false;
+				break;
+			case 7: // ei
+				regs.iff1 = regs.iff2 = true;
+				break;
+			default: // cb, handled by step()
+				break;
+			}
+			break;
+		case 4: { // call cc,nn
+			uint16_t addr = fetch16();
+			regs.memptr = addr;
+			if (condition(y)) {
+				push(regs.pc);
+				regs.pc = addr;
+				taken = true;
+			}
+			break;
+		}
+		case 5:
+			if (q == 0) {
+				push(p == 3 ? regs.af : reg16(p, xy));
+			} else if (p == 0) { // call nn
+				uint16_t addr = fetch16();
+				push(regs.pc);
+				regs.pc = regs.memptr = addr;
+			}
+			break;
+		case 6:
+			alu(y, fetch());
+			break;
+		default: // rst
+			push(regs.pc);
+			regs.pc = regs.memptr = y * 8;
+			break;
+		}
+		break;
+	}
+
+	if (!indexed) {
+		return taken ? timing_main[op].taken : timing_main[op].notTaken;
+	}
+	// a prefix on an instruction without hl runs as a separate nop
+	const auto& t = timing_xx[op].taken ? timing_xx[op] : timing_main[op];
+	int cycles = taken ? t.taken : t.notTaken;
+	return timing_xx[op].taken ? cycles : cycles + timing_main[0x00].taken;
+}
+
+int Z80Core::executeCB(uint8_t op)
+{
+	int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+	uint8_t v = reg8(z, regs.hl);
+	switch (x) {
+	case 0:
+		setReg8(z, regs.hl, rotate(y, v));
+		break;
+	case 1:
+		bit(y, v, z == 6 ? regs.memptr >> 8 : v);
+		break;
+	case 2:
+		setReg8(z, regs.hl, v & ~(1 << y));
+		break;
+	default:
+		setReg8(z, regs.hl, v | (1 << y));
+		break;
+	}
+	return timing_cb[op].taken;
+}
+
+int Z80Core::executeIndexedCB(uint16_t& xy)
+{
+	uint16_t addr = xy + int8_t(fetch());
+	uint8_t op = fetch(); // not an M1 cycle
+	regs.memptr = addr;
+	int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+	uint8_t v = read(addr);
+	uint8_t r;
+	switch (x) {
+	case 0:
+		r = rotate(y, v);
+		break;
+	case 1:
+		bit(y, v, addr >> 8);
+		return timing_xx_cb[(op & 0xF8) | 6].taken;
+	case 2:
+		r = v & ~(1 << y);
+		break;
+	default:
+		r = v | (1 << y);
+		break;
+	}
+	write(addr, r);
+	// undocumented: the result is also stored in a register
+	if (z != 6) setReg8(z, regs.hl, r);
+	return timing_xx_cb[(op & 0xF8) | 6].taken;
+}
+
+int Z80Core::executeED(uint8_t op)
+{
+	int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+	int p = y >> 1, q = y & 1;
+
+	if (x == 2 && z <= 3 && y >= 4) {
+		blockInstruction(y, z);
+	} else if (x == 1) {
+		switch (z) {
+		case 0: { // in r,(c)
+			uint8_t v = in(regs.bc);
+			regs.memptr = regs.bc + 1;
+			if (y != 6) setReg8(y, regs.hl, v);
+			setF((F() & CF) | tables.sz53p[v]);
+			break;
+		}
+		case 1: // out (c),r
+			out(regs.bc, y == 6 ? 0 : reg8(y, regs.hl));
+			regs.memptr = regs.bc + 1;
+			break;
+		case 2:
+			if (q == 0) {
+				sbc16(reg16(p, regs.hl));
+			} else {
+				adc16(reg16(p, regs.hl));
+			}
+			break;
+		case 3: {
+			uint16_t addr = fetch16();
+			if (q == 0) {
+				write16(addr, reg16(p, regs.hl));
+			} else {
+				reg16(p, regs.hl) = read16(addr);
+			}
+			regs.memptr = addr + 1;
+			break;
+		}
+		case 4: { // neg
+			uint8_t v = A();
+			setA(0);
+			sub8(v, 0);
+			break;
+		}
+		case 5: // retn, reti
+			regs.iff1 = regs.iff2;
+			regs.pc = regs.memptr = pop();
+			break;
+		case 6: { // im
+			static const uint8_t modes[8] = {0, 0, 1, 2, 0, 0, 1, 2};
+			regs.im = modes[y];
+			break;
+		}
+		default:
+			switch (y) {
+			case 0: // ld i,a
+				regs.i = A();
+				break;
+			case 1: // ld r,a
+				regs.r = A();
+				break;
+			case 2: // ld a,i
+				setA(regs.i);
+				setF((F() & CF) | tables.sz53[A()] | (regs.iff2 ? PF : 0));
+				break;
+			case 3: // ld a,r
+				setA(regs.r);
+				setF((F() & CF) | tables.sz53[A()] | (regs.iff2 ? PF : 0));
+				break;
+			case 4: { // rrd
+				uint8_t v = read(regs.hl);
+				write(regs.hl, (A() << 4) | (v >> 4));
+				setA((A() & 0xF0) | (v & 0x0F));
+				setF((F() & CF) | tables.sz53p[A()]);
+				regs.memptr = regs.hl + 1;
+				break;
+			}
+			case 5: { // rld
+				uint8_t v = read(regs.hl);
+				write(regs.hl, (v << 4) | (A() & 0x0F));
+				setA((A() & 0xF0) | (v >> 4));
+				setF((F() & CF) | tables.sz53p[A()]);
+				regs.memptr = regs.hl + 1;
+				break;
+			}
+			default: // nop
+				break;
+			}
+			break;
+		}
+	}
+	// the other opcodes are two byte nops
+	const auto& t = timing_ed[op];
+	if (!t.taken) return 2 * timing_main[0x00].taken;
+	return taken ? t.taken : t.notTaken;
+}
+
+void Z80Core::blockInstruction(int y, int z)
+{
+	bool decrement = y & 1;
+	bool repeat = y & 2;
+	int delta = decrement ? -1 : 1;
+
+	switch (z) {
+	case 0: { // ldi, ldd, ldir, lddr
+		uint8_t v = read(regs.hl);
+		write(regs.de, v);
+		regs.hl += delta;
+		regs.de += delta;
+		--regs.bc;
+		uint8_t n = v + A();
+		setF((F() & (SF | ZF | CF)) | (regs.bc ? PF : 0) | (n & XF) | ((n << 4) & YF));
+		if (repeat && regs.bc) {
+			regs.pc -= 2;
+			regs.memptr = regs.pc + 1;
+			taken = true;
+		}
+		break;
+	}
+	case 1: { // cpi, cpd, cpir, cpdr
+		uint8_t v = read(regs.hl);
+		uint8_t r = A() - v;
+		uint8_t h = (A() ^ v ^ r) & HF;
+		regs.hl += delta;
+		--regs.bc;
+		regs.memptr += delta;
+		uint8_t n = r - (h ? 1 : 0);
+		setF((F() & CF) | NF | h | (tables.sz53[r] & ~(YF | XF)) |
+		     (regs.bc ? PF : 0) | (n & XF) | ((n << 4) & YF));
+		if (repeat && regs.bc && r) {
+			regs.pc -= 2;
+			regs.memptr = regs.pc + 1;
+			taken = true;
+		}
+		break;
+	}
+	case 2: { // ini, ind, inir, indr
+		uint8_t v = in(regs.bc);
+		regs.memptr = regs.bc + delta;
+		write(regs.hl, v);
+		regs.hl += delta;
+		regs.bc -= 0x100;
+		uint8_t b = regs.bc >> 8;
+		unsigned k = v + ((regs.bc + delta) & 0xFF);
+		setF(tables.sz53[b] | ((v & 0x80) ? NF : 0) | (k > 0xFF ? (HF | CF) : 0) |
+		     (tables.sz53p[(k & 7) ^ b] & PF));
+		if (repeat && b) {
+			regs.pc -= 2;
+			taken = true;
+		}
+		break;
+	}
+	default: { // outi, outd, otir, otdr
+		uint8_t v = read(regs.hl);
+		regs.bc -= 0x100;
+		out(regs.bc, v);
+		regs.memptr = regs.bc + delta;
+		regs.hl += delta;
+		uint8_t b = regs.bc >> 8;
+		unsigned k = v + (regs.hl & 0xFF);
+		setF(tables.sz53[b] | ((v & 0x80) ? NF : 0) | (k > 0xFF ? (HF | CF) : 0) |
+		     (tables.sz53p[(k & 7) ^ b] & PF));
+		if (repeat && b) {
+			regs.pc -= 2;
+			taken = true;
+		}
+		break;
+	}
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef Z80CORE_H
+#define Z80CORE_H
+
+#include <functional>
+#include <stdint.h>
+
+/**
+ * Z80 interpreter on a local copy of the 64kB address space, to preview
+ * what the code at a break will do without asking openMSX. All documented
+ * and undocumented instructions are executed, including the X/Y flags and
+ * the internal MEMPTR register. Instruction times are the MSX ones, see
+ * InstructionTiming. Interrupts are not generated.
+ */
+class Z80Core
+{
+public:
+	enum Flag : uint8_t {
+		CF = 0x01, NF = 0x02, PF = 0x04, XF = 0x08,
+		HF = 0x10, YF = 0x20, ZF = 0x40, SF = 0x80
+	};
+
+	struct Registers {
+		uint16_t af, bc, de, hl;
+		uint16_t af2, bc2, de2, hl2;
+		uint16_t ix, iy, sp, pc;
+		uint16_t memptr;
+		uint8_t i, r, im;
+		bool iff1, iff2;
+	};
+
+	// 'memory' is the 64kB (plus 3 bytes slack) address space, it's not copied
+	explicit Z80Core(uint8_t* memory);
+
+	// Executes one instruction and returns its duration in T-states.
+	// A DD or FD prefix that doesn't modify the next instruction is
+	// executed on its own.
+	int step();
+
+	Registers regs = {};
+	bool halted = false;
+
+	// port I/O, reads return #FF and writes are dropped when not set
+	std::function<uint8_t(uint16_t port)> readPort;
+	std::function<void(uint16_t port, uint8_t value)> writePort;
+	// called before every memory write, return false to drop the write (e.g. ROM)
+	std::function<bool(uint16_t addr, uint8_t value)> writeFilter;
+
+private:
+	uint8_t fetch() { return mem[regs.pc++]; }
+	uint8_t fetchOpcode();
+	uint16_t fetch16();
+	uint8_t read(uint16_t addr) const { return mem[addr]; }
+	uint16_t read16(uint16_t addr) const;
+	void write(uint16_t addr, uint8_t value);
+	void write16(uint16_t addr, uint16_t value);
+	void push(uint16_t value);
+	uint16_t pop();
+	uint8_t in(uint16_t port);
+	void out(uint16_t port, uint8_t value);
+
+	uint8_t A() const { return regs.af >> 8; }
+	uint8_t F() const { return regs.af & 0xFF; }
+	void setA(uint8_t v) { regs.af = (regs.af & 0x00FF) | (v << 8); }
+	void setF(uint8_t v) { regs.af = (regs.af & 0xFF00) | v; }
+
+	// r: B C D E H L (HL) A, with H and L replaced by the index register halves
+	uint8_t reg8(int r, uint16_t& xy) const;
+	void setReg8(int r, uint16_t& xy, uint8_t v);
+	uint16_t& reg16(int p, uint16_t& xy);
+	bool condition(int cc) const;
+
+	void add8(uint8_t v, uint8_t carry);
+	void sub8(uint8_t v, uint8_t carry);
+	void cp8(uint8_t v);
+	void alu(int op, uint8_t v);
+	uint8_t inc8(uint8_t v);
+	uint8_t dec8(uint8_t v);
+	void add16(uint16_t& dest, uint16_t v);
+	void adc16(uint16_t v);
+	void sbc16(uint16_t v);
+	uint8_t rotate(int op, uint8_t v);
+	void bit(int b, uint8_t v, uint8_t xyFlags);
+
+	int executeMain(uint8_t op, uint16_t& xy, bool indexed);
+	int executeCB(uint8_t op);
+	int executeIndexedCB(uint16_t& xy);
+	int executeED(uint8_t op);
+	void blockInstruction(int y, int z);
+
+	uint8_t* mem;
+	bool taken = false; // the last conditional instruction took its branch
+};
+
+#endif // Z80CORE_H
@@ -0,0 +1,741 @@
+#include "Z80CoreCheck.h"
+#include "Z80Core.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace {
+
+// The reference model, written from "The Undocumented Z80 Documented" and
+// on purpose not sharing any table or helper with Z80Core.
+
+constexpr uint8_t CF = Z80Core::CF, NF = Z80Core::NF, PF = Z80Core::PF;
+constexpr uint8_t XF = Z80Core::XF, HF = Z80Core::HF, YF = Z80Core::YF;
+constexpr uint8_t ZF = Z80Core::ZF, SF = Z80Core::SF;
+
+uint8_t sz53(uint8_t r)
+{
+	return (r & (SF | YF | XF)) | (r ? 0 : ZF);
+}
+
+uint8_t sz53p(uint8_t r)
+{
+	int bits = 0;
+	for (int i = 0; i < 8; ++i) bits += (r >> i) & 1;
+	return sz53(r) | ((bits & 1) ? 0 : PF);
+}
+
+struct AF {
+	uint8_t a, f;
+};
+
+AF refAdd(uint8_t a, uint8_t v, int c)
+{
+	int r = a + v + c;
+	uint8_t f = sz53(uint8_t(r));
+	if ((a & 0xF) + (v & 0xF) + c > 0xF) f |= HF;
+	if (~(a ^ v) & (a ^ r) & 0x80) f |= PF;
+	if (r > 0xFF) f |= CF;
+	return {uint8_t(r), f};
+}
+
+AF refSub(uint8_t a, uint8_t v, int c)
+{
+	int r = a - v - c;
+	uint8_t f = sz53(uint8_t(r)) | NF;
+	if ((a & 0xF) < (v & 0xF) + c) f |= HF;
+	if ((a ^ v) & (a ^ r) & 0x80) f |= PF;
+	if (r < 0) f |= CF;
+	return {uint8_t(r), f};
+}
+
+AF refAlu(int op, uint8_t a, uint8_t v, int c)
+{
+	switch (op) {
+	case 0: return refAdd(a, v, 0);
+	case 1: return refAdd(a, v, c);
+	case 2: return refSub(a, v, 0);
+	case 3: return refSub(a, v, c);
+	case 4: return {uint8_t(a & v), uint8_t(sz53p(a & v) | HF)};
+	case 5: return {uint8_t(a ^ v), sz53p(a ^ v)};
+	case 6: return {uint8_t(a | v), sz53p(a | v)};
+	default: {
+		// cp takes X and Y from the operand
+		AF r = refSub(a, v, 0);
+		return {a, uint8_t((r.f & ~(YF | XF)) | (v & (YF | XF)))};
+	}
+	}
+}
+
+AF refDaa(uint8_t a, uint8_t f)
+{
+	uint8_t diff = 0;
+	uint8_t carry = 0;
+	if ((f & CF) || a > 0x99) {
+		diff = 0x60;
+		carry = CF;
+	}
+	uint8_t low = a & 0xF;
+	if ((f & HF) || low > 9) diff |= 0x06;
+	uint8_t r = (f & NF) ? uint8_t(a - diff) : uint8_t(a + diff);
+	bool half = (f & NF) ? ((f & HF) && low < 6) : low > 9;
+	return {r, uint8_t(sz53p(r) | (f & NF) | carry | (half ? HF : 0))};
+}
+
+// rlc rrc rl rr sla sra sll srl, returns the result and the new carry
+std::pair<uint8_t, int> refShift(int op, uint8_t v, int c)
+{
+	switch (op) {
+	case 0: return {uint8_t(v << 1 | v >> 7), v >> 7};
+	case 1: return {uint8_t(v >> 1 | v << 7), v & 1};
+	case 2: return {uint8_t(v << 1 | c), v >> 7};
+	case 3: return {uint8_t(v >> 1 | c << 7), v & 1};
+	case 4: return {uint8_t(v << 1), v >> 7};
+	case 5: return {uint8_t(v >> 1 | (v & 0x80)), v & 1};
+	case 6: return {uint8_t(v << 1 | 1), v >> 7};
+	default: return {uint8_t(v >> 1), v & 1};
+	}
+}
+
+uint8_t refBit(int b, uint8_t v, uint8_t f, uint8_t xy)
+{
+	uint8_t r = v & (1 << b);
+	return (f & CF) | HF | (r ? 0 : (ZF | PF)) | (r & SF) | (xy & (YF | XF));
+}
+
+struct HLF {
+	uint16_t hl;
+	uint8_t f;
+};
+
+HLF refAdd16(uint16_t hl, uint16_t v, uint8_t f)
+{
+	int r = hl + v;
+	uint8_t nf = (f & (SF | ZF | PF)) | ((r >> 8) & (YF | XF));
+	if ((hl & 0xFFF) + (v & 0xFFF) > 0xFFF) nf |= HF;
+	if (r > 0xFFFF) nf |= CF;
+	return {uint16_t(r), nf};
+}
+
+HLF refAdc16(uint16_t hl, uint16_t v, int c)
+{
+	int r = hl + v + c;
+	uint8_t f = ((r >> 8) & (SF | YF | XF)) | ((r & 0xFFFF) ? 0 : ZF);
+	if ((hl & 0xFFF) + (v & 0xFFF) + c > 0xFFF) f |= HF;
+	if (~(hl ^ v) & (hl ^ r) & 0x8000) f |= PF;
+	if (r > 0xFFFF) f |= CF;
+	return {uint16_t(r), f};
+}
+
+HLF refSbc16(uint16_t hl, uint16_t v, int c)
+{
+	int r = hl - v - c;
+	uint8_t f = ((r >> 8) & (SF | YF | XF)) | ((r & 0xFFFF) ? 0 : ZF) | NF;
+	if ((hl & 0xFFF) < (v & 0xFFF) + c) f |= HF;
+	if ((hl ^ v) & (hl ^ r) & 0x8000) f |= PF;
+	if (r < 0) f |= CF;
+	return {uint16_t(r), f};
+}
+
+// the registers of a case and the values checked after it, unused ones are 0
+using Values = std::array<uint16_t, 5>;
+
+struct Group {
+	const char* name;
+	uint32_t crc = 0xFFFFFFFF;
+	int cases = 0;
+	int failures = 0;
+};
+
+// the time an MSX takes, Z80 T-states plus one wait state per M1 cycle
+struct Timing {
+	const char* name;
+	std::array<uint8_t, 4> code;
+	uint8_t f;
+	uint16_t bc;
+	int tStates;
+};
+
+const Timing timings[] = {
+	{"nop",             {0x00},                   0,  0x0000,  5},
+	{"ld b,n",          {0x06, 0x12},             0,  0x0000,  8},
+	{"ld a,(hl)",       {0x7E},                   0,  0x0000,  8},
+	{"ld (hl),n",       {0x36, 0x12},             0,  0x0000, 11},
+	{"inc hl",          {0x23},                   0,  0x0000,  7},
+	{"inc (hl)",        {0x34},                   0,  0x0000, 12},
+	{"add a,(hl)",      {0x86},                   0,  0x0000,  8},
+	{"add hl,bc",       {0x09},                   0,  0x0000, 12},
+	{"ld a,(nn)",       {0x3A, 0x00, 0x80},       0,  0x0000, 14},
+	{"ld (nn),hl",      {0x22, 0x00, 0x80},       0,  0x0000, 17},
+	{"ld hl,(nn)",      {0x2A, 0x00, 0x80},       0,  0x0000, 17},
+	{"ld sp,hl",        {0xF9},                   0,  0x0000,  7},
+	{"ex af,af'",       {0x08},                   0,  0x0000,  5},
+	{"ex (sp),hl",      {0xE3},                   0,  0x0000, 20},
+	{"push bc",         {0xC5},                   0,  0x0000, 12},
+	{"pop bc",          {0xC1},                   0,  0x0000, 11},
+	{"jp nn",           {0xC3, 0x00, 0x02},       0,  0x0000, 11},
+	{"jp nz (taken)",   {0xC2, 0x00, 0x02},       0,  0x0000, 11},
+	{"jp nz (not)",     {0xC2, 0x00, 0x02},       ZF, 0x0000, 11},
+	{"jp (hl)",         {0xE9},                   0,  0x0000,  5},
+	{"jr e",            {0x18, 0x10},             0,  0x0000, 13},
+	{"jr nz (taken)",   {0x20, 0x10},             0,  0x0000, 13},
+	{"jr nz (not)",     {0x20, 0x10},             ZF, 0x0000,  8},
+	{"djnz (taken)",    {0x10, 0x10},             0,  0x0200, 14},
+	{"djnz (not)",      {0x10, 0x10},             0,  0x0100,  9},
+	{"call nn",         {0xCD, 0x00, 0x02},       0,  0x0000, 18},
+	{"call nz (taken)", {0xC4, 0x00, 0x02},       0,  0x0000, 18},
+	{"call nz (not)",   {0xC4, 0x00, 0x02},       ZF, 0x0000, 11},
+	{"ret",             {0xC9},                   0,  0x0000, 11},
+	{"ret nz (taken)",  {0xC0},                   0,  0x0000, 12},
+	{"ret nz (not)",    {0xC0},                   ZF, 0x0000,  6},
+	{"rst 38",          {0xFF},                   0,  0x0000, 12},
+	{"halt",            {0x76},                   0,  0x0000,  5},
+	{"out (n),a",       {0xD3, 0x98},             0,  0x0000, 12},
+	{"in a,(n)",        {0xDB, 0x99},             0,  0x0000, 12},
+	{"rlc b",           {0xCB, 0x00},             0,  0x0000, 10},
+	{"bit 0,(hl)",      {0xCB, 0x46},             0,  0x0000, 14},
+	{"set 0,(hl)",      {0xCB, 0xC6},             0,  0x0000, 17},
+	{"ld ix,nn",        {0xDD, 0x21, 0x00, 0x80}, 0,  0x0000, 16},
+	{"ld a,(ix+d)",     {0xDD, 0x7E, 0x05},       0,  0x0000, 21},
+	{"ld (ix+d),n",     {0xDD, 0x36, 0x05, 0x12}, 0,  0x0000, 21},
+	{"inc (ix+d)",      {0xDD, 0x34, 0x05},       0,  0x0000, 25},
+	{"push ix",         {0xDD, 0xE5},             0,  0x0000, 17},
+	{"pop ix",          {0xDD, 0xE1},             0,  0x0000, 16},
+	{"ex (sp),ix",      {0xDD, 0xE3},             0,  0x0000, 25},
+	{"jp (ix)",         {0xDD, 0xE9},             0,  0x0000, 10},
+	{"bit 0,(ix+d)",    {0xDD, 0xCB, 0x05, 0x46}, 0,  0x0000, 22},
+	{"set 0,(ix+d)",    {0xDD, 0xCB, 0x05, 0xC6}, 0,  0x0000, 25},
+	{"ld (nn),bc",      {0xED, 0x43, 0x00, 0x80}, 0,  0x0000, 22},
+	{"adc hl,bc",       {0xED, 0x4A},             0,  0x0000, 17},
+	{"neg",             {0xED, 0x44},             0,  0x0000, 10},
+	{"im 1",            {0xED, 0x56},             0,  0x0000, 10},
+	{"ld a,i",          {0xED, 0x57},             0,  0x0000, 11},
+	{"rld",             {0xED, 0x6F},             0,  0x0000, 20},
+	{"in a,(c)",        {0xED, 0x78},             0,  0x0000, 14},
+	{"out (c),a",       {0xED, 0x79},             0,  0x0000, 14},
+	{"ldi",             {0xED, 0xA0},             0,  0x0002, 18},
+	{"ldir (repeat)",   {0xED, 0xB0},             0,  0x0002, 23},
+	{"ldir (last)",     {0xED, 0xB0},             0,  0x0001, 18},
+	{"otir (repeat)",   {0xED, 0xB3},             0,  0x0200, 23},
+	{"otir (last)",     {0xED, 0xB3},             0,  0x0100, 18},
+};
+
+// a loop that copies and adds, with some indexed, block and call
+// instructions, to measure the speed of the core
+const uint8_t benchmark[] = {
+	0x21, 0x00, 0x80,       // #0100 ld hl,#8000
+	0x11, 0x00, 0x90,       //       ld de,#9000
+	0x01, 0x00, 0x01,       //       ld bc,#0100
+	0x7E,                   // #0109 ld a,(hl)
+	0x81,                   //       add a,c
+	0x12,                   //       ld (de),a
+	0x23,                   //       inc hl
+	0x13,                   //       inc de
+	0x0B,                   //       dec bc
+	0x78,                   //       ld a,b
+	0xB1,                   //       or c
+	0x20, 0xF6,             //       jr nz,#0109
+	0xDD, 0x21, 0x00, 0x80, //       ld ix,#8000
+	0xDD, 0xCB, 0x05, 0x06, //       rlc (ix+5)
+	0xED, 0xA0,             //       ldi
+	0xCD, 0x30, 0x01,       //       call #0130
+	0xC3, 0x00, 0x01,       //       jp #0100
+};
+const uint8_t benchmarkCall[] = {
+	0xE5,                   // #0130 push hl
+	0xD9,                   //       exx
+	0x08,                   //       ex af,af'
+	0xE1,                   //       pop hl
+	0xC9,                   //       ret
+};
+
+class Checker
+{
+public:
+	Checker() : out(stdout), memory(0x10000 + 3), core(memory.data()) {}
+	int run();
+
+private:
+	static constexpr uint16_t CODE = 0x0100;
+	static constexpr int MAX_REPORTED = 5;
+
+	Z80Core::Registers start();
+	int execute(std::initializer_list<uint8_t> code, const Z80Core::Registers& regs);
+	template<typename Describe>
+	void check(Group& g, const Values& got, const Values& expected, Describe describe);
+	void report(const Group& g);
+
+	void checkAlu();
+	void checkIncDec();
+	void checkDaa();
+	void checkAccumulator();
+	void checkShifts();
+	void checkBit();
+	void checkIndexedBit();
+	void check16();
+	void checkBlock();
+	void checkRotateDigit();
+	void checkTiming();
+	void measureSpeed();
+
+	QTextStream out;
+	std::vector<uint8_t> memory;
+	Z80Core core;
+	int totalFailures = 0;
+};
+
+Z80Core::Registers Checker::start()
+{
+	Z80Core::Registers regs = {};
+	regs.pc = CODE;
+	regs.sp = 0xF000;
+	regs.hl = 0x8000;
+	regs.de = 0x9000;
+	regs.ix = regs.iy = 0x8000;
+	return regs;
+}
+
+int Checker::execute(std::initializer_list<uint8_t> code, const Z80Core::Registers& regs)
+{
+	std::copy(code.begin(), code.end(), &memory[CODE]);
+	core.regs = regs;
+	core.halted = false;
+	return core.step();
+}
+
+template<typename Describe>
+void Checker::check(Group& g, const Values& got, const Values& expected, Describe describe)
+{
+	// CRC-32 of everything the core produced, like ZEXALL prints, so any
+	// change of the core shows up even where the model agrees
+	++g.cases;
+	for (uint16_t v : got) {
+		for (int i = 0; i < 2; ++i) {
+			g.crc ^= (v >> (8 * i)) & 0xFF;
+			for (int b = 0; b < 8; ++b) {
+				g.crc = (g.crc >> 1) ^ ((g.crc & 1) ? 0xEDB88320 : 0);
+			}
+		}
+	}
+	if (got == expected) return;
+
+	if (++g.failures <= MAX_REPORTED) {
+		auto hex = [](const Values& v) {
+			return QString::asprintf("%04X %04X %04X %04X %04X", v[0], v[1], v[2], v[3], v[4]);
+		};
+		out << "  " << g.name << ": " << describe() << ": got " << hex(got)
+		    << ", expected " << hex(expected) << '\n';
+	}
+}
+
+void Checker::report(const Group& g)
+{
+	out << QString::asprintf("%-22s %8d cases  crc %08X  ", g.name, g.cases, ~g.crc)
+	    << (g.failures ? QString::asprintf("%d FAILED", g.failures) : QString("ok")) << '\n';
+	totalFailures += g.failures;
+}
+
+void Checker::checkAlu()
+{
+	static const char* const names[] = {"add", "adc", "sub", "sbc", "and", "xor", "or", "cp"};
+	Group g{"<alu> a,n"};
+	for (int op = 0; op < 8; ++op) {
+		for (int a = 0; a < 256; ++a) {
+			for (int n = 0; n < 256; ++n) {
+				for (int c = 0; c < 2; ++c) {
+					// the other flags are set or cleared with the carry,
+					// none of them may leak into the result
+					auto regs = start();
+					regs.af = a << 8 | (c ? 0xFF : 0x00);
+					execute({uint8_t(0xC6 + 8 * op), uint8_t(n)}, regs);
+					AF r = refAlu(op, a, n, c);
+					check(g, {core.regs.af}, {uint16_t(r.a << 8 | r.f)}, [&] {
+						return QString::asprintf("%s a=%02X n=%02X c=%d", names[op], a, n, c);
+					});
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkIncDec()
+{
+	Group g{"inc/dec r"};
+	for (int r = 0; r < 8; ++r) {
+		for (int dec = 0; dec < 2; ++dec) {
+			for (int v = 0; v < 256; ++v) {
+				for (uint8_t f : {0x00, 0xFF}) {
+					auto regs = start();
+					regs.af = f;
+					uint16_t* pair[] = {&regs.bc, &regs.bc, &regs.de, &regs.de, nullptr, nullptr, nullptr, &regs.af};
+					if (r == 6) {
+						memory[regs.hl] = uint8_t(v);
+					} else if (r == 4 || r == 5) {
+						// h and l are tested through (hl), keep hl at the data
+						continue;
+					} else {
+						int shift = (r & 1) && r != 7 ? 0 : 8;
+						*pair[r] = uint16_t((*pair[r] & ~(0xFF << shift)) | v << shift);
+					}
+					execute({uint8_t(0x04 + 8 * r + dec)}, regs);
+
+					uint8_t res = dec ? uint8_t(v - 1) : uint8_t(v + 1);
+					uint8_t ef = (f & CF) | sz53(res);
+					if (dec) {
+						ef |= NF;
+						if ((v & 0xF) == 0x0) ef |= HF;
+						if (v == 0x80) ef |= PF;
+					} else {
+						if ((v & 0xF) == 0xF) ef |= HF;
+						if (v == 0x7F) ef |= PF;
+					}
+					uint16_t got = r == 6 ? memory[0x8000]
+					             : r == 7 ? core.regs.af >> 8
+					             : r & 1 ? (r == 1 ? core.regs.bc : core.regs.de) & 0xFF
+					             : (r == 0 ? core.regs.bc : core.regs.de) >> 8;
+					check(g, {got, uint16_t(core.regs.af & 0xFF)}, {res, ef}, [&] {
+						return QString::asprintf("%s r%d v=%02X f=%02X", dec ? "dec" : "inc", r, v, f);
+					});
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkDaa()
+{
+	Group g{"daa"};
+	for (int a = 0; a < 256; ++a) {
+		for (int flags = 0; flags < 8; ++flags) {
+			uint8_t f = ((flags & 1) ? CF : 0) | ((flags & 2) ? NF : 0) | ((flags & 4) ? HF : 0);
+			auto regs = start();
+			regs.af = a << 8 | f;
+			execute({0x27}, regs);
+			AF r = refDaa(a, f);
+			check(g, {core.regs.af}, {uint16_t(r.a << 8 | r.f)}, [&] {
+				return QString::asprintf("a=%02X f=%02X", a, f);
+			});
+		}
+	}
+	report(g);
+}
+
+void Checker::checkAccumulator()
+{
+	// rlca rrca rla rra cpl scf ccf neg, over all values of A and F
+	static const char* const names[] = {"rlca", "rrca", "rla", "rra", "cpl", "scf", "ccf", "neg"};
+	Group g{"<acc>"};
+	for (int op = 0; op < 8; ++op) {
+		for (int a = 0; a < 256; ++a) {
+			for (int f = 0; f < 256; ++f) {
+				auto regs = start();
+				regs.af = uint16_t(a << 8 | f);
+				uint8_t c = f & CF;
+				uint8_t keep = f & (SF | ZF | PF);
+				AF r;
+				if (op < 4) {
+					execute({uint8_t(0x07 + 8 * op)}, regs);
+					auto [res, carry] = refShift(op, a, c);
+					r = {res, uint8_t(keep | (res & (YF | XF)) | carry)};
+				} else if (op == 4) {
+					execute({0x2F}, regs);
+					uint8_t res = ~a;
+					r = {res, uint8_t(keep | c | HF | NF | (res & (YF | XF)))};
+				} else if (op == 5) {
+					execute({0x37}, regs);
+					r = {uint8_t(a), uint8_t(keep | CF | (a & (YF | XF)))};
+				} else if (op == 6) {
+					execute({0x3F}, regs);
+					r = {uint8_t(a), uint8_t(keep | (c ? HF : CF) | (a & (YF | XF)))};
+				} else {
+					execute({0xED, 0x44}, regs);
+					r = refSub(0, a, 0);
+				}
+				check(g, {core.regs.af}, {uint16_t(r.a << 8 | r.f)}, [&] {
+					return QString::asprintf("%s a=%02X f=%02X", names[op], a, f);
+				});
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkShifts()
+{
+	// on A and on (hl), the other registers use the same code
+	Group g{"<rot> r"};
+	for (int op = 0; op < 8; ++op) {
+		for (int r : {6, 7}) {
+			for (int v = 0; v < 256; ++v) {
+				for (int c = 0; c < 2; ++c) {
+					auto regs = start();
+					regs.af = r == 7 ? uint16_t(v << 8 | c) : uint16_t(0x5500 | c);
+					memory[regs.hl] = uint8_t(v);
+					execute({0xCB, uint8_t(8 * op + r)}, regs);
+					auto [res, carry] = refShift(op, v, c);
+					uint16_t got = r == 7 ? core.regs.af >> 8 : memory[0x8000];
+					check(g, {got, uint16_t(core.regs.af & 0xFF)}, {res, uint8_t(sz53p(res) | carry)}, [&] {
+						return QString::asprintf("cb %02X v=%02X c=%d", 8 * op + r, v, c);
+					});
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkBit()
+{
+	Group g{"bit n,r"};
+	for (int b = 0; b < 8; ++b) {
+		for (int v = 0; v < 256; ++v) {
+			for (uint8_t f : {0x00, 0xFF}) {
+				// bit n,b and bit n,a, X and Y come from the register
+				auto regs = start();
+				regs.af = uint16_t(v << 8 | f);
+				regs.bc = uint16_t(v << 8);
+				for (int r : {0, 7}) {
+					execute({0xCB, uint8_t(0x40 + 8 * b + r)}, regs);
+					check(g, {core.regs.af}, {uint16_t(v << 8 | refBit(b, v, f, v))}, [&] {
+						return QString::asprintf("bit %d,r%d v=%02X f=%02X", b, r, v, f);
+					});
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkIndexedBit()
+{
+	// X and Y of bit n,(ix+d) come from the high byte of the address, and
+	// res/set n,(ix+d),r also copy the result to r
+	Group g{"bit/res/set n,(ix+d)"};
+	for (uint16_t ix : {0x0000, 0x12F0, 0x7FFF, 0xFF80}) {
+		for (uint8_t d : {0x00, 0x7F, 0x80, 0xFF}) {
+			uint16_t addr = uint16_t(ix + int8_t(d));
+			for (int b = 0; b < 8; ++b) {
+				for (int v = 0; v < 256; ++v) {
+					auto regs = start();
+					regs.ix = ix;
+					regs.af = 0x0001;
+					memory[addr] = uint8_t(v);
+					execute({0xDD, 0xCB, d, uint8_t(0x46 + 8 * b)}, regs);
+					check(g, {core.regs.af}, {refBit(b, v, 0x01, addr >> 8)}, [&] {
+						return QString::asprintf("bit %d,(%04X) v=%02X", b, addr, v);
+					});
+
+					for (int set = 0; set < 2; ++set) {
+						memory[addr] = uint8_t(v);
+						execute({0xDD, 0xCB, d, uint8_t((set ? 0xC0 : 0x80) + 8 * b + 0)}, regs);
+						uint8_t res = set ? uint8_t(v | 1 << b) : uint8_t(v & ~(1 << b));
+						check(g, {memory[addr], uint16_t(core.regs.bc >> 8), core.regs.af},
+						      {res, res, 0x0001}, [&] {
+							return QString::asprintf("%s %d,(%04X),b v=%02X", set ? "set" : "res", b, addr, v);
+						});
+					}
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::check16()
+{
+	// a linear congruential sequence over the operands, plus the edges
+	Group g{"add/adc/sbc hl,ss"};
+	uint32_t seed = 1;
+	auto next = [&] {
+		seed = seed * 1103515245 + 12345;
+		return uint16_t(seed >> 12);
+	};
+	for (int i = 0; i < 0x20000; ++i) {
+		uint16_t hl = i < 4 ? uint16_t(i & 1 ? 0xFFFF : 0x0000) : next();
+		uint16_t v = i < 4 ? uint16_t(i & 2 ? 0x0001 : 0x8000) : next();
+		int c = i & 1;
+		uint8_t f = c ? 0xFF : 0x00;
+
+		auto regs = start();
+		regs.af = f;
+		regs.hl = hl;
+		regs.bc = v;
+		execute({0x09}, regs);
+		HLF r = refAdd16(hl, v, f);
+		check(g, {core.regs.hl, uint16_t(core.regs.af & 0xFF)}, {r.hl, r.f}, [&] {
+			return QString::asprintf("add hl=%04X bc=%04X f=%02X", hl, v, f);
+		});
+
+		regs.ix = hl;
+		regs.hl = 0x8000;
+		execute({0xDD, 0x09}, regs);
+		check(g, {core.regs.ix, uint16_t(core.regs.af & 0xFF)}, {r.hl, r.f}, [&] {
+			return QString::asprintf("add ix=%04X bc=%04X f=%02X", hl, v, f);
+		});
+
+		regs.hl = hl;
+		execute({0xED, 0x4A}, regs);
+		r = refAdc16(hl, v, c);
+		check(g, {core.regs.hl, uint16_t(core.regs.af & 0xFF)}, {r.hl, r.f}, [&] {
+			return QString::asprintf("adc hl=%04X bc=%04X c=%d", hl, v, c);
+		});
+
+		execute({0xED, 0x42}, regs);
+		r = refSbc16(hl, v, c);
+		check(g, {core.regs.hl, uint16_t(core.regs.af & 0xFF)}, {r.hl, r.f}, [&] {
+			return QString::asprintf("sbc hl=%04X bc=%04X c=%d", hl, v, c);
+		});
+	}
+	report(g);
+}
+
+void Checker::checkBlock()
+{
+	// ldi ldd cpi cpd, X and Y come from bits 3 and 1 of a value made
+	// from A and the byte
+	Group g{"ldi/ldd/cpi/cpd"};
+	for (int op = 0; op < 4; ++op) {
+		bool compare = op >= 2;
+		int dir = (op & 1) ? -1 : 1;
+		for (int a = 0; a < 256; ++a) {
+			for (int v = 0; v < 256; ++v) {
+				for (uint16_t bc : {0x0001, 0x0002}) {
+					uint8_t f = bc == 1 ? 0xFF : 0x00;
+					auto regs = start();
+					regs.af = uint16_t(a << 8 | f);
+					regs.bc = bc;
+					memory[regs.hl] = uint8_t(v);
+					memory[regs.de] = 0;
+					execute({0xED, uint8_t(0xA0 + 8 * (op & 1) + (compare ? 1 : 0))}, regs);
+
+					Values expected = {};
+					expected[1] = uint16_t(bc - 1);
+					expected[2] = uint16_t(0x8000 + dir);
+					uint8_t pv = bc != 1 ? PF : 0;
+					if (compare) {
+						uint8_t res = uint8_t(a - v);
+						bool half = (a & 0xF) < (v & 0xF);
+						uint8_t n = uint8_t(res - (half ? 1 : 0));
+						uint8_t ef = (f & CF) | NF | (res & SF) | (res ? 0 : ZF) |
+						             (half ? HF : 0) | pv | (n & XF) | ((n & 0x02) ? YF : 0);
+						expected[0] = uint16_t(a << 8 | ef);
+						expected[3] = 0x9000;
+					} else {
+						uint8_t n = uint8_t(a + v);
+						uint8_t ef = (f & (SF | ZF | CF)) | pv | (n & XF) | ((n & 0x02) ? YF : 0);
+						expected[0] = uint16_t(a << 8 | ef);
+						expected[3] = uint16_t(0x9000 + dir);
+						expected[4] = uint16_t(v);
+					}
+					Values got = {core.regs.af, core.regs.bc, core.regs.hl, core.regs.de,
+					              compare ? uint16_t(0) : uint16_t(memory[0x9000])};
+					check(g, got, expected, [&] {
+						return QString::asprintf("ed %02X a=%02X v=%02X bc=%04X",
+						                         0xA0 + 8 * (op & 1) + (compare ? 1 : 0), a, v, bc);
+					});
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkRotateDigit()
+{
+	Group g{"rld/rrd"};
+	for (int rrd = 0; rrd < 2; ++rrd) {
+		for (int a = 0; a < 256; ++a) {
+			for (int v = 0; v < 256; ++v) {
+				for (uint8_t f : {0x00, 0xFF}) {
+					auto regs = start();
+					regs.af = uint16_t(a << 8 | f);
+					memory[regs.hl] = uint8_t(v);
+					execute({0xED, uint8_t(rrd ? 0x67 : 0x6F)}, regs);
+					uint8_t mem = rrd ? uint8_t(a << 4 | v >> 4) : uint8_t(v << 4 | (a & 0xF));
+					uint8_t ra = rrd ? uint8_t((a & 0xF0) | (v & 0xF)) : uint8_t((a & 0xF0) | v >> 4);
+					check(g, {core.regs.af, memory[0x8000]},
+					      {uint16_t(ra << 8 | (f & CF) | sz53p(ra)), mem}, [&] {
+						return QString::asprintf("%s a=%02X v=%02X f=%02X", rrd ? "rrd" : "rld", a, v, f);
+					});
+				}
+			}
+		}
+	}
+	report(g);
+}
+
+void Checker::checkTiming()
+{
+	int failures = 0;
+	for (const auto& t : timings) {
+		auto regs = start();
+		regs.af = t.f;
+		regs.bc = t.bc;
+		std::copy(t.code.begin(), t.code.end(), &memory[CODE]);
+		core.regs = regs;
+		core.halted = false;
+		int got = core.step();
+		if (got != t.tStates) {
+			out << "  timing: " << t.name << ": got " << got << ", expected " << t.tStates << '\n';
+			++failures;
+		}
+	}
+	int total = int(sizeof(timings) / sizeof(timings[0]));
+	out << QString::asprintf("%-22s %8d cases                  ", "MSX T-states", total)
+	    << (failures ? QString::asprintf("%d FAILED", failures) : QString("ok")) << '\n';
+	totalFailures += failures;
+}
+
+void Checker::measureSpeed()
+{
+	std::fill(memory.begin(), memory.end(), 0);
+	std::copy(std::begin(benchmark), std::end(benchmark), &memory[CODE]);
+	std::copy(std::begin(benchmarkCall), std::end(benchmarkCall), &memory[0x0130]);
+	core.regs = start();
+	core.halted = false;
+
+	const int instructions = 50000000;
+	uint64_t tStates = 0;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < instructions; ++i) {
+		tStates += core.step();
+	}
+	double seconds = std::max<qint64>(timer.nsecsElapsed(), 1) * 1e-9;
+
+	out << QString::asprintf("speed: %d instructions in %.0f ms, %.1f MIPS, "
+	                         "%.0f times a 3.58 MHz MSX\n",
+	                         instructions, seconds * 1000, instructions / seconds * 1e-6,
+	                         tStates / seconds / 3579545);
+}
+
+int Checker::run()
+{
+	checkAlu();
+	checkIncDec();
+	checkDaa();
+	checkAccumulator();
+	checkShifts();
+	checkBit();
+	checkIndexedBit();
+	check16();
+	checkBlock();
+	checkRotateDigit();
+	checkTiming();
+	measureSpeed();
+	out << (totalFailures ? "FAILED\n" : "all ok\n");
+	return totalFailures ? 1 : 0;
+}
+
+} // namespace
+
+int checkZ80Core()
+{
+	Checker checker;
+	return checker.run();
+}
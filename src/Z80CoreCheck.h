@@ -0,0 +1,14 @@
+#ifndef Z80CORECHECK_H
+#define Z80CORECHECK_H
+
+/**
+ * Batch mode, validates Z80Core in the way ZEXALL does: every instruction
+ * group is run over all (or many) operand and flag combinations, compared
+ * against an independent model of the documented and undocumented flags,
+ * and summarized by a CRC-32. Then the MSX T-states of a table of
+ * instructions are checked and the speed of the core is measured in MIPS.
+ * Writes a report to stdout and returns the exit code.
+ */
+int checkZ80Core();
+
+#endif // Z80CORECHECK_H
@@ -1,10 +1,33 @@
 #include "DebuggerForm.h"
+#include "BuildCompare.h"
+#include "Z80CoreCheck.h"
+#include "SymbolFileBenchmark.h"
+#include "DasmBenchmark.h"
 #include "Settings.h"
 #include <QApplication>
 #include <QIcon>
+#include <cstring>
 
 int main(int argc, char** argv)
 {
+	// batch mode, without a window
+	if (argc > 1 && std::strcmp(argv[1], "--compare") == 0) {
+		QCoreApplication app(argc, argv);
+		return compareBuilds(app.arguments().mid(2));
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--check-z80") == 0) {
+		QCoreApplication app(argc, argv);
+		return checkZ80Core();
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark-parsers") == 0) {
+		QCoreApplication app(argc, argv);
+		return benchmarkSymbolParsers(app.arguments().mid(2));
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark-dasm") == 0) {
+		QCoreApplication app(argc, argv);
+		return benchmarkDasm(app.arguments().mid(2));
+	}
+
 	QApplication app(argc, argv);
 // Don't set the icon on OS X, because it will replace the high-res version
 // with a lower resolution one, even though openMSX-debugger-logo-256.png is 256x256.
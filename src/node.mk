@@ -12,11 +12,16 @@ MOC_SRC_HDR:= \
 	VDPDataStore VDPStatusRegViewer VDPRegViewer InteractiveLabel \
 	InteractiveButton VDPCommandRegViewer GotoDialog SymbolTable \
 	TileViewer VramTiledView PaletteDialog VramSpriteView SpriteViewer \
-	BreakpointViewer
+	BreakpointViewer ExportDisasmDialog OpenImageDialog DisasmSearchViewer \
+	ExecutionPreviewDialog CodeAnalyzer PeepholeViewer \
+	VramTimingViewer SymbolCompleter SourceViewer TraceLog TraceViewer
 
 SRC_HDR:= \
 	DockManager Dasm DasmTables DebuggerData SymbolTable Convert Version \
-	CPURegs SimpleHexRequest
+	CPURegs SimpleHexRequest DisasmExport OfflineImage DisasmSearch \
+	Z80Core Z80CoreCheck CallGraph LoopAnalysis PeepholeAdvisor VramTiming \
+	MemoryDiff BuildCompare SymbolFileParser SymbolNameIndex SymbolFileCache \
+	SourceLineIndex WriteLog SymbolFileBenchmark DasmBenchmark
 
 SRC_ONLY:= \
 	main
@@ -25,6 +30,6 @@ UI:= \
 	ConnectDialog SymbolManager PreferencesDialog BreakpointDialog \
 	CommandDialog BitMapViewer VDPStatusRegisters VDPRegViewer \
 	VDPCommandRegisters GotoDialog TileViewer PaletteDialog SpriteViewer \
-	BreakpointViewer
+	BreakpointViewer ExportDisasmDialog OpenImageDialog ExecutionPreviewDialog
 
 include build/node-end.mk